@@ -43,7 +43,12 @@ public class PrettyPostProcess : ModuleRules
 				"Engine",
 				"DeveloperSettings",
 				"Slate",
-				"SlateCore"
+				"SlateCore",
+				// Benchmark commandlet (captured inputs, JSON report)
+				"ImageCore",
+				"Json",
+				// Data asset snapshot of the captures
+				"JsonUtilities"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,78 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessAutoSkip.h"
+
+namespace
+{
+    // Readbacks in a row under the threshold before skipping a stage
+    constexpr int32 FramesBeforeSkip = 8;
+
+    // A frame only counts as dark under this fraction of the threshold,
+    // leaving room for the scene to brighten during the readback latency.
+    constexpr float DarkThresholdScale = 0.5f;
+}
+
+FPostProcessSkipState FPostProcessAutoSkip::Update(uint32 ViewKey, float FlareThreshold, float GlareThreshold)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    FViewReadbacks::FView& View = Views.FindOrAdd(ViewKey);
+    FViewState& State = View.Data;
+
+    FViewReadbacks::ReadCompleted(View, [&](FViewReadbacks::FReadback& Readback)
+        {
+            const float TileMax = ReadTileMax(Readback);
+
+            State.DarkFramesFlare = TileMax <= FlareThreshold * DarkThresholdScale ? State.DarkFramesFlare + 1 : 0;
+            State.DarkFramesGlare = TileMax <= GlareThreshold * DarkThresholdScale ? State.DarkFramesGlare + 1 : 0;
+        });
+
+    FPostProcessSkipState SkipState;
+    SkipState.bSkipFlare = State.DarkFramesFlare >= FramesBeforeSkip;
+    SkipState.bSkipGlare = State.DarkFramesGlare >= FramesBeforeSkip;
+    return SkipState;
+}
+
+void FPostProcessAutoSkip::AddReadback(FRDGBuilder& GraphBuilder, uint32 ViewKey, FRDGTextureRef TileMaxTexture, const FIntPoint& TileCount)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    if (FViewReadbacks::FView* View = Views.Find(ViewKey))
+    {
+        FViewReadbacks::AddReadback(GraphBuilder, *View, TileMaxTexture, TileCount, TEXT("PrettyPostProcess.TileMaxReadback"));
+    }
+}
+
+void FPostProcessAutoSkip::Reset()
+{
+    FScopeLock Lock(&CriticalSection);
+
+    Views.Reset();
+}
+
+float FPostProcessAutoSkip::ReadTileMax(FViewReadbacks::FReadback& Readback)
+{
+    int32 RowPitchInPixels = 0;
+    const uint32* Tiles = static_cast<const uint32*>(Readback.Readback->Lock(RowPitchInPixels));
+
+    // A copy that couldn't be read never lets a stage be skipped
+    if (Tiles == nullptr)
+    {
+        return MAX_flt;
+    }
+
+    // Luminance is never negative, so its bits sort like the float
+    uint32 TileMax = 0;
+
+    for (int32 y = 0; y < Readback.Size.Y; y++)
+    {
+        for (int32 x = 0; x < Readback.Size.X; x++)
+        {
+            TileMax = FMath::Max(TileMax, Tiles[y * RowPitchInPixels + x]);
+        }
+    }
+
+    Readback.Readback->Unlock();
+
+    return FMath::Max(0.0f, *reinterpret_cast<const float*>(&TileMax));
+}
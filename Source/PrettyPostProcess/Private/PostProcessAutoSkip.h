@@ -0,0 +1,49 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphBuilder.h"
+#include "PostProcessViewReadbacks.h"
+
+// Stages a view can go without this frame
+struct FPostProcessSkipState
+{
+    bool bSkipFlare = false;
+    bool bSkipGlare = false;
+};
+
+// Skips the flare and glare of the views with nothing bright enough to
+// produce them (interiors, menus). The tile max map of each view is copied
+// back and read a few frames later, without ever waiting on the GPU. A
+// stage is only skipped after a number of frames in a row well under its
+// threshold, and comes back as soon as a frame goes over it. Render
+// thread only, views recorded in parallel are serialized by the lock.
+class FPostProcessAutoSkip
+{
+public:
+    // Consume the readbacks of a view that are done and return what it can skip
+    FPostProcessSkipState Update(uint32 ViewKey, float FlareThreshold, float GlareThreshold);
+
+    // Copy back the tile max map of a view (TileCount tiles are valid),
+    // unless all its readbacks are still in flight.
+    void AddReadback(FRDGBuilder& GraphBuilder, uint32 ViewKey, FRDGTextureRef TileMaxTexture, const FIntPoint& TileCount);
+
+    // Drop every view and pending readback
+    void Reset();
+
+private:
+    struct FViewState
+    {
+        // Readbacks in a row under the threshold of each stage
+        int32 DarkFramesFlare = 0;
+        int32 DarkFramesGlare = 0;
+    };
+
+    using FViewReadbacks = TPostProcessViewReadbacks<FViewState>;
+
+    static float ReadTileMax(FViewReadbacks::FReadback& Readback);
+
+    FViewReadbacks Views;
+    FCriticalSection CriticalSection;
+};
@@ -0,0 +1,663 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessBenchmarkCommandlet.h"
+#include "PostProcessCapture.h"
+#include "PostProcessDataAsset.h"
+#include "PostProcessSubsystem.h"
+#include "PrettyPostProcess.h"
+#include "PrettyPostProcessCPU.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Dom/JsonObject.h"
+#include "ImageCore.h"
+#include "ImageUtils.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace
+{
+    namespace CPU = PrettyPostProcessCPU;
+
+    // Bumped when the layout of the report changes
+    constexpr int32 BenchmarkSchemaVersion = 1;
+
+    // Image the pipeline is run on, at the resolution of a run
+    struct FBenchmarkInput
+    {
+        FString Name;
+
+        // Builds the scene color at a given size
+        TFunction<void(CPU::FImage&)> Fill;
+    };
+
+    // A parameter swept at the sweep resolution, one run per value
+    struct FBenchmarkSweep
+    {
+        const TCHAR* Name;
+        TArray<int32> Values;
+        TFunction<void(int32, CPU::FSettings&, CPU::FPipelineOptions&)> Apply;
+    };
+
+    // Stage timings of a run, aggregated over the iterations
+    struct FStageResult
+    {
+        CPU::FStageStats Stats;
+        TArray<double> Milliseconds;
+    };
+
+    bool ParseResolution(const FString& Name, FIntPoint& OutSize)
+    {
+        static const TPair<const TCHAR*, FIntPoint> NamedResolutions[] =
+        {
+            { TEXT("1080p"), FIntPoint(1920, 1080) },
+            { TEXT("1440p"), FIntPoint(2560, 1440) },
+            { TEXT("4K"), FIntPoint(3840, 2160) },
+            { TEXT("8K"), FIntPoint(7680, 4320) }
+        };
+
+        for (const TPair<const TCHAR*, FIntPoint>& Resolution : NamedResolutions)
+        {
+            if (Name.Equals(Resolution.Key, ESearchCase::IgnoreCase))
+            {
+                OutSize = Resolution.Value;
+                return true;
+            }
+        }
+
+        // WidthxHeight
+        FString Width;
+        FString Height;
+
+        if (Name.Split(TEXT("x"), &Width, &Height, ESearchCase::IgnoreCase) && Width.IsNumeric() && Height.IsNumeric())
+        {
+            OutSize = FIntPoint(FCString::Atoi(*Width), FCString::Atoi(*Height));
+            return OutSize.X > 0 && OutSize.Y > 0;
+        }
+
+        return false;
+    }
+
+    // Add discs of light over an image (UV positions and radius relative
+    // to the height, so the content scales with the resolution)
+    void AddLights(CPU::FImage& Image, int32 Count, float MinRadius, float MaxRadius, float MinIntensity, float MaxIntensity, int32 Seed)
+    {
+        struct FLight
+        {
+            FVector2f Position;
+            float Radius;
+            FLinearColor Color;
+        };
+
+        FRandomStream Random(Seed);
+        TArray<FLight> Lights;
+
+        for (int32 i = 0; i < Count; i++)
+        {
+            FLight& Light = Lights.AddDefaulted_GetRef();
+            Light.Position = FVector2f(Random.FRand() * Image.Width, Random.FRand() * Image.Height);
+            Light.Radius = Random.FRandRange(MinRadius, MaxRadius) * Image.Height;
+            Light.Color = FLinearColor(Random.FRandRange(0.6f, 1.0f), Random.FRandRange(0.6f, 1.0f), Random.FRandRange(0.6f, 1.0f))
+                * Random.FRandRange(MinIntensity, MaxIntensity);
+        }
+
+        ParallelFor(Image.Height, [&](int32 Y)
+        {
+            for (const FLight& Light : Lights)
+            {
+                const float DeltaY = float(Y) + 0.5f - Light.Position.Y;
+
+                if (FMath::Abs(DeltaY) > Light.Radius)
+                {
+                    continue;
+                }
+
+                const int32 MinX = FMath::Max(FMath::FloorToInt(Light.Position.X - Light.Radius), 0);
+                const int32 MaxX = FMath::Min(FMath::CeilToInt(Light.Position.X + Light.Radius), Image.Width - 1);
+
+                for (int32 X = MinX; X <= MaxX; X++)
+                {
+                    const float DeltaX = float(X) + 0.5f - Light.Position.X;
+
+                    if (DeltaX * DeltaX + DeltaY * DeltaY <= Light.Radius * Light.Radius)
+                    {
+                        Image.SetPixel(X, Y, Image.GetPixel(X, Y) + Light.Color);
+                    }
+                }
+            }
+        });
+    }
+
+    void FillConstant(CPU::FImage& Image, const FLinearColor& Color)
+    {
+        ParallelFor(Image.Height, [&](int32 Y)
+        {
+            for (int32 X = 0; X < Image.Width; X++)
+            {
+                Image.SetPixel(X, Y, Color);
+            }
+        });
+    }
+
+    // Synthetic HDR scenes covering the cheap and expensive cases
+    void AddSyntheticInputs(TArray<FBenchmarkInput>& Inputs)
+    {
+        // Night scene: dark background with small bright lights (ghosts,
+        // a few glare sprites)
+        Inputs.Add({ TEXT("Synthetic_Lights"), [](CPU::FImage& Image)
+        {
+            FillConstant(Image, FLinearColor(0.01f, 0.012f, 0.02f));
+            AddLights(Image, 64, 0.002f, 0.01f, 10.0f, 100.0f, 1);
+        }});
+
+        // Daylight: bright sky over a darker ground with a sun (bright
+        // tiles everywhere, worst case for the glare)
+        Inputs.Add({ TEXT("Synthetic_Sky"), [](CPU::FImage& Image)
+        {
+            ParallelFor(Image.Height, [&](int32 Y)
+            {
+                const float V = (float(Y) + 0.5f) / float(Image.Height);
+
+                const FLinearColor Color = V < 0.5f
+                    ? FMath::Lerp(FLinearColor(2.0f, 3.0f, 6.0f), FLinearColor(6.0f, 6.0f, 5.0f), V * 2.0f)
+                    : FLinearColor(0.05f, 0.05f, 0.04f);
+
+                for (int32 X = 0; X < Image.Width; X++)
+                {
+                    Image.SetPixel(X, Y, Color);
+                }
+            });
+
+            AddLights(Image, 1, 0.03f, 0.03f, 500.0f, 500.0f, 2);
+        }});
+
+        // Nothing bright enough to produce a glare sprite
+        Inputs.Add({ TEXT("Synthetic_Dark"), [](CPU::FImage& Image)
+        {
+            FillConstant(Image, FLinearColor(0.01f, 0.01f, 0.01f));
+        }});
+    }
+
+    // HDR captures (EXR, HDR, ... or r.PrettyPostProcess.Capture files)
+    // resampled to the resolution of each run
+    bool AddCapturedInput(const FString& Filename, TArray<FBenchmarkInput>& Inputs)
+    {
+        if (FPaths::GetExtension(Filename) == FPostProcessCapture::Extension)
+        {
+            const TUniquePtr<FPostProcessCapture> Capture = FPostProcessCapture::Load(Filename);
+
+            if (!Capture.IsValid())
+            {
+                return false;
+            }
+
+            TSharedRef<CPU::FImage> Source = MakeShared<CPU::FImage>();
+            Capture->GetSceneColor(*Source);
+
+            Inputs.Add({ FPaths::GetBaseFilename(Filename), [Source](CPU::FImage& Image)
+            {
+                CPU::Resample(*Source, Image);
+            }});
+
+            return true;
+        }
+
+        FImage Loaded;
+
+        if (!FImageUtils::LoadImage(*Filename, Loaded))
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Benchmark: can't load '%s'"), *Filename);
+            return false;
+        }
+
+        Loaded.ChangeFormat(ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+        TSharedRef<CPU::FImage> Source = MakeShared<CPU::FImage>(Loaded.SizeX, Loaded.SizeY);
+        const TArrayView64<FLinearColor> Pixels = Loaded.AsRGBA32F();
+
+        for (int32 Y = 0; Y < Loaded.SizeY; Y++)
+        {
+            for (int32 X = 0; X < Loaded.SizeX; X++)
+            {
+                Source->SetPixel(X, Y, Pixels[int64(Y) * Loaded.SizeX + X]);
+            }
+        }
+
+        Inputs.Add({ FPaths::GetBaseFilename(Filename), [Source](CPU::FImage& Image)
+        {
+            CPU::Resample(*Source, Image);
+        }});
+
+        return true;
+    }
+
+    // Output of a replay, to compare with the game (EXR)
+    bool SaveImage(const CPU::FImage& Image, const FString& Filename)
+    {
+        FImage Saved(Image.Width, Image.Height, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+        const TArrayView64<FLinearColor> Pixels = Saved.AsRGBA32F();
+
+        for (int32 Y = 0; Y < Image.Height; Y++)
+        {
+            for (int32 X = 0; X < Image.Width; X++)
+            {
+                FLinearColor Color = Image.GetPixel(X, Y);
+                Color.A = 1.0f;
+                Pixels[int64(Y) * Image.Width + X] = Color;
+            }
+        }
+
+        return FImageUtils::SaveImageByExtension(*Filename, Saved);
+    }
+
+    double GetMedian(TArray<double> Values)
+    {
+        if (Values.Num() == 0)
+        {
+            return 0.0;
+        }
+
+        Values.Sort();
+        const int32 Middle = Values.Num() / 2;
+        return Values.Num() % 2 == 1 ? Values[Middle] : (Values[Middle - 1] + Values[Middle]) * 0.5;
+    }
+
+    double GetMin(const TArray<double>& Values)
+    {
+        return Values.Num() > 0 ? FMath::Min(Values) : 0.0;
+    }
+
+    TArray<TSharedPtr<FJsonValue>> MakeJsonSize(const FIntPoint& Size)
+    {
+        return { MakeShared<FJsonValueNumber>(Size.X), MakeShared<FJsonValueNumber>(Size.Y) };
+    }
+
+    // Render an input a few times (after a warm-up run) and report it
+    TSharedRef<FJsonObject> RunBenchmark(
+        const FBenchmarkInput& Input,
+        const FString& ResolutionName,
+        const FIntPoint& ViewSize,
+        const CPU::FSettings& Settings,
+        const CPU::FPipelineOptions& Options,
+        int32 BytesPerPixel,
+        int32 Iterations,
+        CPU::FPipelineOutput* OutOutput = nullptr,
+        const FIntPoint& InputSize = FIntPoint::ZeroValue
+    )
+    {
+        // The engine hands over half resolution scene color (smaller with
+        // dynamic resolution, hence the input size of the replays)
+        CPU::FImage SceneColor(FMath::DivideAndRoundUp(ViewSize.X, 2), FMath::DivideAndRoundUp(ViewSize.Y, 2));
+
+        if (InputSize.X > 0 && InputSize.Y > 0)
+        {
+            SceneColor.Init(InputSize.X, InputSize.Y);
+        }
+
+        Input.Fill(SceneColor);
+
+        CPU::FPipelineOptions RunOptions = Options;
+        RunOptions.ViewSize = ViewSize;
+
+        CPU::FPipelineOutput Output;
+        CPU::FPipelineStats Stats;
+        TArray<FStageResult> Stages;
+        TArray<double> TotalMilliseconds;
+
+        for (int32 Iteration = -1; Iteration < Iterations; Iteration++)
+        {
+            CPU::Render(SceneColor, Settings, RunOptions, Output, &Stats);
+
+            // Warm-up (first touch of the allocations)
+            if (Iteration < 0)
+            {
+                continue;
+            }
+
+            // The same settings always go through the same stages
+            if (Stages.Num() == 0)
+            {
+                for (const CPU::FStageStats& Stage : Stats.Stages)
+                {
+                    Stages.AddDefaulted_GetRef().Stats = Stage;
+                }
+            }
+
+            double Total = 0.0;
+
+            for (int32 i = 0; i < FMath::Min(Stages.Num(), Stats.Stages.Num()); i++)
+            {
+                Stages[i].Milliseconds.Add(Stats.Stages[i].Milliseconds);
+                Total += Stats.Stages[i].Milliseconds;
+            }
+
+            TotalMilliseconds.Add(Total);
+        }
+
+        TArray<TSharedPtr<FJsonValue>> JsonStages;
+        int64 TotalBytes = 0;
+        int64 TotalFetches = 0;
+
+        for (const FStageResult& Stage : Stages)
+        {
+            // Intermediate buffer in the GPU format, the glare is a full
+            // target even though only its quads are written
+            const int64 Bytes = int64(Stage.Stats.OutputSize.X) * Stage.Stats.OutputSize.Y * BytesPerPixel;
+
+            TSharedRef<FJsonObject> JsonStage = MakeShared<FJsonObject>();
+            JsonStage->SetStringField(TEXT("name"), Stage.Stats.Name);
+            JsonStage->SetNumberField(TEXT("ms"), GetMedian(Stage.Milliseconds));
+            JsonStage->SetNumberField(TEXT("minMs"), GetMin(Stage.Milliseconds));
+            JsonStage->SetArrayField(TEXT("size"), MakeJsonSize(Stage.Stats.OutputSize));
+            JsonStage->SetNumberField(TEXT("pixels"), double(Stage.Stats.Pixels));
+            JsonStage->SetNumberField(TEXT("fetches"), double(Stage.Stats.Fetches));
+            JsonStage->SetNumberField(TEXT("texels"), double(Stage.Stats.Fetches * 4));
+            JsonStage->SetNumberField(TEXT("primitives"), double(Stage.Stats.Primitives));
+            JsonStage->SetNumberField(TEXT("bytes"), double(Bytes));
+            JsonStages.Add(MakeShared<FJsonValueObject>(JsonStage));
+
+            TotalBytes += Bytes;
+            TotalFetches += Stage.Stats.Fetches;
+        }
+
+        TSharedRef<FJsonObject> JsonOptions = MakeShared<FJsonObject>();
+        JsonOptions->SetNumberField(TEXT("passAmount"), Output.PassAmount);
+        JsonOptions->SetNumberField(TEXT("blurSteps"), FMath::Min(Settings.BlurSteps, RunOptions.MaxBlurSteps));
+        JsonOptions->SetNumberField(TEXT("ghostCount"), FMath::Min(Settings.GhostColors.Num(), RunOptions.MaxGhostCount));
+        JsonOptions->SetNumberField(TEXT("glareTileSize"), RunOptions.GlareTileSize);
+        JsonOptions->SetNumberField(TEXT("flareMip"), RunOptions.FlareMip);
+
+        TSharedRef<FJsonObject> JsonRun = MakeShared<FJsonObject>();
+        JsonRun->SetStringField(TEXT("input"), Input.Name);
+        JsonRun->SetStringField(TEXT("resolution"), ResolutionName);
+        JsonRun->SetArrayField(TEXT("viewSize"), MakeJsonSize(ViewSize));
+        JsonRun->SetArrayField(TEXT("inputSize"), MakeJsonSize(SceneColor.GetSize()));
+        JsonRun->SetObjectField(TEXT("options"), JsonOptions);
+        JsonRun->SetNumberField(TEXT("ms"), GetMedian(TotalMilliseconds));
+        JsonRun->SetNumberField(TEXT("minMs"), GetMin(TotalMilliseconds));
+        JsonRun->SetNumberField(TEXT("fetches"), double(TotalFetches));
+        JsonRun->SetNumberField(TEXT("texels"), double(TotalFetches * 4));
+        JsonRun->SetNumberField(TEXT("bytes"), double(TotalBytes));
+        JsonRun->SetArrayField(TEXT("stages"), JsonStages);
+
+        UE_LOG(LogPrettyPostProcess, Display, TEXT("Benchmark: %s %s (%dx%d): %.2f ms"),
+            *Input.Name, *ResolutionName, ViewSize.X, ViewSize.Y, GetMedian(TotalMilliseconds));
+
+        if (OutOutput != nullptr)
+        {
+            *OutOutput = MoveTemp(Output);
+        }
+
+        return JsonRun;
+    }
+}
+
+UPostProcessBenchmarkCommandlet::UPostProcessBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+
+    HelpDescription = TEXT("Measures the cost of every stage of the pipeline on the CPU implementation and writes it as JSON.");
+    HelpUsage = TEXT("-run=PostProcessBenchmark -nullrhi [-Output=] [-Inputs=] [-Replay=] [-ReplayImages=] [-Asset=] [-Resolutions=] [-SweepResolution=] [-Quality=] [-Iterations=] [-NoSweeps]");
+}
+
+int32 UPostProcessBenchmarkCommandlet::Main(const FString& Params)
+{
+    //--------------------------------
+    // Parameters
+    //--------------------------------
+    FString OutputPath = FPaths::ProjectSavedDir() / TEXT("PrettyPostProcess") / TEXT("Benchmark.json");
+    FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+    FString ResolutionList = TEXT("1080p,1440p,4K,8K");
+    FParse::Value(*Params, TEXT("Resolutions="), ResolutionList, false);
+
+    FString SweepResolutionName = TEXT("1080p");
+    FParse::Value(*Params, TEXT("SweepResolution="), SweepResolutionName);
+
+    int32 Quality = 3;
+    FParse::Value(*Params, TEXT("Quality="), Quality);
+
+    int32 Iterations = 5;
+    FParse::Value(*Params, TEXT("Iterations="), Iterations);
+    Iterations = FMath::Max(Iterations, 1);
+
+    const bool bSweeps = !FParse::Param(*Params, TEXT("NoSweeps"));
+
+    TArray<TPair<FString, FIntPoint>> Resolutions;
+    TArray<FString> ResolutionNames;
+    ResolutionList.ParseIntoArray(ResolutionNames, TEXT(","));
+
+    for (const FString& Name : ResolutionNames)
+    {
+        FIntPoint Size;
+
+        if (!ParseResolution(Name, Size))
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Benchmark: unknown resolution '%s'"), *Name);
+            return 1;
+        }
+
+        Resolutions.Emplace(Name, Size);
+    }
+
+    FIntPoint SweepResolution;
+
+    if (bSweeps && !ParseResolution(SweepResolutionName, SweepResolution))
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Benchmark: unknown resolution '%s'"), *SweepResolutionName);
+        return 1;
+    }
+
+    //--------------------------------
+    // Settings
+    //--------------------------------
+    // The data asset the subsystem renders with, unless given
+    FString AssetPath = UPostProcessSubsystem::GetDefaultDataAssetPath().ToString();
+    FParse::Value(*Params, TEXT("Asset="), AssetPath);
+
+    const UPostProcessDataAsset* Asset = LoadObject<UPostProcessDataAsset>(nullptr, *AssetPath);
+
+    if (Asset == nullptr)
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Benchmark: can't load the data asset '%s'"), *AssetPath);
+        return 1;
+    }
+
+    // Textures stay white, the cost doesn't depend on their content
+    const CPU::FSettings Settings = CPU::FSettings::FromDataAsset(*Asset);
+
+    const FPostProcessQualityPreset& Preset = FPostProcessQualityPreset::Get(Quality);
+
+    CPU::FPipelineOptions Options;
+    Options.BloomPassAmount = Preset.BloomPassAmount;
+    Options.MaxBlurSteps = Preset.BlurSteps;
+    Options.MaxGhostCount = Preset.GhostCount;
+    Options.GlareTileSize = Preset.GlareTileSize;
+    Options.FlareMip = Preset.FlareMip;
+
+    // FloatRGBA or FloatRGB (R11G11B10), see GetIntermediateFormat()
+    const int32 BytesPerPixel = Preset.bHighPrecision ? 8 : 4;
+
+    //--------------------------------
+    // Inputs
+    //--------------------------------
+    TArray<FBenchmarkInput> Inputs;
+    AddSyntheticInputs(Inputs);
+
+    FString InputList;
+
+    if (FParse::Value(*Params, TEXT("Inputs="), InputList, false))
+    {
+        TArray<FString> Filenames;
+        InputList.ParseIntoArray(Filenames, TEXT(","));
+
+        for (const FString& Filename : Filenames)
+        {
+            if (!AddCapturedInput(Filename, Inputs))
+            {
+                return 1;
+            }
+        }
+    }
+
+    //--------------------------------
+    // Runs
+    //--------------------------------
+    TArray<TSharedPtr<FJsonValue>> Runs;
+
+    for (const FBenchmarkInput& Input : Inputs)
+    {
+        for (const TPair<FString, FIntPoint>& Resolution : Resolutions)
+        {
+            TSharedRef<FJsonObject> Run = RunBenchmark(Input, Resolution.Key, Resolution.Value, Settings, Options, BytesPerPixel, Iterations);
+            Run->SetStringField(TEXT("sweep"), TEXT("None"));
+            Runs.Add(MakeShared<FJsonValueObject>(Run));
+        }
+    }
+
+    if (bSweeps)
+    {
+        const FBenchmarkSweep Sweeps[] =
+        {
+            { TEXT("BloomPassAmount"), { 2, 3, 4, 5, 6, 7 }, [](int32 Value, CPU::FSettings&, CPU::FPipelineOptions& SweepOptions)
+            {
+                SweepOptions.BloomPassAmount = Value;
+            }},
+            { TEXT("BlurSteps"), { 0, 1, 2, 4, 8 }, [](int32 Value, CPU::FSettings& SweepSettings, CPU::FPipelineOptions& SweepOptions)
+            {
+                SweepSettings.BlurSteps = Value;
+                SweepOptions.MaxBlurSteps = Value;
+            }},
+            { TEXT("GhostCount"), { 1, 2, 4, 8 }, [](int32 Value, CPU::FSettings&, CPU::FPipelineOptions& SweepOptions)
+            {
+                SweepOptions.MaxGhostCount = Value;
+            }},
+            // Glare tile size: a sprite per tile, so 4x the sprites per step down
+            { TEXT("GlareTileSize"), { 8, 4, 2, 1 }, [](int32 Value, CPU::FSettings&, CPU::FPipelineOptions& SweepOptions)
+            {
+                SweepOptions.GlareTileSize = Value;
+            }}
+        };
+
+        for (const FBenchmarkSweep& Sweep : Sweeps)
+        {
+            for (int32 Value : Sweep.Values)
+            {
+                CPU::FSettings SweepSettings = Settings;
+                CPU::FPipelineOptions SweepOptions = Options;
+                Sweep.Apply(Value, SweepSettings, SweepOptions);
+
+                for (const FBenchmarkInput& Input : Inputs)
+                {
+                    TSharedRef<FJsonObject> Run = RunBenchmark(Input, SweepResolutionName, SweepResolution, SweepSettings, SweepOptions, BytesPerPixel, Iterations);
+                    Run->SetStringField(TEXT("sweep"), Sweep.Name);
+                    Run->SetNumberField(TEXT("sweepValue"), Value);
+                    Runs.Add(MakeShared<FJsonValueObject>(Run));
+                }
+            }
+        }
+    }
+
+    //--------------------------------
+    // Replays
+    //--------------------------------
+    // Captures run as they were captured: their own view, console
+    // variables, quality preset and data asset, regardless of the
+    // parameters above.
+    FString ReplayList;
+
+    if (FParse::Value(*Params, TEXT("Replay="), ReplayList, false))
+    {
+        FString ReplayImages;
+        FParse::Value(*Params, TEXT("ReplayImages="), ReplayImages);
+
+        TArray<FString> Filenames;
+        ReplayList.ParseIntoArray(Filenames, TEXT(","));
+
+        for (const FString& Filename : Filenames)
+        {
+            const TUniquePtr<FPostProcessCapture> Capture = FPostProcessCapture::Load(Filename);
+
+            if (!Capture.IsValid())
+            {
+                return 1;
+            }
+
+            // Textures stay white, like the other runs
+            const CPU::FSettings ReplaySettings = CPU::FSettings::FromDataAsset(*Capture->CreateDataAsset());
+            const CPU::FPipelineOptions ReplayOptions = Capture->GetPipelineOptions();
+
+            TSharedRef<CPU::FImage> Source = MakeShared<CPU::FImage>();
+            Capture->GetSceneColor(*Source);
+
+            const FBenchmarkInput Input{ FPaths::GetBaseFilename(Filename), [Source](CPU::FImage& Image)
+            {
+                CPU::Resample(*Source, Image);
+            }};
+
+            CPU::FPipelineOutput Output;
+            TSharedRef<FJsonObject> Run = RunBenchmark(
+                Input,
+                TEXT("Capture"),
+                Capture->ViewSize,
+                ReplaySettings,
+                ReplayOptions,
+                Capture->Preset.bHighPrecision ? 8 : 4,
+                Iterations,
+                &Output,
+                Capture->GetSize()
+            );
+
+            Run->SetStringField(TEXT("sweep"), TEXT("Replay"));
+            Run->SetStringField(TEXT("capturePluginVersion"), Capture->PluginVersion);
+            Run->SetStringField(TEXT("captureEngineVersion"), Capture->EngineVersion);
+            Run->SetStringField(TEXT("captureAsset"), Capture->DataAssetPath);
+            Runs.Add(MakeShared<FJsonValueObject>(Run));
+
+            if (!ReplayImages.IsEmpty())
+            {
+                const FString ImagePath = ReplayImages / FPaths::GetBaseFilename(Filename) + TEXT(".exr");
+
+                if (!SaveImage(Output.Mix, ImagePath))
+                {
+                    UE_LOG(LogPrettyPostProcess, Error, TEXT("Benchmark: can't write '%s'"), *ImagePath);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    //--------------------------------
+    // Report
+    //--------------------------------
+    TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetNumberField(TEXT("schema"), BenchmarkSchemaVersion);
+
+    const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("PrettyPostProcess"));
+    Report->SetStringField(TEXT("pluginVersion"), Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString());
+    Report->SetStringField(TEXT("engineVersion"), FEngineVersion::Current().ToString());
+    Report->SetStringField(TEXT("cpu"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+    Report->SetNumberField(TEXT("workerThreads"), FTaskGraphInterface::Get().GetNumWorkerThreads());
+    Report->SetNumberField(TEXT("quality"), Quality);
+    Report->SetNumberField(TEXT("iterations"), Iterations);
+    Report->SetStringField(TEXT("asset"), Asset->GetPathName());
+    Report->SetArrayField(TEXT("runs"), Runs);
+
+    FString Json;
+    const TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+
+    if (!FJsonSerializer::Serialize(Report, Writer) || !FFileHelper::SaveStringToFile(Json, *OutputPath))
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Benchmark: can't write '%s'"), *OutputPath);
+        return 1;
+    }
+
+    UE_LOG(LogPrettyPostProcess, Display, TEXT("Benchmark: %d runs written to '%s'"), Runs.Num(), *OutputPath);
+
+    return 0;
+}
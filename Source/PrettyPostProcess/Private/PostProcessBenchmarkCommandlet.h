@@ -0,0 +1,33 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PostProcessBenchmarkCommandlet.generated.h"
+
+// Measures the pipeline stages on the CPU implementation
+// (PrettyPostProcessCPU.h), no GPU needed: runs with -nullrhi.
+// Every input is rendered at each resolution with the quality preset,
+// then again at a single resolution while sweeping one parameter at a
+// time. The timings, pixels and fetches of every stage and the memory of
+// the intermediate buffers (in the GPU formats) are written to a JSON
+// file, to compare plugin versions with. Captures (r.PrettyPostProcess.Capture)
+// can be given as inputs, or replayed with the settings they were
+// captured with, their output written as EXR.
+//
+// UnrealEditor-Cmd <Project> -run=PostProcessBenchmark -nullrhi
+//     -Output=<Benchmark.json> -Inputs=<a.exr,b.hdr,c.pppcapture> -Asset=<Data Asset path>
+//     -Resolutions=1080p,1440p,4K,8K -SweepResolution=1080p
+//     -Quality=3 -Iterations=5 -NoSweeps
+//     -Replay=<a.pppcapture,b.pppcapture> -ReplayImages=<Directory>
+UCLASS()
+class UPostProcessBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UPostProcessBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
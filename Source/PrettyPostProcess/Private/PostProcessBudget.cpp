@@ -0,0 +1,226 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessBudget.h"
+#include "PostProcessSubsystem.h"
+#include "RenderGraphUtils.h"
+
+namespace
+{
+    // Frames in a row over budget before degrading a stage
+    constexpr int32 FramesBeforeDegrade = 8;
+
+    // Frames in a row under the restore threshold before restoring a stage
+    constexpr int32 FramesBeforeRestore = 60;
+
+    // Fraction of the budget the effect must fall under before restoring
+    constexpr float RestoreThreshold = 0.75f;
+
+    // Stages costing less than this are not worth degrading
+    constexpr float MinStageMs = 0.05f;
+
+    // Weight of a new measurement in the smoothed timings
+    constexpr float SmoothingFactor = 0.2f;
+
+    // Number of degradation steps per stage
+    constexpr int32 MaxStageLevel[int32(EPostProcessStage::Num)] =
+    {
+        3, // Bloom
+        2, // Flare
+        2  // Glare
+    };
+
+    // Order in which stages are degraded, least visible first.
+    // Restoring goes through it backward.
+    constexpr EPostProcessStage DegradeOrder[] =
+    {
+        EPostProcessStage::Glare,
+        EPostProcessStage::Flare,
+        EPostProcessStage::Bloom
+    };
+}
+
+FPostProcessBudgetGovernor::FPostProcessBudgetGovernor()
+{
+    QueryPool = RHICreateRenderQueryPool(RQT_AbsoluteTime);
+}
+
+void FPostProcessBudgetGovernor::Update(float BudgetMs)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    if (LastFrameNumber == GFrameCounterRenderThread)
+    {
+        return;
+    }
+
+    LastFrameNumber = GFrameCounterRenderThread;
+
+    // The slot we are about to record into is also the oldest one
+    FrameIndex = (FrameIndex + 1) % NumFrames;
+
+    TArray<FStageQuery>& Queries = Frames[FrameIndex];
+
+    float FrameStageMs[int32(EPostProcessStage::Num)] = {};
+    const bool bHasResults = Queries.Num() > 0 && ReadFrame(Queries, FrameStageMs);
+
+    // Releases the queries back into the pool
+    Queries.Reset();
+
+    if (!bHasResults)
+    {
+        return;
+    }
+
+    float TotalMs = 0.0f;
+
+    for (int32 i = 0; i < int32(EPostProcessStage::Num); i++)
+    {
+        StageMs[i] = FMath::Lerp(StageMs[i], FrameStageMs[i], SmoothingFactor);
+        TotalMs += StageMs[i];
+    }
+
+    FramesOverBudget = TotalMs > BudgetMs ? FramesOverBudget + 1 : 0;
+    FramesUnderBudget = TotalMs < BudgetMs * RestoreThreshold ? FramesUnderBudget + 1 : 0;
+
+    if (FramesOverBudget >= FramesBeforeDegrade)
+    {
+        for (EPostProcessStage Stage : DegradeOrder)
+        {
+            const int32 Index = int32(Stage);
+
+            if (StageLevel[Index] < MaxStageLevel[Index] && StageMs[Index] > MinStageMs)
+            {
+                StageLevel[Index]++;
+                break;
+            }
+        }
+
+        FramesOverBudget = 0;
+    }
+    else if (FramesUnderBudget >= FramesBeforeRestore)
+    {
+        for (int32 i = UE_ARRAY_COUNT(DegradeOrder) - 1; i >= 0; i--)
+        {
+            const int32 Index = int32(DegradeOrder[i]);
+
+            if (StageLevel[Index] > 0)
+            {
+                StageLevel[Index]--;
+                break;
+            }
+        }
+
+        FramesUnderBudget = 0;
+    }
+}
+
+void FPostProcessBudgetGovernor::Apply(FPostProcessQualityPreset& Preset) const
+{
+    FScopeLock Lock(&CriticalSection);
+
+    // Bloom: fewer passes (the smallest mips are the cheapest to lose visually)
+    const int32 BloomLevel = StageLevel[int32(EPostProcessStage::Bloom)];
+    Preset.BloomPassAmount = FMath::Max(Preset.BloomPassAmount - BloomLevel, 3);
+
+    // Flare: single blur step, then half the internal resolution
+    const int32 FlareLevel = StageLevel[int32(EPostProcessStage::Flare)];
+
+    if (FlareLevel >= 1)
+    {
+        Preset.BlurSteps = FMath::Min(Preset.BlurSteps, 1);
+    }
+
+    if (FlareLevel >= 2)
+    {
+        Preset.FlareMip += 1;
+    }
+
+    // Glare: bigger tiles, so a quarter of the sprites per step
+    const int32 GlareLevel = StageLevel[int32(EPostProcessStage::Glare)];
+    Preset.GlareTileSize <<= GlareLevel;
+}
+
+void FPostProcessBudgetGovernor::Reset()
+{
+    FScopeLock Lock(&CriticalSection);
+
+    for (TArray<FStageQuery>& Queries : Frames)
+    {
+        Queries.Reset();
+    }
+
+    for (int32 i = 0; i < int32(EPostProcessStage::Num); i++)
+    {
+        StageMs[i] = 0.0f;
+        StageLevel[i] = 0;
+    }
+
+    FramesOverBudget = 0;
+    FramesUnderBudget = 0;
+}
+
+void FPostProcessBudgetGovernor::BeginStage(FRDGBuilder& GraphBuilder, EPostProcessStage Stage)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    FStageQuery& Query = Frames[FrameIndex].AddDefaulted_GetRef();
+    Query.Stage = Stage;
+    Query.Begin = QueryPool->AllocateQuery();
+
+    AddTimestamp(GraphBuilder, Query.Begin.GetQuery());
+}
+
+void FPostProcessBudgetGovernor::EndStage(FRDGBuilder& GraphBuilder, EPostProcessStage Stage)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    // Close the last opened query of this stage
+    TArray<FStageQuery>& Queries = Frames[FrameIndex];
+
+    for (int32 i = Queries.Num() - 1; i >= 0; i--)
+    {
+        if (Queries[i].Stage == Stage && !Queries[i].End.IsValid())
+        {
+            Queries[i].End = QueryPool->AllocateQuery();
+            AddTimestamp(GraphBuilder, Queries[i].End.GetQuery());
+            return;
+        }
+    }
+}
+
+void FPostProcessBudgetGovernor::AddTimestamp(FRDGBuilder& GraphBuilder, FRHIRenderQuery* Query)
+{
+    GraphBuilder.AddPass(
+        RDG_EVENT_NAME("BudgetTimestamp"),
+        ERDGPassFlags::NeverCull,
+        [Query](FRHICommandList& RHICmdList)
+        {
+            RHICmdList.EndRenderQuery(Query);
+        });
+}
+
+bool FPostProcessBudgetGovernor::ReadFrame(TArray<FStageQuery>& Queries, float OutStageMs[]) const
+{
+    for (FStageQuery& Query : Queries)
+    {
+        if (!Query.End.IsValid())
+        {
+            continue;
+        }
+
+        uint64 BeginTime = 0;
+        uint64 EndTime = 0;
+
+        // Never wait, a frame that isn't done yet is simply not measured
+        if (!RHIGetRenderQueryResult(Query.Begin.GetQuery(), BeginTime, false)
+            || !RHIGetRenderQueryResult(Query.End.GetQuery(), EndTime, false))
+        {
+            return false;
+        }
+
+        // Absolute time queries are in microseconds
+        OutStageMs[int32(Query.Stage)] += float(EndTime - FMath::Min(BeginTime, EndTime)) / 1000.0f;
+    }
+
+    return true;
+}
@@ -0,0 +1,102 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHI.h"
+#include "RenderGraphBuilder.h"
+
+struct FPostProcessQualityPreset;
+
+// Stages measured by the budget governor
+enum class EPostProcessStage : uint8
+{
+    Bloom,
+    Flare,
+    Glare,
+    Num
+};
+
+// Keeps the plugin under a GPU time budget.
+// Each stage is bracketed by timestamp queries, results are read back a
+// few frames later (without stalling) and used to degrade or restore the
+// stages one step at a time. Less visible stages are degraded first and
+// restored last. Render thread only.
+class FPostProcessBudgetGovernor
+{
+public:
+    FPostProcessBudgetGovernor();
+
+    // Read back the oldest frame of queries and update the degradation
+    // levels. Only does work on the first call of a frame.
+    void Update(float BudgetMs);
+
+    // Lower the preset according to the current degradation levels
+    void Apply(FPostProcessQualityPreset& Preset) const;
+
+    // Drop all levels and pending measurements
+    void Reset();
+
+    void BeginStage(FRDGBuilder& GraphBuilder, EPostProcessStage Stage);
+    void EndStage(FRDGBuilder& GraphBuilder, EPostProcessStage Stage);
+
+private:
+    // Frames of queries in flight, results are read this many frames later
+    static constexpr int32 NumFrames = 4;
+
+    struct FStageQuery
+    {
+        EPostProcessStage Stage;
+        FRHIPooledRenderQuery Begin;
+        FRHIPooledRenderQuery End;
+    };
+
+    void AddTimestamp(FRDGBuilder& GraphBuilder, FRHIRenderQuery* Query);
+    bool ReadFrame(TArray<FStageQuery>& Queries, float OutStageMs[]) const;
+
+    FRenderQueryPoolRHIRef QueryPool;
+    TArray<FStageQuery> Frames[NumFrames];
+    int32 FrameIndex = 0;
+    uint64 LastFrameNumber = MAX_uint64;
+
+    // Smoothed GPU time of each stage
+    float StageMs[int32(EPostProcessStage::Num)] = {};
+
+    // Degradation step of each stage (0 = untouched)
+    int32 StageLevel[int32(EPostProcessStage::Num)] = {};
+
+    // Hysteresis counters
+    int32 FramesOverBudget = 0;
+    int32 FramesUnderBudget = 0;
+
+    mutable FCriticalSection CriticalSection;
+};
+
+// Brackets a stage with timestamps when a governor is active
+class FPostProcessBudgetScope
+{
+public:
+    FPostProcessBudgetScope(FPostProcessBudgetGovernor* InGovernor, FRDGBuilder& InGraphBuilder, EPostProcessStage InStage)
+        : Governor(InGovernor)
+        , GraphBuilder(InGraphBuilder)
+        , Stage(InStage)
+    {
+        if (Governor != nullptr)
+        {
+            Governor->BeginStage(GraphBuilder, Stage);
+        }
+    }
+
+    ~FPostProcessBudgetScope()
+    {
+        if (Governor != nullptr)
+        {
+            Governor->EndStage(GraphBuilder, Stage);
+        }
+    }
+
+private:
+    FPostProcessBudgetGovernor* Governor;
+    FRDGBuilder& GraphBuilder;
+    EPostProcessStage Stage;
+};
@@ -0,0 +1,507 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessCapture.h"
+#include "PostProcessDataAsset.h"
+#include "PrettyPostProcess.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Interfaces/IPluginManager.h"
+#include "JsonObjectConverter.h"
+#include "Misc/EngineVersion.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/Package.h"
+
+namespace
+{
+    // FHeader, as serialized
+    constexpr uint64 HeaderSize = 48;
+
+    const TCHAR* QualityNames[] = {
+        TEXT("Skip"),
+        TEXT("BloomOnly"),
+        TEXT("Reduced"),
+        TEXT("Full")
+    };
+
+    void SerializeHeader(FArchive& Archive, FPostProcessCapture::FHeader& Header)
+    {
+        Archive << Header.Magic;
+        Archive << Header.Version;
+        Archive << Header.Width;
+        Archive << Header.Height;
+        Archive << Header.MetadataOffset;
+        Archive << Header.MetadataSize;
+        Archive << Header.PixelOffset;
+        Archive << Header.PlaneStride;
+    }
+
+    TArray<TSharedPtr<FJsonValue>> MakeJsonArray(std::initializer_list<int32> Values)
+    {
+        TArray<TSharedPtr<FJsonValue>> Array;
+
+        for (int32 Value : Values)
+        {
+            Array.Add(MakeShared<FJsonValueNumber>(Value));
+        }
+
+        return Array;
+    }
+
+    // Integers of a JSON array field, false unless there are Count of them
+    bool ReadJsonArray(const FJsonObject& Object, const TCHAR* Field, int32* OutValues, int32 Count)
+    {
+        const TArray<TSharedPtr<FJsonValue>>* Array = nullptr;
+
+        if (!Object.TryGetArrayField(Field, Array) || Array->Num() != Count)
+        {
+            return false;
+        }
+
+        for (int32 i = 0; i < Count; i++)
+        {
+            OutValues[i] = FMath::TruncToInt((*Array)[i]->AsNumber());
+        }
+
+        return true;
+    }
+}
+
+FPostProcessCapture::FPostProcessCapture() = default;
+
+// Out of line, IMappedFileHandle and IMappedFileRegion are only forward declared in the header
+FPostProcessCapture::~FPostProcessCapture()
+{
+    // The region has to go before its file
+    MappedRegion.Reset();
+    MappedFile.Reset();
+}
+
+//----------------------------------------------------------
+// Settings
+//----------------------------------------------------------
+
+void FPostProcessCapture::CaptureSettings(const UPostProcessDataAsset& Asset)
+{
+    check(IsInGameThread());
+
+    ConsoleVariables.Reset();
+
+    IConsoleManager::Get().ForEachConsoleObjectThatStartsWith(
+        FConsoleObjectVisitor::CreateLambda([this](const TCHAR* Name, IConsoleObject* Object)
+            {
+                if (IConsoleVariable* Variable = Object->AsVariable())
+                {
+                    ConsoleVariables.Add(Name, Variable->GetString());
+                }
+            }),
+        TEXT("r.PrettyPostProcess.")
+    );
+
+    ConsoleVariables.KeySort(TLess<FString>());
+
+    // Only what can be edited, the rest is derived from it
+    DataAssetPath = Asset.GetPathName();
+    DataAsset = MakeShared<FJsonObject>();
+    FJsonObjectConverter::UStructToJsonObject(UPostProcessDataAsset::StaticClass(), &Asset, DataAsset.ToSharedRef(), CPF_Edit, 0);
+
+    const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("PrettyPostProcess"));
+    PluginVersion = Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString();
+    EngineVersion = FEngineVersion::Current().ToString();
+}
+
+int32 FPostProcessCapture::GetConsoleVariable(const TCHAR* Name, int32 Fallback) const
+{
+    const FString* Value = ConsoleVariables.Find(Name);
+    return Value != nullptr ? FCString::Atoi(**Value) : Fallback;
+}
+
+float FPostProcessCapture::GetConsoleVariable(const TCHAR* Name, float Fallback) const
+{
+    const FString* Value = ConsoleVariables.Find(Name);
+    return Value != nullptr ? FCString::Atof(**Value) : Fallback;
+}
+
+//----------------------------------------------------------
+// Pixels
+//----------------------------------------------------------
+
+void FPostProcessCapture::InitPixels(const FIntPoint& InSize)
+{
+    MappedRegion.Reset();
+    MappedFile.Reset();
+    MappedPixels = nullptr;
+
+    Size = InSize;
+    Pixels.Reset();
+    Pixels.SetNumZeroed(int64(Size.X) * Size.Y * 3);
+}
+
+const FFloat16* FPostProcessCapture::GetRow(int32 Channel, int32 Y) const
+{
+    check(Channel >= 0 && Channel < 3 && Y >= 0 && Y < Size.Y);
+
+    const int64 RowOffset = int64(Y) * Size.X;
+
+    if (MappedPixels != nullptr)
+    {
+        const uint8* Plane = reinterpret_cast<const uint8*>(MappedPixels) + Channel * MappedPlaneStride;
+        return reinterpret_cast<const FFloat16*>(Plane) + RowOffset;
+    }
+
+    return Pixels.GetData() + Channel * int64(Size.X) * Size.Y + RowOffset;
+}
+
+FFloat16* FPostProcessCapture::GetRowForWrite(int32 Channel, int32 Y)
+{
+    check(MappedPixels == nullptr);
+    return const_cast<FFloat16*>(GetRow(Channel, Y));
+}
+
+//----------------------------------------------------------
+// Metadata
+//----------------------------------------------------------
+
+FString FPostProcessCapture::WriteMetadata() const
+{
+    TSharedRef<FJsonObject> Metadata = MakeShared<FJsonObject>();
+
+    Metadata->SetArrayField(TEXT("extent"), MakeJsonArray({ Extent.X, Extent.Y }));
+    Metadata->SetArrayField(TEXT("viewRect"), MakeJsonArray({ ViewRect.Min.X, ViewRect.Min.Y, ViewRect.Max.X, ViewRect.Max.Y }));
+    Metadata->SetArrayField(TEXT("viewSize"), MakeJsonArray({ ViewSize.X, ViewSize.Y }));
+    Metadata->SetStringField(TEXT("quality"), QualityNames[uint8(Quality)]);
+    Metadata->SetBoolField(TEXT("mobile"), bMobile);
+
+    TSharedRef<FJsonObject> JsonPreset = MakeShared<FJsonObject>();
+    JsonPreset->SetNumberField(TEXT("bloomPassAmount"), Preset.BloomPassAmount);
+    JsonPreset->SetNumberField(TEXT("blurSteps"), Preset.BlurSteps);
+    JsonPreset->SetNumberField(TEXT("ghostCount"), Preset.GhostCount);
+    JsonPreset->SetNumberField(TEXT("glareTileSize"), Preset.GlareTileSize);
+    JsonPreset->SetNumberField(TEXT("flareMip"), Preset.FlareMip);
+    JsonPreset->SetBoolField(TEXT("highPrecision"), Preset.bHighPrecision);
+    Metadata->SetObjectField(TEXT("preset"), JsonPreset);
+
+    TSharedRef<FJsonObject> JsonVariables = MakeShared<FJsonObject>();
+
+    for (const TPair<FString, FString>& Variable : ConsoleVariables)
+    {
+        JsonVariables->SetStringField(Variable.Key, Variable.Value);
+    }
+
+    Metadata->SetObjectField(TEXT("consoleVariables"), JsonVariables);
+    Metadata->SetStringField(TEXT("dataAssetPath"), DataAssetPath);
+    Metadata->SetObjectField(TEXT("dataAsset"), DataAsset.IsValid() ? DataAsset : TSharedPtr<FJsonObject>(MakeShared<FJsonObject>()));
+    Metadata->SetStringField(TEXT("pluginVersion"), PluginVersion);
+    Metadata->SetStringField(TEXT("engineVersion"), EngineVersion);
+
+    FString Json;
+    const TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+    FJsonSerializer::Serialize(Metadata, Writer);
+
+    return Json;
+}
+
+bool FPostProcessCapture::ReadMetadata(const FString& Json)
+{
+    TSharedPtr<FJsonObject> Metadata;
+
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<TCHAR>::Create(Json), Metadata) || !Metadata.IsValid())
+    {
+        return false;
+    }
+
+    int32 Values[4];
+
+    if (!ReadJsonArray(*Metadata, TEXT("extent"), Values, 2))
+    {
+        return false;
+    }
+
+    Extent = FIntPoint(Values[0], Values[1]);
+
+    if (!ReadJsonArray(*Metadata, TEXT("viewRect"), Values, 4))
+    {
+        return false;
+    }
+
+    ViewRect = FIntRect(Values[0], Values[1], Values[2], Values[3]);
+
+    if (!ReadJsonArray(*Metadata, TEXT("viewSize"), Values, 2))
+    {
+        return false;
+    }
+
+    ViewSize = FIntPoint(Values[0], Values[1]);
+
+    const FString QualityName = Metadata->GetStringField(TEXT("quality"));
+
+    for (int32 i = 0; i < UE_ARRAY_COUNT(QualityNames); i++)
+    {
+        if (QualityName == QualityNames[i])
+        {
+            Quality = EPostProcessViewQuality(i);
+        }
+    }
+
+    Metadata->TryGetBoolField(TEXT("mobile"), bMobile);
+
+    const TSharedPtr<FJsonObject>* JsonPreset = nullptr;
+
+    if (Metadata->TryGetObjectField(TEXT("preset"), JsonPreset))
+    {
+        (*JsonPreset)->TryGetNumberField(TEXT("bloomPassAmount"), Preset.BloomPassAmount);
+        (*JsonPreset)->TryGetNumberField(TEXT("blurSteps"), Preset.BlurSteps);
+        (*JsonPreset)->TryGetNumberField(TEXT("ghostCount"), Preset.GhostCount);
+        (*JsonPreset)->TryGetNumberField(TEXT("glareTileSize"), Preset.GlareTileSize);
+        (*JsonPreset)->TryGetNumberField(TEXT("flareMip"), Preset.FlareMip);
+        (*JsonPreset)->TryGetBoolField(TEXT("highPrecision"), Preset.bHighPrecision);
+    }
+
+    ConsoleVariables.Reset();
+    const TSharedPtr<FJsonObject>* JsonVariables = nullptr;
+
+    if (Metadata->TryGetObjectField(TEXT("consoleVariables"), JsonVariables))
+    {
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Variable : (*JsonVariables)->Values)
+        {
+            ConsoleVariables.Add(Variable.Key, Variable.Value->AsString());
+        }
+    }
+
+    const TSharedPtr<FJsonObject>* JsonDataAsset = nullptr;
+    DataAsset = Metadata->TryGetObjectField(TEXT("dataAsset"), JsonDataAsset) ? *JsonDataAsset : TSharedPtr<FJsonObject>(MakeShared<FJsonObject>());
+
+    Metadata->TryGetStringField(TEXT("dataAssetPath"), DataAssetPath);
+    Metadata->TryGetStringField(TEXT("pluginVersion"), PluginVersion);
+    Metadata->TryGetStringField(TEXT("engineVersion"), EngineVersion);
+
+    return true;
+}
+
+//----------------------------------------------------------
+// File
+//----------------------------------------------------------
+
+bool FPostProcessCapture::Save(const FString& Filename) const
+{
+    const FTCHARToUTF8 Metadata(*WriteMetadata());
+
+    FHeader Header;
+    Header.Magic = Magic;
+    Header.Version = Version;
+    Header.Width = Size.X;
+    Header.Height = Size.Y;
+    Header.MetadataOffset = HeaderSize;
+    Header.MetadataSize = Metadata.Length();
+    Header.PixelOffset = Align(Header.MetadataOffset + Header.MetadataSize, PixelAlignment);
+    Header.PlaneStride = Align(uint64(Size.X) * Size.Y * sizeof(FFloat16), PixelAlignment);
+
+    TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+
+    if (!Writer.IsValid())
+    {
+        return false;
+    }
+
+    SerializeHeader(*Writer, Header);
+    Writer->Serialize(const_cast<ANSICHAR*>(Metadata.Get()), Header.MetadataSize);
+
+    TArray<uint8> Padding;
+    Padding.SetNumZeroed(PixelAlignment);
+
+    for (int32 Channel = 0; Channel < 3; Channel++)
+    {
+        const int64 PlaneOffset = Header.PixelOffset + Channel * Header.PlaneStride;
+        Writer->Serialize(Padding.GetData(), PlaneOffset - Writer->Tell());
+
+        for (int32 Y = 0; Y < Size.Y; Y++)
+        {
+            Writer->Serialize(const_cast<FFloat16*>(GetRow(Channel, Y)), Size.X * sizeof(FFloat16));
+        }
+    }
+
+    return Writer->Close() && !Writer->IsError();
+}
+
+TUniquePtr<FPostProcessCapture> FPostProcessCapture::Load(const FString& Filename)
+{
+    TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+
+    if (!Reader.IsValid())
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: can't open '%s'"), *Filename);
+        return nullptr;
+    }
+
+    //--------------------------------
+    // Header
+    //--------------------------------
+    const int64 FileSize = Reader->TotalSize();
+    FHeader Header;
+
+    if (FileSize >= int64(HeaderSize))
+    {
+        SerializeHeader(*Reader, Header);
+    }
+
+    if (Header.Magic != Magic)
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: '%s' is not a capture"), *Filename);
+        return nullptr;
+    }
+
+    if (Header.Version == 0 || Header.Version > Version)
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: '%s' is version %u, this plugin reads up to %u"),
+            *Filename, Header.Version, Version);
+        return nullptr;
+    }
+
+    const uint64 PlaneSize = uint64(FMath::Max(Header.Width, 0)) * FMath::Max(Header.Height, 0) * sizeof(FFloat16);
+
+    if (Header.Width <= 0 || Header.Height <= 0
+        || Header.PlaneStride < PlaneSize
+        || Header.MetadataOffset + Header.MetadataSize > uint64(FileSize)
+        || Header.PixelOffset + Header.PlaneStride * 2 + PlaneSize > uint64(FileSize))
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: '%s' is truncated or corrupted"), *Filename);
+        return nullptr;
+    }
+
+    //--------------------------------
+    // Metadata
+    //--------------------------------
+    TUniquePtr<FPostProcessCapture> Capture = MakeUnique<FPostProcessCapture>();
+
+    TArray<uint8> Metadata;
+    Metadata.SetNumUninitialized(Header.MetadataSize);
+    Reader->Seek(Header.MetadataOffset);
+    Reader->Serialize(Metadata.GetData(), Metadata.Num());
+
+    const FUTF8ToTCHAR Json(reinterpret_cast<const ANSICHAR*>(Metadata.GetData()), Metadata.Num());
+
+    if (Reader->IsError() || !Capture->ReadMetadata(FString(Json.Length(), Json.Get())))
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: can't read the metadata of '%s'"), *Filename);
+        return nullptr;
+    }
+
+    //--------------------------------
+    // Pixels
+    //--------------------------------
+    Capture->Size = FIntPoint(Header.Width, Header.Height);
+
+    const uint64 PixelBytes = Header.PlaneStride * 2 + PlaneSize;
+    Capture->MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+
+    if (Capture->MappedFile.IsValid())
+    {
+        Capture->MappedRegion.Reset(Capture->MappedFile->MapRegion(Header.PixelOffset, PixelBytes));
+    }
+
+    if (Capture->MappedRegion.IsValid())
+    {
+        Capture->MappedPixels = reinterpret_cast<const FFloat16*>(Capture->MappedRegion->GetMappedPtr());
+        Capture->MappedPlaneStride = Header.PlaneStride;
+    }
+    else
+    {
+        // No memory mapping on this platform, read the planes instead
+        Capture->MappedFile.Reset();
+        Capture->InitPixels(Capture->Size);
+
+        for (int32 Channel = 0; Channel < 3; Channel++)
+        {
+            Reader->Seek(Header.PixelOffset + Channel * Header.PlaneStride);
+            Reader->Serialize(Capture->GetRowForWrite(Channel, 0), PlaneSize);
+        }
+
+        if (Reader->IsError())
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: can't read the pixels of '%s'"), *Filename);
+            return nullptr;
+        }
+    }
+
+    return Capture;
+}
+
+//----------------------------------------------------------
+// Replay
+//----------------------------------------------------------
+
+void FPostProcessCapture::GetSceneColor(PrettyPostProcessCPU::FImage& OutImage) const
+{
+    OutImage.Init(Size.X, Size.Y);
+
+    for (int32 Channel = 0; Channel < 3; Channel++)
+    {
+        for (int32 Y = 0; Y < Size.Y; Y++)
+        {
+            const FFloat16* Source = GetRow(Channel, Y);
+            float* Destination = OutImage.GetRow(Channel, Y);
+
+            for (int32 X = 0; X < Size.X; X++)
+            {
+                Destination[X] = Source[X].GetFloat();
+            }
+        }
+    }
+}
+
+UPostProcessDataAsset* FPostProcessCapture::CreateDataAsset() const
+{
+    check(IsInGameThread());
+
+    UPostProcessDataAsset* Asset = NewObject<UPostProcessDataAsset>(GetTransientPackage());
+
+    if (DataAsset.IsValid())
+    {
+        FJsonObjectConverter::JsonObjectToUStruct(DataAsset.ToSharedRef(), UPostProcessDataAsset::StaticClass(), Asset, CPF_Edit, 0);
+    }
+
+    return Asset;
+}
+
+PrettyPostProcessCPU::FPipelineOptions FPostProcessCapture::GetPipelineOptions() const
+{
+    PrettyPostProcessCPU::FPipelineOptions Options;
+    Options.ViewSize = ViewSize;
+
+    Options.BloomPassAmount = FMath::Min(
+        GetConsoleVariable(TEXT("r.PrettyPostProcess.BloomPassAmount"), Options.BloomPassAmount),
+        Preset.BloomPassAmount
+    );
+    Options.BloomResLimit = GetConsoleVariable(TEXT("r.PrettyPostProcess.BloomResLimit"), Options.BloomResLimit);
+    Options.BloomRadius = GetConsoleVariable(TEXT("r.PrettyPostProcess.BloomRadius"), Options.BloomRadius);
+    Options.bRenderFlare = GetConsoleVariable(TEXT("r.PrettyPostProcess.RenderFlare"), 1) != 0;
+    Options.bRenderHalo = GetConsoleVariable(TEXT("r.PrettyPostProcess.RenderHalo"), 1) != 0;
+    Options.bRenderGlare = GetConsoleVariable(TEXT("r.PrettyPostProcess.RenderGlare"), 1) != 0
+        && (!bMobile || GetConsoleVariable(TEXT("r.PrettyPostProcess.Mobile.Glare"), 1) != 0);
+
+    Options.MaxBlurSteps = Preset.BlurSteps;
+    Options.MaxGhostCount = Preset.GhostCount;
+    Options.GlareTileSize = Preset.GlareTileSize;
+    Options.FlareMip = Preset.FlareMip;
+
+    // Same limits as BuildPassPlan
+    if (Quality != EPostProcessViewQuality::Full)
+    {
+        Options.bRenderHalo = false;
+        Options.bRenderGlare = false;
+    }
+
+    if (Quality == EPostProcessViewQuality::Reduced)
+    {
+        Options.BloomPassAmount = FMath::Min(Options.BloomPassAmount, 4);
+        Options.MaxBlurSteps = FMath::Min(Options.MaxBlurSteps, 1);
+    }
+    else if (Quality < EPostProcessViewQuality::Reduced)
+    {
+        Options.bRenderFlare = false;
+    }
+
+    return Options;
+}
@@ -0,0 +1,173 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessCaptureRecorder.h"
+#include "PostProcessCapture.h"
+#include "PrettyPostProcess.h"
+#include "Async/Async.h"
+#include "Math/Float16Color.h"
+#include "RenderGraphUtils.h"
+
+namespace
+{
+    // 11 and 10 bits floats share the exponent bias of FP16,
+    // only their mantissa is shorter (and they have no sign)
+    FFloat16 UnpackFloat11(uint32 Bits)
+    {
+        FFloat16 Value;
+        Value.Encoded = uint16((((Bits >> 6) & 0x1F) << 10) | ((Bits & 0x3F) << 4));
+        return Value;
+    }
+
+    FFloat16 UnpackFloat10(uint32 Bits)
+    {
+        FFloat16 Value;
+        Value.Encoded = uint16((((Bits >> 5) & 0x1F) << 10) | ((Bits & 0x1F) << 5));
+        return Value;
+    }
+}
+
+void FPostProcessCaptureRecorder::Request(TUniquePtr<FPostProcessCapture> Capture, const FString& Filename)
+{
+    check(IsInRenderingThread());
+
+    FScopeLock Lock(&CriticalSection);
+
+    Requested = MakeUnique<FPendingCapture>();
+    Requested->Capture = MoveTemp(Capture);
+    Requested->Filename = Filename;
+}
+
+bool FPostProcessCaptureRecorder::IsRequested()
+{
+    FScopeLock Lock(&CriticalSection);
+    return Requested.IsValid();
+}
+
+bool FPostProcessCaptureRecorder::AddReadback(
+    FRDGBuilder& GraphBuilder,
+    const FScreenPassTexture& SceneColor,
+    TFunctionRef<void(FPostProcessCapture&)> FillView
+)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    if (!Requested.IsValid())
+    {
+        return false;
+    }
+
+    TUniquePtr<FPendingCapture> Pending = MoveTemp(Requested);
+
+    FPostProcessCapture& Capture = *Pending->Capture;
+    Capture.Extent = SceneColor.Texture->Desc.Extent;
+    Capture.ViewRect = SceneColor.ViewRect;
+    FillView(Capture);
+
+    Pending->Format = SceneColor.Texture->Desc.Format;
+    Pending->Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("PrettyPostProcess.CaptureReadback"));
+    AddEnqueueCopyPass(GraphBuilder, Pending->Readback.Get(), SceneColor.Texture);
+
+    InFlight.Add(MoveTemp(Pending));
+
+    return true;
+}
+
+void FPostProcessCaptureRecorder::Update()
+{
+    FScopeLock Lock(&CriticalSection);
+
+    for (int32 i = InFlight.Num() - 1; i >= 0; i--)
+    {
+        if (!InFlight[i]->Readback->IsReady())
+        {
+            continue;
+        }
+
+        TUniquePtr<FPendingCapture> Pending = MoveTemp(InFlight[i]);
+        InFlight.RemoveAt(i);
+
+        if (!ReadPixels(*Pending))
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: scene color format %s is not supported"),
+                GetPixelFormatString(Pending->Format));
+            continue;
+        }
+
+        // Writing a 4K capture takes a while, keep it off the render thread
+        Async(EAsyncExecution::ThreadPool, [Capture = MoveTemp(Pending->Capture), Filename = MoveTemp(Pending->Filename)]()
+            {
+                if (Capture->Save(Filename))
+                {
+                    UE_LOG(LogPrettyPostProcess, Display, TEXT("Capture: %dx%d written to '%s'"),
+                        Capture->GetSize().X, Capture->GetSize().Y, *Filename);
+                }
+                else
+                {
+                    UE_LOG(LogPrettyPostProcess, Error, TEXT("Capture: can't write '%s'"), *Filename);
+                }
+            });
+    }
+}
+
+bool FPostProcessCaptureRecorder::ReadPixels(FPendingCapture& Pending)
+{
+    FPostProcessCapture& Capture = *Pending.Capture;
+    const FIntRect& Rect = Capture.ViewRect;
+
+    if (Pending.Format != PF_FloatRGBA
+        && Pending.Format != PF_FloatR11G11B10
+        && Pending.Format != PF_A32B32G32R32F)
+    {
+        return false;
+    }
+
+    Capture.InitPixels(Rect.Size());
+
+    int32 RowPitchInPixels = 0;
+    const uint8* Data = static_cast<const uint8*>(Pending.Readback->Lock(RowPitchInPixels));
+
+    if (Data == nullptr)
+    {
+        return false;
+    }
+
+    const int32 BytesPerPixel = GPixelFormats[Pending.Format].BlockBytes;
+
+    for (int32 Y = 0; Y < Rect.Height(); Y++)
+    {
+        const uint8* Row = Data + (int64(Rect.Min.Y + Y) * RowPitchInPixels + Rect.Min.X) * BytesPerPixel;
+
+        FFloat16* R = Capture.GetRowForWrite(0, Y);
+        FFloat16* G = Capture.GetRowForWrite(1, Y);
+        FFloat16* B = Capture.GetRowForWrite(2, Y);
+
+        for (int32 X = 0; X < Rect.Width(); X++)
+        {
+            if (Pending.Format == PF_FloatRGBA)
+            {
+                const FFloat16Color& Color = reinterpret_cast<const FFloat16Color*>(Row)[X];
+                R[X] = Color.R;
+                G[X] = Color.G;
+                B[X] = Color.B;
+            }
+            else if (Pending.Format == PF_FloatR11G11B10)
+            {
+                const uint32 Packed = reinterpret_cast<const uint32*>(Row)[X];
+                R[X] = UnpackFloat11(Packed);
+                G[X] = UnpackFloat11(Packed >> 11);
+                B[X] = UnpackFloat10(Packed >> 22);
+            }
+            else
+            {
+                const FLinearColor& Color = reinterpret_cast<const FLinearColor*>(Row)[X];
+                R[X] = FFloat16(Color.R);
+                G[X] = FFloat16(Color.G);
+                B[X] = FFloat16(Color.B);
+            }
+        }
+    }
+
+    Pending.Readback->Unlock();
+
+    return true;
+}
@@ -0,0 +1,53 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHI.h"
+#include "RHIGPUReadback.h"
+#include "RenderGraphBuilder.h"
+#include "ScreenPass.h"
+
+class FPostProcessCapture;
+
+// Saves the inputs of the next main view to a file (r.PrettyPostProcess.Capture).
+// The scene color is copied back without waiting on the GPU, converted
+// once the copy is done and written from a worker thread. Render thread
+// only, views recorded in parallel are serialized by the lock.
+class FPostProcessCaptureRecorder
+{
+public:
+    // Settings are snapshotted by the caller, the view is filled by AddReadback
+    void Request(TUniquePtr<FPostProcessCapture> Capture, const FString& Filename);
+
+    // Whether a view has yet to be captured
+    bool IsRequested();
+
+    // Copy back the scene color of the view and fill the view of the
+    // request, which then waits in flight. Returns false when nothing was
+    // requested (or the request was taken by another view).
+    bool AddReadback(
+        FRDGBuilder& GraphBuilder,
+        const FScreenPassTexture& SceneColor,
+        TFunctionRef<void(FPostProcessCapture&)> FillView
+    );
+
+    // Write the captures whose copy is done
+    void Update();
+
+private:
+    struct FPendingCapture
+    {
+        TUniquePtr<FPostProcessCapture> Capture;
+        FString Filename;
+        TUniquePtr<FRHIGPUTextureReadback> Readback;
+        EPixelFormat Format = PF_Unknown;
+    };
+
+    // Convert the view rect of the readback into the FP16 planes of the capture
+    static bool ReadPixels(FPendingCapture& Pending);
+
+    TUniquePtr<FPendingCapture> Requested;
+    TArray<TUniquePtr<FPendingCapture>> InFlight;
+    FCriticalSection CriticalSection;
+};
@@ -0,0 +1,116 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessCapture.h"
+#include "PostProcessDataAsset.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A capture saved then loaded back has the same view layout, settings and
+// pixels (see FPostProcessCapture for the file layout). No GPU needed.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FPostProcessCaptureRoundTripTest,
+    "PrettyPostProcess.Capture.RoundTrip",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FPostProcessCaptureRoundTripTest::RunTest(const FString& Parameters)
+{
+    // Odd size, so that the planes need padding to stay aligned
+    const FIntPoint Size(37, 21);
+
+    UPostProcessDataAsset* Asset = NewObject<UPostProcessDataAsset>(GetTransientPackage());
+    Asset->FlareIntensity = 0.25f;
+
+    FPostProcessCapture Capture;
+    Capture.Extent = FIntPoint(64, 32);
+    Capture.ViewRect = FIntRect(FIntPoint(3, 5), FIntPoint(3, 5) + Size);
+    Capture.ViewSize = FIntPoint(127, 63);
+    Capture.Quality = EPostProcessViewQuality::Reduced;
+    Capture.Preset.BloomPassAmount = 5;
+    Capture.Preset.GhostCount = 3;
+    Capture.Preset.FlareMip = 1;
+    Capture.Preset.bHighPrecision = true;
+    Capture.bMobile = true;
+    Capture.CaptureSettings(*Asset);
+    Capture.InitPixels(Size);
+
+    for (int32 Channel = 0; Channel < 3; Channel++)
+    {
+        for (int32 y = 0; y < Size.Y; y++)
+        {
+            FFloat16* Row = Capture.GetRowForWrite(Channel, y);
+
+            for (int32 x = 0; x < Size.X; x++)
+            {
+                Row[x] = FFloat16(float(Channel * 1000 + y * Size.X + x) / 64.0f);
+            }
+        }
+    }
+
+    const FString Filename = FPaths::AutomationTransientDir() / TEXT("PrettyPostProcess")
+        / FString::Printf(TEXT("RoundTrip.%s"), FPostProcessCapture::Extension);
+
+    if (!TestTrue(TEXT("Save"), Capture.Save(Filename)))
+    {
+        return false;
+    }
+
+    {
+        const TUniquePtr<FPostProcessCapture> Loaded = FPostProcessCapture::Load(Filename);
+
+        if (TestTrue(TEXT("Load"), Loaded.IsValid()))
+        {
+            TestEqual(TEXT("Extent"), Loaded->Extent, Capture.Extent);
+            TestEqual(TEXT("ViewRect"), Loaded->ViewRect, Capture.ViewRect);
+            TestEqual(TEXT("ViewSize"), Loaded->ViewSize, Capture.ViewSize);
+            TestTrue(TEXT("Quality"), Loaded->Quality == Capture.Quality);
+            TestTrue(TEXT("Preset"), Loaded->Preset == Capture.Preset);
+            TestEqual(TEXT("Mobile"), Loaded->bMobile, Capture.bMobile);
+            TestEqual(TEXT("ConsoleVariables"), Loaded->ConsoleVariables.Num(), Capture.ConsoleVariables.Num());
+            TestEqual(TEXT("DataAssetPath"), Loaded->DataAssetPath, Capture.DataAssetPath);
+            TestEqual(TEXT("PluginVersion"), Loaded->PluginVersion, Capture.PluginVersion);
+            TestEqual(TEXT("Size"), Loaded->GetSize(), Size);
+
+            for (const TPair<FString, FString>& Variable : Capture.ConsoleVariables)
+            {
+                const FString* Value = Loaded->ConsoleVariables.Find(Variable.Key);
+                TestTrue(*FString::Printf(TEXT("Console variable %s"), *Variable.Key), Value != nullptr && *Value == Variable.Value);
+            }
+
+            if (const UPostProcessDataAsset* LoadedAsset = Loaded->CreateDataAsset())
+            {
+                TestEqual(TEXT("FlareIntensity"), LoadedAsset->FlareIntensity, Asset->FlareIntensity);
+            }
+            else
+            {
+                AddError(TEXT("CreateDataAsset"));
+            }
+
+            if (Loaded->GetSize() == Size)
+            {
+                int32 Mismatches = 0;
+
+                for (int32 Channel = 0; Channel < 3; Channel++)
+                {
+                    for (int32 y = 0; y < Size.Y; y++)
+                    {
+                        Mismatches += FMemory::Memcmp(Loaded->GetRow(Channel, y), Capture.GetRow(Channel, y), Size.X * sizeof(FFloat16)) != 0;
+                    }
+                }
+
+                TestEqual(TEXT("Rows that differ"), Mismatches, 0);
+            }
+        }
+    }
+
+    // The loaded capture (and its mapped file) is gone by now
+    IFileManager::Get().Delete(*Filename);
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,25 @@
+// Copyright 2021 Invasion Games. All rights reserved.
+
+#include "PostProcessDataAsset.h"
+#include "Engine/Texture2D.h"
+
+void UPostProcessDataAsset::GetTexturePaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+    for (const TSoftObjectPtr<UTexture2D>* Texture : { &FlareGradient, &StarburstNoise, &GlareLineMask })
+    {
+        if (!Texture->IsNull())
+        {
+            OutPaths.AddUnique(Texture->ToSoftObjectPath());
+        }
+    }
+}
+
+#if WITH_EDITOR
+void UPostProcessDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+    // Bumped first, the base class broadcasts the change
+    Revision++;
+
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+}
+#endif
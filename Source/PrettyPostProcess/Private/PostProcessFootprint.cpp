@@ -0,0 +1,151 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessFootprint.h"
+#include "PostProcessStructure.h"
+#include "PrettyPostProcess.h"
+
+namespace
+{
+    double ToMegabytes(uint64 SizeInBytes)
+    {
+        return double(SizeInBytes) / (1024.0 * 1024.0);
+    }
+}
+
+uint64 FPostProcessFootprint::GetTextureSize(const FIntPoint& Extent, EPixelFormat Format)
+{
+    const FPixelFormatInfo& FormatInfo = GPixelFormats[Format];
+
+    const uint64 BlockCount =
+        uint64(FMath::DivideAndRoundUp(Extent.X, FormatInfo.BlockSizeX))
+        * uint64(FMath::DivideAndRoundUp(Extent.Y, FormatInfo.BlockSizeY));
+
+    // Mips and arrays are ignored, the plugin never allocates any
+    return BlockCount * FormatInfo.BlockBytes;
+}
+
+void FPostProcessFootprint::AddExternal(FRDGTextureRef Texture)
+{
+    if (Texture != nullptr)
+    {
+        ExternalTextures.Add(Texture);
+    }
+}
+
+void FPostProcessFootprint::AddPass(const TCHAR* PassName, const FRDGParameterStruct& PassParameters)
+{
+    PassNames.Add(PassName);
+
+    PassParameters.EnumerateTextures([this](FRDGParameter Parameter)
+        {
+            switch (Parameter.GetType())
+            {
+            case UBMT_RDG_TEXTURE:
+                Use(Parameter.GetAsTexture());
+                break;
+
+            case UBMT_RDG_TEXTURE_ACCESS:
+                Use(Parameter.GetAsTextureAccess().GetTexture());
+                break;
+
+            case UBMT_RDG_TEXTURE_SRV:
+                if (FRDGTextureSRVRef SRV = Parameter.GetAsTextureSRV())
+                {
+                    Use(SRV->GetParent());
+                }
+                break;
+
+            case UBMT_RDG_TEXTURE_UAV:
+                if (FRDGTextureUAVRef UAV = Parameter.GetAsTextureUAV())
+                {
+                    Use(UAV->GetParent());
+                }
+                break;
+
+            case UBMT_RENDER_TARGET_BINDING_SLOTS:
+                Parameter.GetAsRenderTargetBindingSlots().Enumerate([this](const FRenderTargetBinding& RenderTarget)
+                    {
+                        Use(RenderTarget.GetTexture());
+                    });
+                break;
+
+            default:
+                break;
+            }
+        });
+}
+
+void FPostProcessFootprint::Use(FRDGTextureRef Texture)
+{
+    if (Texture == nullptr || ExternalTextures.Contains(Texture))
+    {
+        return;
+    }
+
+    const int32 PassIndex = PassNames.Num() - 1;
+
+    for (FTextureLifetime& Lifetime : Textures)
+    {
+        if (Lifetime.Texture == Texture)
+        {
+            Lifetime.LastPass = PassIndex;
+            return;
+        }
+    }
+
+    FTextureLifetime& Lifetime = Textures.AddDefaulted_GetRef();
+    Lifetime.Texture = Texture;
+    Lifetime.SizeInBytes = GetTextureSize(Texture->Desc.Extent, Texture->Desc.Format);
+    Lifetime.FirstPass = PassIndex;
+    Lifetime.LastPass = PassIndex;
+}
+
+void FPostProcessFootprint::Dump(const FIntRect& ViewRect) const
+{
+    FPostProcessStructure Structure;
+    GetStructure(Structure);
+
+    int32 PeakPass = 0;
+    const uint64 PeakBytes = Structure.GetPeakBytes(&PeakPass);
+
+    UE_LOG(LogPrettyPostProcess, Display,
+        TEXT("Footprint of view %dx%d: %d passes, %d textures, %.2f MB peak at pass %d (%s), %.2f MB without aliasing"),
+        ViewRect.Width(), ViewRect.Height(),
+        PassNames.Num(), Textures.Num(),
+        ToMegabytes(PeakBytes), PeakPass,
+        PassNames.IsValidIndex(PeakPass) ? *PassNames[PeakPass] : TEXT(""),
+        ToMegabytes(Structure.GetTotalBytes())
+    );
+
+    for (const FPostProcessStructure::FTexture& Texture : Structure.GetTextures())
+    {
+        UE_LOG(LogPrettyPostProcess, Display,
+            TEXT("  [%3d - %3d] %8.2f MB %5dx%-5d %-20s %s"),
+            Texture.FirstPass, Texture.LastPass,
+            ToMegabytes(Texture.SizeInBytes),
+            Texture.Extent.X, Texture.Extent.Y,
+            GPixelFormats[Texture.Format].Name,
+            *Texture.Name
+        );
+    }
+}
+
+void FPostProcessFootprint::GetStructure(FPostProcessStructure& OutStructure) const
+{
+    for (const FString& PassName : PassNames)
+    {
+        OutStructure.AddPass(PassName);
+    }
+
+    for (const FTextureLifetime& Lifetime : Textures)
+    {
+        FPostProcessStructure::FTexture Texture;
+        Texture.Name = Lifetime.Texture->Name;
+        Texture.Extent = Lifetime.Texture->Desc.Extent;
+        Texture.Format = Lifetime.Texture->Desc.Format;
+        Texture.SizeInBytes = Lifetime.SizeInBytes;
+        Texture.FirstPass = Lifetime.FirstPass;
+        Texture.LastPass = Lifetime.LastPass;
+        OutStructure.AddTexture(Texture);
+    }
+}
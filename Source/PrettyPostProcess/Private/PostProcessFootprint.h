@@ -0,0 +1,53 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphBuilder.h"
+
+class FPostProcessStructure;
+
+// Transient memory footprint of one view.
+// Every pass recorded by the plugin reports the textures it reads and
+// writes, which gives the lifetime of each texture (first and last pass,
+// in recording order). The peak is the largest sum of textures alive at
+// the same pass, which is what the transient allocator can at best alias
+// the pipeline down to. Only allocated when a dump is requested.
+class FPostProcessFootprint
+{
+public:
+    // Textures the plugin doesn't allocate (scene color, dummies)
+    void AddExternal(FRDGTextureRef Texture);
+
+    template<typename TShaderParameters>
+    void AddPass(const TCHAR* PassName, const TShaderParameters* PassParameters)
+    {
+        AddPass(PassName, FRDGParameterStruct(PassParameters));
+    }
+
+    void AddPass(const TCHAR* PassName, const FRDGParameterStruct& PassParameters);
+
+    // Print the lifetimes and the peak to the log
+    void Dump(const FIntRect& ViewRect) const;
+
+    // Pass names and texture lifetimes, to be checked against a baseline
+    void GetStructure(FPostProcessStructure& OutStructure) const;
+
+    // Memory of a transient texture (single mip, no array)
+    static uint64 GetTextureSize(const FIntPoint& Extent, EPixelFormat Format);
+
+private:
+    struct FTextureLifetime
+    {
+        FRDGTextureRef Texture = nullptr;
+        uint64 SizeInBytes = 0;
+        int32 FirstPass = 0;
+        int32 LastPass = 0;
+    };
+
+    void Use(FRDGTextureRef Texture);
+
+    TArray<FString> PassNames;
+    TArray<FTextureLifetime> Textures;
+    TSet<FRDGTextureRef> ExternalTextures;
+};
@@ -0,0 +1,143 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessSettingsProxy.h"
+#include "PostProcessDataAsset.h"
+#include "Engine/Texture2D.h"
+#include "TextureResource.h"
+
+IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FPrettyPostProcessSettingsParameters, "PrettyPostProcess");
+
+static_assert(FPostProcessSettingsProxy::MaxGhosts == 8, "GhostColors and GhostScales are sized for 8 ghosts");
+
+namespace
+{
+    // Textures that are not loaded yet resolve to null and fall back to white
+    const FTextureReference* GetTextureReference(const TSoftObjectPtr<UTexture2D>& SoftTexture)
+    {
+        const UTexture2D* Texture = SoftTexture.Get();
+        return Texture != nullptr ? &Texture->TextureReference : nullptr;
+    }
+
+    FTextureReferenceRHIRef GetTextureReferenceRHI(const FTextureReference* Reference)
+    {
+        return Reference != nullptr ? Reference->TextureReferenceRHI : FTextureReferenceRHIRef();
+    }
+
+    FRHITexture* GetTextureRHI(const FTextureReferenceRHIRef& Reference)
+    {
+        return Reference.IsValid()
+            ? Reference.GetReference()
+            : GWhiteTexture->TextureRHI.GetReference();
+    }
+}
+
+FPostProcessSettingsProxy::FPostProcessSettingsProxy(const UPostProcessDataAsset& Asset)
+{
+    check(IsInGameThread());
+
+    Revision = Asset.Revision;
+    BlurSteps = Asset.BlurSteps;
+
+    // Flare
+    Parameters.FlareIntensity = Asset.FlareIntensity;
+    Parameters.FlareTint = FVector4f(Asset.FlareTint);
+
+    // Ghosts
+    Parameters.GhostIntensity = Asset.GhostIntensity;
+    Parameters.GhostChromaShift = Asset.GhostChromaShift;
+    Parameters.GhostCompression = Asset.GhostCompression;
+
+    const FLensFlareGhostSettings* Ghosts[MaxGhosts] = {
+        &Asset.Ghost1,
+        &Asset.Ghost2,
+        &Asset.Ghost3,
+        &Asset.Ghost4,
+        &Asset.Ghost5,
+        &Asset.Ghost6,
+        &Asset.Ghost7,
+        &Asset.Ghost8
+    };
+
+    for (int32 i = 0; i < MaxGhosts; i++)
+    {
+        Parameters.GhostColors[i] = FVector4f(0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    Parameters.GhostScales[0] = FVector4f(0.0f, 0.0f, 0.0f, 0.0f);
+    Parameters.GhostScales[1] = FVector4f(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // Only the visible ghosts are packed at the front of the arrays, the
+    // shader loop (and the quality presets) can then stop early.
+    for (const FLensFlareGhostSettings* Ghost : Ghosts)
+    {
+        if (FMath::Abs(Ghost->Color.A * Ghost->Scale) <= 0.0001f)
+        {
+            continue;
+        }
+
+        Parameters.GhostColors[GhostCount] = FVector4f(Ghost->Color);
+        Parameters.GhostScales[GhostCount / 4][GhostCount % 4] = Ghost->Scale;
+        GhostCount++;
+    }
+
+    // Halo
+    Parameters.HaloIntensity = Asset.HaloIntensity;
+    Parameters.HaloWidth = Asset.HaloWidth;
+    Parameters.HaloMask = Asset.HaloMask;
+    Parameters.HaloCompression = Asset.HaloCompression;
+    Parameters.HaloChromaShift = Asset.HaloChromaShift;
+
+    // Starburst
+    Parameters.StarburstIntensity = Asset.StarburstIntensity;
+    Parameters.StarburstOffset = Asset.StarburstOffset;
+
+    // Glare
+    Parameters.GlareIntensity = Asset.GlareIntensity;
+    Parameters.GlareDivider = FMath::Max(Asset.GlareDivider, 0.01f);
+    Parameters.GlareTint = FVector4f(Asset.GlareTint);
+    Parameters.GlareScales = FVector4f(
+        float(Asset.GlareScale.X),
+        float(Asset.GlareScale.Y),
+        float(Asset.GlareScale.Z),
+        0.0f
+    );
+
+    // Textures
+    PendingFlareGradient = GetTextureReference(Asset.FlareGradient);
+    PendingStarburstNoise = GetTextureReference(Asset.StarburstNoise);
+    PendingGlareLineMask = GetTextureReference(Asset.GlareLineMask);
+    bStarburstNoise = PendingStarburstNoise != nullptr;
+}
+
+void FPostProcessSettingsProxy::InitRHI()
+{
+    check(IsInRenderingThread());
+
+    FlareGradient = GetTextureReferenceRHI(PendingFlareGradient);
+    StarburstNoise = GetTextureReferenceRHI(PendingStarburstNoise);
+    GlareLineMask = GetTextureReferenceRHI(PendingGlareLineMask);
+
+    PendingFlareGradient = nullptr;
+    PendingStarburstNoise = nullptr;
+    PendingGlareLineMask = nullptr;
+
+    UniformBuffer = TUniformBufferRef<FPrettyPostProcessSettingsParameters>::CreateUniformBufferImmediate(
+        Parameters,
+        UniformBuffer_MultiFrame
+    );
+}
+
+FRHITexture* FPostProcessSettingsProxy::GetFlareGradient() const
+{
+    return GetTextureRHI(FlareGradient);
+}
+
+FRHITexture* FPostProcessSettingsProxy::GetStarburstNoise() const
+{
+    return GetTextureRHI(StarburstNoise);
+}
+
+FRHITexture* FPostProcessSettingsProxy::GetGlareLineMask() const
+{
+    return GetTextureRHI(GlareLineMask);
+}
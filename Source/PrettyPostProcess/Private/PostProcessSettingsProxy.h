@@ -0,0 +1,95 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShaderParameterMacros.h"
+#include "UniformBuffer.h"
+
+class UPostProcessDataAsset;
+class FTextureReference;
+
+// Data asset settings as seen by the shaders ("PrettyPostProcess" in HLSL).
+// Every pass binds this single buffer, it is only rebuilt when the asset
+// changes. Vectors come first and scalars are grouped at the end so the
+// layout doesn't need any padding between members.
+BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FPrettyPostProcessSettingsParameters, )
+    SHADER_PARAMETER(FVector4f, FlareTint)
+    SHADER_PARAMETER(FVector4f, GlareTint)
+    SHADER_PARAMETER(FVector4f, GlareScales)
+    // Visible ghosts only, packed at the front
+    SHADER_PARAMETER_ARRAY(FVector4f, GhostColors, [8])
+    // Four ghost scales per element
+    SHADER_PARAMETER_ARRAY(FVector4f, GhostScales, [2])
+    SHADER_PARAMETER(float, FlareIntensity)
+    SHADER_PARAMETER(float, GhostIntensity)
+    SHADER_PARAMETER(float, GhostChromaShift)
+    SHADER_PARAMETER(float, GhostCompression)
+    SHADER_PARAMETER(float, HaloIntensity)
+    SHADER_PARAMETER(float, HaloWidth)
+    SHADER_PARAMETER(float, HaloMask)
+    SHADER_PARAMETER(float, HaloCompression)
+    SHADER_PARAMETER(float, HaloChromaShift)
+    SHADER_PARAMETER(float, StarburstIntensity)
+    SHADER_PARAMETER(float, StarburstOffset)
+    SHADER_PARAMETER(float, GlareIntensity)
+    SHADER_PARAMETER(float, GlareDivider)
+END_GLOBAL_SHADER_PARAMETER_STRUCT()
+
+// Immutable render thread snapshot of a UPostProcessDataAsset.
+// Built on the game thread whenever the asset changes and handed over
+// with a render command, so the render thread never reads the UObject
+// that the game thread (or the editor) may be modifying.
+class FPostProcessSettingsProxy
+{
+public:
+    static constexpr int32 MaxGhosts = 8;
+
+    // Game thread, copies the settings
+    explicit FPostProcessSettingsProxy(const UPostProcessDataAsset& Asset);
+
+    // Render thread, uploads the uniform buffer and takes the textures
+    void InitRHI();
+
+    // Textures of the asset, white when not set
+    FRHITexture* GetFlareGradient() const;
+    FRHITexture* GetStarburstNoise() const;
+    FRHITexture* GetGlareLineMask() const;
+
+    const FPrettyPostProcessSettingsParameters& GetParameters() const { return Parameters; }
+    const TUniformBufferRef<FPrettyPostProcessSettingsParameters>& GetUniformBuffer() const { return UniformBuffer; }
+
+    // Whether the asset has a starburst texture (GetStarburstNoise() is
+    // the white fallback otherwise)
+    bool HasStarburstNoise() const { return bStarburstNoise; }
+
+    // Number of visible ghosts in the packed arrays
+    int32 GetGhostCount() const { return GhostCount; }
+
+    int32 GetBlurSteps() const { return BlurSteps; }
+
+    // UPostProcessDataAsset::Revision at the time of the snapshot
+    uint32 GetRevision() const { return Revision; }
+
+private:
+    FPrettyPostProcessSettingsParameters Parameters;
+    TUniformBufferRef<FPrettyPostProcessSettingsParameters> UniformBuffer;
+
+    int32 GhostCount = 0;
+    int32 BlurSteps = 0;
+    uint32 Revision = 0;
+
+    bool bStarburstNoise = false;
+
+    // Texture references of the asset, only read by InitRHI. It is queued
+    // right after the snapshot, so before any render command releasing them.
+    const FTextureReference* PendingFlareGradient = nullptr;
+    const FTextureReference* PendingStarburstNoise = nullptr;
+    const FTextureReference* PendingGlareLineMask = nullptr;
+
+    // Taken on the render thread, they keep the textures alive and follow
+    // their streamed mips
+    FTextureReferenceRHIRef FlareGradient;
+    FTextureReferenceRHIRef StarburstNoise;
+    FTextureReferenceRHIRef GlareLineMask;
+};
@@ -0,0 +1,178 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessStaticCache.h"
+
+namespace
+{
+    // Cells darker than this don't count as a relative change,
+    // leaving room for the noise of nearly black areas
+    constexpr float DifferenceFloor = 0.01f;
+
+    // Matrices are compared within this tolerance
+    constexpr float MatrixTolerance = 1.e-4f;
+}
+
+bool FPostProcessStaticCacheKey::Matches(const FPostProcessStaticCacheKey& Other) const
+{
+    return PlanKey == Other.PlanKey
+        && BloomRadius == Other.BloomRadius
+        && bTileMax == Other.bTileMax
+        && TileMaxThreshold == Other.TileMaxThreshold
+        && SkipState.bSkipFlare == Other.SkipState.bSkipFlare
+        && SkipState.bSkipGlare == Other.SkipState.bSkipGlare
+        && ViewMatrix.Equals(Other.ViewMatrix, MatrixTolerance)
+        && ProjectionMatrix.Equals(Other.ProjectionMatrix, MatrixTolerance);
+}
+
+bool FPostProcessStaticCache::Update(
+    uint32 ViewKey,
+    const FPostProcessStaticCacheKey& Key,
+    float Threshold,
+    int32 MinStaticFrames,
+    TRefCountPtr<IPooledRenderTarget>& OutTexture,
+    FIntRect& OutViewRect
+)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    FViewReadbacks::FView& ViewReadbacks = Views.FindOrAdd(ViewKey);
+    FViewState* View = &ViewReadbacks.Data;
+
+    // Camera, view size or settings changed
+    if (!View->Key.Matches(Key))
+    {
+        View->bDirty = true;
+    }
+
+    FViewReadbacks::ReadCompleted(ViewReadbacks, [&](FViewReadbacks::FReadback& Readback)
+        {
+            TArray<float> Signature;
+
+            if (!ReadSignature(Readback, Signature))
+            {
+                // A copy that couldn't be read never lets the cache be used
+                View->bDirty = true;
+            }
+            else if (Readback.FrameNumber >= View->ReferenceFrame && !View->bDirty)
+            {
+                if (View->Reference.Num() == 0)
+                {
+                    View->Reference = MoveTemp(Signature);
+                }
+                else if (GetDifference(View->Reference, Signature) <= Threshold)
+                {
+                    View->StaticFrames++;
+                }
+                else
+                {
+                    View->bDirty = true;
+                }
+            }
+        });
+
+    // Don't keep the output alive while the view keeps changing
+    if (View->bDirty)
+    {
+        View->Output.SafeRelease();
+        return false;
+    }
+
+    if (!View->Output.IsValid() || View->Reference.Num() == 0 || View->StaticFrames < MinStaticFrames)
+    {
+        return false;
+    }
+
+    OutTexture = View->Output;
+    OutViewRect = View->OutputRect;
+
+    return true;
+}
+
+void FPostProcessStaticCache::Store(uint32 ViewKey, const FPostProcessStaticCacheKey& Key, const TRefCountPtr<IPooledRenderTarget>& Texture, const FIntRect& ViewRect)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    FViewReadbacks::FView* ViewReadbacks = Views.Find(ViewKey);
+
+    if (ViewReadbacks == nullptr)
+    {
+        return;
+    }
+
+    FViewState* View = &ViewReadbacks->Data;
+
+    // Start over from this frame, the signatures of the
+    // frames before are still in flight and will be ignored
+    if (View->bDirty)
+    {
+        View->Key = Key;
+        View->Reference.Reset();
+        View->ReferenceFrame = GFrameCounterRenderThread;
+        View->StaticFrames = 0;
+        View->bDirty = false;
+    }
+
+    View->Output = Texture;
+    View->OutputRect = ViewRect;
+}
+
+void FPostProcessStaticCache::AddReadback(FRDGBuilder& GraphBuilder, uint32 ViewKey, FRDGTextureRef SignatureTexture)
+{
+    FScopeLock Lock(&CriticalSection);
+
+    if (FViewReadbacks::FView* View = Views.Find(ViewKey))
+    {
+        FViewReadbacks::AddReadback(
+            GraphBuilder,
+            *View,
+            SignatureTexture,
+            FIntPoint(SignatureSize, SignatureSize),
+            TEXT("PrettyPostProcess.SignatureReadback")
+        );
+    }
+}
+
+void FPostProcessStaticCache::Reset()
+{
+    FScopeLock Lock(&CriticalSection);
+
+    Views.Reset();
+}
+
+bool FPostProcessStaticCache::ReadSignature(FViewReadbacks::FReadback& Readback, TArray<float>& OutSignature)
+{
+    int32 RowPitchInPixels = 0;
+    const float* Cells = static_cast<const float*>(Readback.Readback->Lock(RowPitchInPixels));
+
+    if (Cells == nullptr)
+    {
+        return false;
+    }
+
+    OutSignature.SetNumUninitialized(SignatureSize * SignatureSize);
+
+    for (int32 y = 0; y < SignatureSize; y++)
+    {
+        for (int32 x = 0; x < SignatureSize; x++)
+        {
+            OutSignature[y * SignatureSize + x] = Cells[y * RowPitchInPixels + x];
+        }
+    }
+
+    Readback.Readback->Unlock();
+
+    return true;
+}
+
+float FPostProcessStaticCache::GetDifference(const TArray<float>& Reference, const TArray<float>& Signature)
+{
+    float Difference = 0.0f;
+
+    for (int32 i = 0; i < Reference.Num(); i++)
+    {
+        const float Delta = FMath::Abs(Signature[i] - Reference[i]);
+        Difference = FMath::Max(Difference, Delta / FMath::Max3(Reference[i], Signature[i], DifferenceFloor));
+    }
+
+    return Difference;
+}
@@ -0,0 +1,97 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphBuilder.h"
+#include "PostProcessAutoSkip.h"
+#include "PostProcessSubsystem.h"
+#include "PostProcessViewReadbacks.h"
+
+// Everything besides the scene color a cached output depends on
+struct FPostProcessStaticCacheKey
+{
+    FPostProcessPassPlanKey PlanKey;
+
+    // Console variables read past the plan (r.PrettyPostProcess.BloomRadius,
+    // r.PrettyPostProcess.TileMax and r.PrettyPostProcess.TileMax.Threshold)
+    float BloomRadius = 0.0f;
+    bool bTileMax = false;
+    float TileMaxThreshold = 0.0f;
+
+    // Stages dropped by r.PrettyPostProcess.AutoSkip this frame
+    FPostProcessSkipState SkipState;
+
+    // Without the temporal AA jitter, which changes every frame
+    FMatrix ViewMatrix = FMatrix::Identity;
+    FMatrix ProjectionMatrix = FMatrix::Identity;
+
+    bool Matches(const FPostProcessStaticCacheKey& Other) const;
+};
+
+// Reuses the output of a view while nothing changes (r.PrettyPostProcess.StaticCache):
+// menus, pause screens, photo mode, cutscene holds. The output of each
+// view is kept and returned as is as long as its camera and settings stay
+// the same and the signature of its scene color (SignatureCS, read back a
+// few frames later without ever waiting on the GPU) stays within a
+// threshold of the one the cache started from. A change of the scene
+// color is noticed with the readback latency, so the cache only kicks in
+// after a number of static frames in a row. Render thread only, views
+// recorded in parallel are serialized by the lock.
+class FPostProcessStaticCache
+{
+public:
+    // Grid of cells the scene color is reduced to
+    static constexpr int32 SignatureSize = 16;
+
+    // Consume the signatures of a view that were read back and return its
+    // cached output when it can be reused this frame
+    bool Update(
+        uint32 ViewKey,
+        const FPostProcessStaticCacheKey& Key,
+        float Threshold,
+        int32 MinStaticFrames,
+        TRefCountPtr<IPooledRenderTarget>& OutTexture,
+        FIntRect& OutViewRect
+    );
+
+    // Keep the output of a view that went through the whole pipeline
+    void Store(uint32 ViewKey, const FPostProcessStaticCacheKey& Key, const TRefCountPtr<IPooledRenderTarget>& Texture, const FIntRect& ViewRect);
+
+    // Copy back the signature of a view, unless all its readbacks are still in flight
+    void AddReadback(FRDGBuilder& GraphBuilder, uint32 ViewKey, FRDGTextureRef SignatureTexture);
+
+    // Drop every view, output and pending readback
+    void Reset();
+
+private:
+    struct FViewState
+    {
+        FPostProcessStaticCacheKey Key;
+
+        // Latest output rendered since the cache started
+        TRefCountPtr<IPooledRenderTarget> Output;
+        FIntRect OutputRect;
+
+        // First signature read back since the cache started (empty until
+        // then), and the frame it started on
+        TArray<float> Reference;
+        uint64 ReferenceFrame = 0;
+
+        // Signatures in a row within the threshold of the reference
+        int32 StaticFrames = 0;
+
+        // Something changed, the next output starts the cache over
+        bool bDirty = true;
+    };
+
+    using FViewReadbacks = TPostProcessViewReadbacks<FViewState>;
+
+    static bool ReadSignature(FViewReadbacks::FReadback& Readback, TArray<float>& OutSignature);
+
+    // Largest relative change of a cell
+    static float GetDifference(const TArray<float>& Reference, const TArray<float>& Signature);
+
+    FViewReadbacks Views;
+    FCriticalSection CriticalSection;
+};
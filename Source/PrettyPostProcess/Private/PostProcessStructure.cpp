@@ -0,0 +1,91 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessStructure.h"
+#include "PostProcessFootprint.h"
+
+void FPostProcessStructure::AddPass(const FString& Name)
+{
+    Passes.Add(Name);
+}
+
+void FPostProcessStructure::AddTexture(const FTexture& Texture)
+{
+    Textures.Add(Texture);
+}
+
+int32 FPostProcessStructure::CreateTexture(const FString& Name, const FIntPoint& Extent, EPixelFormat Format)
+{
+    FTexture& Texture = Textures.AddDefaulted_GetRef();
+    Texture.Name = Name;
+    Texture.Extent = Extent;
+    Texture.Format = Format;
+    Texture.SizeInBytes = FPostProcessFootprint::GetTextureSize(Extent, Format);
+
+    return Textures.Num() - 1;
+}
+
+void FPostProcessStructure::AddPass(const FString& Name, std::initializer_list<int32> UsedTextures)
+{
+    const int32 PassIndex = Passes.Add(Name);
+
+    for (int32 TextureIndex : UsedTextures)
+    {
+        if (TextureIndex == INDEX_NONE)
+        {
+            continue;
+        }
+
+        FTexture& Texture = Textures[TextureIndex];
+
+        if (Texture.FirstPass == INDEX_NONE)
+        {
+            Texture.FirstPass = PassIndex;
+        }
+
+        Texture.LastPass = PassIndex;
+    }
+}
+
+uint64 FPostProcessStructure::GetTotalBytes() const
+{
+    uint64 TotalBytes = 0;
+
+    for (const FTexture& Texture : Textures)
+    {
+        TotalBytes += Texture.SizeInBytes;
+    }
+
+    return TotalBytes;
+}
+
+uint64 FPostProcessStructure::GetPeakBytes(int32* OutPeakPass) const
+{
+    uint64 PeakBytes = 0;
+    int32 PeakPass = 0;
+
+    for (int32 PassIndex = 0; PassIndex < Passes.Num(); PassIndex++)
+    {
+        uint64 AliveBytes = 0;
+
+        for (const FTexture& Texture : Textures)
+        {
+            if (Texture.FirstPass <= PassIndex && PassIndex <= Texture.LastPass)
+            {
+                AliveBytes += Texture.SizeInBytes;
+            }
+        }
+
+        if (AliveBytes > PeakBytes)
+        {
+            PeakBytes = AliveBytes;
+            PeakPass = PassIndex;
+        }
+    }
+
+    if (OutPeakPass != nullptr)
+    {
+        *OutPeakPass = PeakPass;
+    }
+
+    return PeakBytes;
+}
@@ -0,0 +1,47 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+
+// Passes and textures of the graph of a view, either as Render() recorded
+// them (see UPostProcessSubsystem::SetStructureCallback) or as its plan
+// describes them (UPostProcessSubsystem::DescribePassPlan), so the
+// structure of the graph can be checked against a baseline. Lifetimes
+// and the peak follow the same rules as FPostProcessFootprint: a texture
+// is alive from the first to the last pass using it, external ones
+// (scene color, dummies) are left out.
+class FPostProcessStructure
+{
+public:
+    struct FTexture
+    {
+        FString Name;
+        FIntPoint Extent = FIntPoint::ZeroValue;
+        EPixelFormat Format = PF_Unknown;
+        uint64 SizeInBytes = 0;
+        int32 FirstPass = INDEX_NONE;
+        int32 LastPass = INDEX_NONE;
+    };
+
+    void AddPass(const FString& Name);
+    void AddTexture(const FTexture& Texture);
+
+    // Describing: a texture is created, then passes use it (which sets its
+    // lifetime). Returns the index of the texture, INDEX_NONE stands for
+    // the external ones in a pass.
+    int32 CreateTexture(const FString& Name, const FIntPoint& Extent, EPixelFormat Format);
+    void AddPass(const FString& Name, std::initializer_list<int32> UsedTextures);
+
+    const TArray<FString>& GetPasses() const { return Passes; }
+    const TArray<FTexture>& GetTextures() const { return Textures; }
+
+    // Memory of the textures, without and with aliasing
+    uint64 GetTotalBytes() const;
+    uint64 GetPeakBytes(int32* OutPeakPass = nullptr) const;
+
+private:
+    TArray<FString> Passes;
+    TArray<FTexture> Textures;
+};
@@ -0,0 +1,918 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessStructureCheck.h"
+#include "PostProcessDataAsset.h"
+#include "PostProcessSettingsProxy.h"
+#include "PostProcessStructure.h"
+#include "PostProcessSubsystem.h"
+#include "PrettyPostProcess.h"
+#include "Components/SceneCaptureComponent2D.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PreviewScene.h"
+#include "RHI.h"
+#include "RenderingThread.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/Package.h"
+#include "UObject/StrongObjectPtr.h"
+
+namespace
+{
+    // Bumped when the layout of the report (and baseline) changes
+    constexpr int32 StructureSchemaVersion = 3;
+
+    // Timings for the cases the baseline has none for (it was written on
+    // another machine, or without -Render)
+    constexpr double PlanBudgetMicroseconds = 50.0;
+    constexpr double RenderBudgetMicroseconds = 2000.0;
+
+    // A view rendered with a given set of settings. The defaults are the
+    // reference: a 1080p view rendered like a main view, with the Epic
+    // preset, the default console variables and the data asset as authored,
+    // on an SM5 RHI that supports R11G11B10 everywhere.
+    struct FStructureCase
+    {
+        FString Name;
+
+        // Size of the view, the scene color is half of it
+        FIntPoint ViewSize = FIntPoint(1920, 1080);
+
+        // Dynamic resolution: the part of the view (and of the scene
+        // color, whose extent doesn't change) that is rendered
+        float ScreenPercentage = 1.0f;
+
+        int32 Quality = 3;
+
+        // Pipeline policy of the view. Rendered cases are scene captures,
+        // r.PrettyPostProcess.SceneCaptureQuality gives them this one.
+        EPostProcessViewQuality ViewQuality = EPostProcessViewQuality::Full;
+
+        // Console variables
+        int32 BloomPassAmount = 7;
+        int32 BloomResLimit = 16;
+        bool bRenderFlare = true;
+        bool bRenderHalo = true;
+        bool bRenderGlare = true;
+        bool bTileMax = true;
+        bool bAsyncCompute = false;
+        bool bMobileGlare = true;
+
+        // RHI: mobile feature level (ES3.1) and R11G11B10 support, so the
+        // formats in the baseline don't depend on the machine
+        bool bMobile = false;
+        bool bR11G11B10RenderTarget = true;
+        bool bR11G11B10TypedUAVStore = true;
+
+        // Data asset edits
+        TFunction<void(UPostProcessDataAsset&)> EditAsset;
+
+        // Passes (name prefixes) that must not be there
+        TArray<FString> PrunedPasses;
+    };
+
+    // What the structure callback got for a view
+    struct FRecordedView
+    {
+        FPostProcessRenderContext Context;
+        FPostProcessStructure Structure;
+        double RenderMicroseconds = 0.0;
+    };
+
+    const TArray<FString> FlarePasses = { TEXT("FlareGhosts"), TEXT("KawaseBlur"), TEXT("FlareStarburst") };
+    const TArray<FString> HaloPasses = { TEXT("HaloPass") };
+    const TArray<FString> GlarePasses = { TEXT("GlareRenderPass") };
+
+    TArray<FString> Combine(std::initializer_list<TArray<FString>> Lists)
+    {
+        TArray<FString> Result;
+
+        for (const TArray<FString>& List : Lists)
+        {
+            Result.Append(List);
+        }
+
+        return Result;
+    }
+
+    TArray<FStructureCase> BuildCases()
+    {
+        TArray<FStructureCase> Cases;
+
+        // Every preset at every resolution
+        static const TPair<const TCHAR*, FIntPoint> Resolutions[] =
+        {
+            { TEXT("720p"), FIntPoint(1280, 720) },
+            { TEXT("1080p"), FIntPoint(1920, 1080) },
+            { TEXT("1440p"), FIntPoint(2560, 1440) },
+            { TEXT("4K"), FIntPoint(3840, 2160) },
+            { TEXT("Portrait"), FIntPoint(1080, 1920) },
+            { TEXT("Odd"), FIntPoint(1366, 767) }
+        };
+
+        for (int32 Quality = 0; Quality <= 4; Quality++)
+        {
+            for (const TPair<const TCHAR*, FIntPoint>& Resolution : Resolutions)
+            {
+                FStructureCase& Case = Cases.AddDefaulted_GetRef();
+                Case.Name = FString::Printf(TEXT("Q%d_%s"), Quality, Resolution.Key);
+                Case.ViewSize = Resolution.Value;
+                Case.Quality = Quality;
+            }
+        }
+
+        // Then one setting at a time, from the reference
+        const auto AddCase = [&Cases](const TCHAR* Name, TArray<FString> PrunedPasses, TFunction<void(FStructureCase&)> Apply)
+        {
+            FStructureCase& Case = Cases.AddDefaulted_GetRef();
+            Case.Name = Name;
+            Case.PrunedPasses = MoveTemp(PrunedPasses);
+            Apply(Case);
+        };
+
+        // Views (a small view gets the reduced pipeline, below
+        // r.PrettyPostProcess.ReducedViewSize)
+        AddCase(TEXT("SmallView"), Combine({ HaloPasses, GlarePasses }), [](FStructureCase& Case)
+        {
+            Case.ViewSize = FIntPoint(256, 144);
+            Case.ViewQuality = EPostProcessViewQuality::Reduced;
+        });
+        AddCase(TEXT("Reduced"), Combine({ HaloPasses, GlarePasses }), [](FStructureCase& Case) { Case.ViewQuality = EPostProcessViewQuality::Reduced; });
+        AddCase(TEXT("BloomOnly"), Combine({ FlarePasses, HaloPasses, GlarePasses }), [](FStructureCase& Case) { Case.ViewQuality = EPostProcessViewQuality::BloomOnly; });
+        AddCase(TEXT("DynamicResolution"), {}, [](FStructureCase& Case) { Case.ScreenPercentage = 0.7f; });
+
+        // Console variables
+        AddCase(TEXT("BloomPassAmount_1"), Combine({ FlarePasses, HaloPasses, GlarePasses, { TEXT("Downsample"), TEXT("UpsampleCombine") } }), [](FStructureCase& Case) { Case.BloomPassAmount = 1; });
+        AddCase(TEXT("BloomPassAmount_3"), {}, [](FStructureCase& Case) { Case.BloomPassAmount = 3; });
+        AddCase(TEXT("BloomResLimit_256"), {}, [](FStructureCase& Case) { Case.BloomResLimit = 256; });
+        AddCase(TEXT("RenderFlare_0"), FlarePasses, [](FStructureCase& Case) { Case.bRenderFlare = false; });
+        AddCase(TEXT("RenderHalo_0"), HaloPasses, [](FStructureCase& Case) { Case.bRenderHalo = false; });
+        AddCase(TEXT("RenderGlare_0"), GlarePasses, [](FStructureCase& Case) { Case.bRenderGlare = false; });
+        AddCase(TEXT("TileMax_0"), { TEXT("TileMax") }, [](FStructureCase& Case) { Case.bTileMax = false; });
+        AddCase(TEXT("AsyncCompute"), {}, [](FStructureCase& Case) { Case.bAsyncCompute = true; });
+
+        // RHI
+        AddCase(TEXT("AsyncCompute_NoR11G11B10UAV"), {}, [](FStructureCase& Case)
+        {
+            Case.bAsyncCompute = true;
+            Case.bR11G11B10TypedUAVStore = false;
+        });
+        AddCase(TEXT("Mobile"), { TEXT("TileMax"), TEXT("GlareRenderPassSetup") }, [](FStructureCase& Case) { Case.bMobile = true; });
+        AddCase(TEXT("Mobile_NoR11G11B10"), { TEXT("TileMax") }, [](FStructureCase& Case)
+        {
+            Case.bMobile = true;
+            Case.bR11G11B10RenderTarget = false;
+        });
+        AddCase(TEXT("Mobile_Glare_0"), { TEXT("TileMax"), TEXT("GlareRenderPass") }, [](FStructureCase& Case)
+        {
+            Case.bMobile = true;
+            Case.bMobileGlare = false;
+        });
+        AddCase(TEXT("Mobile_AsyncCompute"), { TEXT("TileMax"), TEXT("GlareRenderPassSetup") }, [](FStructureCase& Case)
+        {
+            Case.bMobile = true;
+            Case.bAsyncCompute = true;
+        });
+
+        // Data asset: stages made invisible by their settings are pruned
+        AddCase(TEXT("Asset_FlareIntensity_0"), Combine({ FlarePasses, GlarePasses }), [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.FlareIntensity = 0.0f; };
+        });
+        AddCase(TEXT("Asset_FlareTint_Black"), Combine({ FlarePasses, GlarePasses }), [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.FlareTint = FLinearColor::Black; };
+        });
+        AddCase(TEXT("Asset_GhostIntensity_0"), FlarePasses, [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.GhostIntensity = 0.0f; };
+        });
+        AddCase(TEXT("Asset_BlurSteps_0"), { TEXT("KawaseBlur") }, [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.BlurSteps = 0; };
+        });
+        AddCase(TEXT("Asset_StarburstIntensity_0"), { TEXT("FlareStarburst") }, [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.StarburstIntensity = 0.0f; };
+        });
+        AddCase(TEXT("Asset_HaloIntensity_0"), HaloPasses, [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.HaloIntensity = 0.0f; };
+        });
+        AddCase(TEXT("Asset_GlareIntensity_0"), GlarePasses, [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.GlareIntensity = 0.0f; };
+        });
+        AddCase(TEXT("Asset_GlareScale_0"), GlarePasses, [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset) { Asset.GlareScale = FVector::ZeroVector; };
+        });
+        AddCase(TEXT("Asset_Disabled"), Combine({ FlarePasses, HaloPasses, GlarePasses, { TEXT("TileMax") } }), [](FStructureCase& Case)
+        {
+            Case.EditAsset = [](UPostProcessDataAsset& Asset)
+            {
+                Asset.FlareIntensity = 0.0f;
+                Asset.HaloIntensity = 0.0f;
+            };
+        });
+
+        return Cases;
+    }
+
+    // Console variables set for the duration of the check, restored
+    // afterwards. Set by console so that no ini or command line value wins.
+    class FScopedConsoleVariables
+    {
+    public:
+        ~FScopedConsoleVariables()
+        {
+            for (const TPair<IConsoleVariable*, FString>& Saved : SavedValues)
+            {
+                Saved.Key->Set(*Saved.Value, ECVF_SetByConsole);
+            }
+        }
+
+        void Set(const TCHAR* Name, int32 Value)
+        {
+            IConsoleVariable* Variable = IConsoleManager::Get().FindConsoleVariable(Name);
+
+            if (Variable == nullptr)
+            {
+                UE_LOG(LogPrettyPostProcess, Warning, TEXT("Structure: %s doesn't exist in this engine version"), Name);
+                return;
+            }
+
+            if (!SavedValues.Contains(Variable))
+            {
+                SavedValues.Add(Variable, Variable->GetString());
+            }
+
+            Variable->Set(Value, ECVF_SetByConsole);
+        }
+
+    private:
+        TMap<IConsoleVariable*, FString> SavedValues;
+    };
+
+    // The context Render() makes for the case (see UPostProcessSubsystem::Render)
+    FPostProcessRenderContext MakeContext(const FStructureCase& Case, const FPostProcessSettingsProxy& Settings)
+    {
+        FPostProcessRenderContext Context;
+        Context.Quality = Case.ViewQuality;
+        Context.Preset = FPostProcessQualityPreset::Get(Case.Quality);
+        Context.bMobile = Case.bMobile;
+        Context.bR11G11B10RenderTarget = Case.bR11G11B10RenderTarget;
+        Context.bR11G11B10TypedUAVStore = Case.bR11G11B10TypedUAVStore;
+        Context.bAsyncCompute = Case.bAsyncCompute && !Case.bMobile;
+
+        // The scene color is half of the view, dynamic resolution renders
+        // a smaller part of it
+        const FIntPoint RenderSize(
+            FMath::CeilToInt(Case.ViewSize.X * Case.ScreenPercentage),
+            FMath::CeilToInt(Case.ViewSize.Y * Case.ScreenPercentage)
+        );
+
+        FPostProcessPassPlanKey Key;
+        Key.Extent = FIntPoint::DivideAndRoundUp(Case.ViewSize, 2);
+        Key.ViewRect = FIntRect(FIntPoint::ZeroValue, FIntPoint::DivideAndRoundUp(RenderSize, 2));
+        Key.ViewSize = RenderSize;
+        Key.Quality = Case.ViewQuality;
+        Key.Preset = Context.Preset;
+        Key.BloomPassAmount = Case.BloomPassAmount;
+        Key.BloomResLimit = Case.BloomResLimit;
+        Key.bRenderFlare = Case.bRenderFlare;
+        Key.bRenderHalo = Case.bRenderHalo;
+        Key.bRenderGlare = Case.bRenderGlare && (!Case.bMobile || Case.bMobileGlare);
+        Key.AssetRevision = Settings.GetRevision();
+
+        UPostProcessSubsystem::BuildPassPlan(Settings, Key, Context.Plan);
+
+        Context.bTileMax = Case.bTileMax
+            && !Case.bMobile
+            && (Context.Plan.bRenderFlare || Context.Plan.bRenderHalo || Context.Plan.bRenderGlare);
+
+        return Context;
+    }
+
+    // What DescribePassPlan reads of a context, without the per-call state
+    FPostProcessRenderContext CopyLayout(const FPostProcessRenderContext& Context)
+    {
+        FPostProcessRenderContext Layout;
+        Layout.Quality = Context.Quality;
+        Layout.Preset = Context.Preset;
+        Layout.Plan = Context.Plan;
+        Layout.bTileMax = Context.bTileMax;
+        Layout.bAsyncCompute = Context.bAsyncCompute;
+        Layout.bMobile = Context.bMobile;
+        Layout.bR11G11B10RenderTarget = Context.bR11G11B10RenderTarget;
+        Layout.bR11G11B10TypedUAVStore = Context.bR11G11B10TypedUAVStore;
+
+        return Layout;
+    }
+
+    double GetMedian(TArray<double>& Values)
+    {
+        Values.Sort();
+        return Values.Num() > 0 ? Values[Values.Num() / 2] : 0.0;
+    }
+
+    // Median time to build the plan of a view, which is what Render()
+    // runs on the CPU for every resize or setting change
+    double TimePassPlan(const FPostProcessSettingsProxy& Settings, const FPostProcessPassPlanKey& Key, int32 Iterations)
+    {
+        FPostProcessPassPlan Plan;
+        TArray<double> Microseconds;
+
+        for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+        {
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            UPostProcessSubsystem::BuildPassPlan(Settings, Key, Plan);
+            Microseconds.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0);
+        }
+
+        return GetMedian(Microseconds);
+    }
+
+    // Whether Render() recorded what the plan describes, logs the first difference
+    bool MatchesDescription(const FString& CaseName, const FPostProcessStructure& Recorded, const FPostProcessStructure& Described)
+    {
+        const TArray<FString>& RecordedPasses = Recorded.GetPasses();
+        const TArray<FString>& DescribedPasses = Described.GetPasses();
+
+        for (int32 i = 0; i < FMath::Max(RecordedPasses.Num(), DescribedPasses.Num()); i++)
+        {
+            const FString RecordedPass = RecordedPasses.IsValidIndex(i) ? RecordedPasses[i] : TEXT("(none)");
+            const FString DescribedPass = DescribedPasses.IsValidIndex(i) ? DescribedPasses[i] : TEXT("(none)");
+
+            if (RecordedPass != DescribedPass)
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s records pass %d as %s, its plan describes %s"), *CaseName, i, *RecordedPass, *DescribedPass);
+                return false;
+            }
+        }
+
+        // The footprint lists textures by first use, the description by creation
+        const auto GetSorted = [](const FPostProcessStructure& Structure)
+        {
+            TArray<FPostProcessStructure::FTexture> Textures = Structure.GetTextures();
+
+            Textures.StableSort([](const FPostProcessStructure::FTexture& A, const FPostProcessStructure::FTexture& B)
+                {
+                    return A.FirstPass != B.FirstPass ? A.FirstPass < B.FirstPass : A.Name < B.Name;
+                });
+
+            return Textures;
+        };
+
+        const auto Describe = [](const FPostProcessStructure::FTexture* Texture)
+        {
+            return Texture != nullptr
+                ? FString::Printf(TEXT("%s %dx%d %s (passes %d to %d)"), *Texture->Name, Texture->Extent.X, Texture->Extent.Y, GPixelFormats[Texture->Format].Name, Texture->FirstPass, Texture->LastPass)
+                : FString(TEXT("(none)"));
+        };
+
+        const TArray<FPostProcessStructure::FTexture> RecordedTextures = GetSorted(Recorded);
+        const TArray<FPostProcessStructure::FTexture> DescribedTextures = GetSorted(Described);
+
+        for (int32 i = 0; i < FMath::Max(RecordedTextures.Num(), DescribedTextures.Num()); i++)
+        {
+            const FPostProcessStructure::FTexture* RecordedTexture = RecordedTextures.IsValidIndex(i) ? &RecordedTextures[i] : nullptr;
+            const FPostProcessStructure::FTexture* DescribedTexture = DescribedTextures.IsValidIndex(i) ? &DescribedTextures[i] : nullptr;
+
+            if (Describe(RecordedTexture) != Describe(DescribedTexture))
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s records %s, its plan describes %s"), *CaseName, *Describe(RecordedTexture), *Describe(DescribedTexture));
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Renders the cases as scene captures of an empty scene and hands back
+    // what Render() recorded. Everything that isn't part of a case is
+    // pinned for as long as it lives: views are measured as the pass plan
+    // makes them, without the governor or the stages skipped by the content
+    // of the (black) scene.
+    class FCaseRenderer
+    {
+    public:
+        explicit FCaseRenderer(UPostProcessSubsystem& InSubsystem)
+            : Subsystem(InSubsystem)
+            , Scene(FPreviewScene::ConstructionValues())
+            , RecordedViews(MakeShared<TArray<FRecordedView>, ESPMode::ThreadSafe>())
+        {
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.Budget"), 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.AutoSkip"), 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.StaticCache"), 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.MinViewSize"), 64);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.ReducedViewSize"), 480);
+
+            // Scene textures sized after the capture, not the largest view so far
+            ConsoleVariables.Set(TEXT("r.SceneRenderTargetResizeMethodForceOverride"), 1);
+            ConsoleVariables.Set(TEXT("r.SceneRenderTargetResizeMethod"), 0);
+
+            // Pass names are only formatted when draw events are emitted
+            ENQUEUE_RENDER_COMMAND(EnableDrawEvents)([this](FRHICommandListImmediate& RHICmdList)
+                {
+                    bEmitDrawEvents = GetEmitDrawEvents();
+                    SetEmitDrawEvents(true);
+                });
+
+            RenderTarget.Reset(NewObject<UTextureRenderTarget2D>(GetTransientPackage(), NAME_None, RF_Transient));
+
+            Capture.Reset(NewObject<USceneCaptureComponent2D>(GetTransientPackage(), NAME_None, RF_Transient));
+            Capture->bCaptureEveryFrame = false;
+            Capture->bCaptureOnMovement = false;
+            Capture->CaptureSource = ESceneCaptureSource::SCS_FinalColorLDR;
+            Capture->TextureTarget = RenderTarget.Get();
+            Scene.AddComponent(Capture.Get(), FTransform::Identity);
+
+            // Filled on the render thread, read once the capture is flushed
+            Subsystem.SetStructureCallback([RecordedViews = RecordedViews](const FPostProcessRenderContext& Context, const FPostProcessStructure& Structure, double RenderMicroseconds)
+                {
+                    RecordedViews->Add({ CopyLayout(Context), Structure, RenderMicroseconds });
+                });
+        }
+
+        ~FCaseRenderer()
+        {
+            Subsystem.SetStructureCallback(nullptr);
+            Subsystem.SetDataAssetOverride(nullptr);
+
+            // After EnableDrawEvents, flushed before this goes away
+            ENQUEUE_RENDER_COMMAND(RestoreDrawEvents)([this](FRHICommandListImmediate& RHICmdList)
+                {
+                    SetEmitDrawEvents(bEmitDrawEvents);
+                });
+
+            FlushRenderingCommands();
+        }
+
+        // Whether this RHI renders the case as it is described
+        bool CanRender(const FStructureCase& Case) const
+        {
+            return Case.bMobile == (GMaxRHIFeatureLevel < ERHIFeatureLevel::SM5)
+                && Case.ScreenPercentage == 1.0f
+                && (!Case.bAsyncCompute || GSupportsEfficientAsyncCompute)
+                && Case.bR11G11B10RenderTarget == UE::PixelFormat::HasCapabilities(PF_FloatR11G11B10, EPixelFormatCapabilities::RenderTarget)
+                && Case.bR11G11B10TypedUAVStore == UE::PixelFormat::HasCapabilities(PF_FloatR11G11B10, EPixelFormatCapabilities::TypedUAVStore);
+        }
+
+        // Render the case Iterations times with Asset, returns the last
+        // view recorded and the median time of Render() (null on failure)
+        const FRecordedView* Render(const FStructureCase& Case, UPostProcessDataAsset& Asset, int32 Iterations, double& OutRenderMicroseconds)
+        {
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.Quality"), Case.Quality);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.SceneCaptureQuality"), int32(Case.ViewQuality));
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.BloomPassAmount"), Case.BloomPassAmount);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.BloomResLimit"), Case.BloomResLimit);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.RenderFlare"), Case.bRenderFlare ? 1 : 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.RenderHalo"), Case.bRenderHalo ? 1 : 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.RenderGlare"), Case.bRenderGlare ? 1 : 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.TileMax"), Case.bTileMax ? 1 : 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.AsyncCompute"), Case.bAsyncCompute ? 1 : 0);
+            ConsoleVariables.Set(TEXT("r.PrettyPostProcess.Mobile.Glare"), Case.bMobileGlare ? 1 : 0);
+
+            Subsystem.SetDataAssetOverride(&Asset);
+            RenderTarget->InitCustomFormat(Case.ViewSize.X, Case.ViewSize.Y, PF_B8G8R8A8, false);
+
+            RecordedViews->Reset();
+
+            for (int32 Iteration = 0; Iteration < Iterations; Iteration++)
+            {
+                Capture->CaptureScene();
+                FlushRenderingCommands();
+            }
+
+            const FRecordedView* LastView = nullptr;
+            TArray<double> Microseconds;
+
+            for (const FRecordedView& View : *RecordedViews)
+            {
+                if (View.Context.Plan.Key.ViewSize == Case.ViewSize)
+                {
+                    LastView = &View;
+                    Microseconds.Add(View.RenderMicroseconds);
+                }
+            }
+
+            OutRenderMicroseconds = GetMedian(Microseconds);
+
+            return LastView;
+        }
+
+    private:
+        UPostProcessSubsystem& Subsystem;
+        FScopedConsoleVariables ConsoleVariables;
+        bool bEmitDrawEvents = false;
+
+        FPreviewScene Scene;
+        TStrongObjectPtr<UTextureRenderTarget2D> RenderTarget;
+        TStrongObjectPtr<USceneCaptureComponent2D> Capture;
+
+        TSharedRef<TArray<FRecordedView>, ESPMode::ThreadSafe> RecordedViews;
+    };
+
+    TArray<TSharedPtr<FJsonValue>> MakeJsonSize(const FIntPoint& Size)
+    {
+        return { MakeShared<FJsonValueNumber>(Size.X), MakeShared<FJsonValueNumber>(Size.Y) };
+    }
+
+    // Key of a texture when matching against the baseline
+    FString GetTextureKey(const FString& Name, const FIntPoint& Extent, const FString& Format)
+    {
+        return FString::Printf(TEXT("%s %dx%d %s"), *Name, Extent.X, Extent.Y, *Format);
+    }
+
+    TSharedRef<FJsonObject> MakeJsonCase(const FStructureCase& Case, const FPostProcessPassPlan& Plan, const FPostProcessStructure& Structure, double PlanMicroseconds)
+    {
+        TArray<TSharedPtr<FJsonValue>> JsonPasses;
+
+        for (const FString& Pass : Structure.GetPasses())
+        {
+            JsonPasses.Add(MakeShared<FJsonValueString>(Pass));
+        }
+
+        TArray<TSharedPtr<FJsonValue>> JsonTextures;
+
+        for (const FPostProcessStructure::FTexture& Texture : Structure.GetTextures())
+        {
+            TSharedRef<FJsonObject> JsonTexture = MakeShared<FJsonObject>();
+            JsonTexture->SetStringField(TEXT("name"), Texture.Name);
+            JsonTexture->SetArrayField(TEXT("size"), MakeJsonSize(Texture.Extent));
+            JsonTexture->SetStringField(TEXT("format"), GPixelFormats[Texture.Format].Name);
+            JsonTexture->SetNumberField(TEXT("bytes"), double(Texture.SizeInBytes));
+            JsonTexture->SetNumberField(TEXT("firstPass"), Texture.FirstPass);
+            JsonTexture->SetNumberField(TEXT("lastPass"), Texture.LastPass);
+            JsonTextures.Add(MakeShared<FJsonValueObject>(JsonTexture));
+        }
+
+        int32 PeakPass = 0;
+        const uint64 PeakBytes = Structure.GetPeakBytes(&PeakPass);
+
+        TSharedRef<FJsonObject> JsonCase = MakeShared<FJsonObject>();
+        JsonCase->SetStringField(TEXT("name"), Case.Name);
+        JsonCase->SetArrayField(TEXT("viewSize"), MakeJsonSize(Plan.Key.ViewSize));
+        JsonCase->SetArrayField(TEXT("extent"), MakeJsonSize(Plan.Key.Extent));
+        JsonCase->SetNumberField(TEXT("quality"), Case.Quality);
+        JsonCase->SetNumberField(TEXT("viewQuality"), int32(Plan.Key.Quality));
+        JsonCase->SetNumberField(TEXT("passAmount"), Plan.PassAmount);
+        JsonCase->SetNumberField(TEXT("passCount"), Structure.GetPasses().Num());
+        JsonCase->SetNumberField(TEXT("textureCount"), Structure.GetTextures().Num());
+        JsonCase->SetNumberField(TEXT("peakBytes"), double(PeakBytes));
+        JsonCase->SetStringField(TEXT("peakPass"), Structure.GetPasses().IsValidIndex(PeakPass) ? Structure.GetPasses()[PeakPass] : FString());
+        JsonCase->SetNumberField(TEXT("totalBytes"), double(Structure.GetTotalBytes()));
+        JsonCase->SetNumberField(TEXT("planUs"), PlanMicroseconds);
+        JsonCase->SetArrayField(TEXT("passes"), JsonPasses);
+        JsonCase->SetArrayField(TEXT("textures"), JsonTextures);
+
+        return JsonCase;
+    }
+
+    // Compare a case with its baseline, return the number of regressions
+    int32 CheckCase(const FStructureCase& Case, const FJsonObject& Current, const FJsonObject* Baseline, double TimeTolerance)
+    {
+        int32 Errors = 0;
+
+        // Stages disabled by the settings, whatever the baseline says
+        TArray<TSharedPtr<FJsonValue>> EmptyArray;
+        const TArray<TSharedPtr<FJsonValue>>* Passes = &EmptyArray;
+        Current.TryGetArrayField(TEXT("passes"), Passes);
+
+        for (const TSharedPtr<FJsonValue>& Pass : *Passes)
+        {
+            const FString PassName = Pass->AsString();
+
+            for (const FString& Pruned : Case.PrunedPasses)
+            {
+                if (PassName.StartsWith(Pruned))
+                {
+                    UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s has %s, which its settings disable"), *Case.Name, *PassName);
+                    Errors++;
+                }
+            }
+        }
+
+        // Timings, against the baseline when it has them
+        static const TPair<const TCHAR*, double> Timings[] =
+        {
+            { TEXT("planUs"), PlanBudgetMicroseconds },
+            { TEXT("renderUs"), RenderBudgetMicroseconds }
+        };
+
+        for (const TPair<const TCHAR*, double>& Timing : Timings)
+        {
+            double Microseconds = 0.0;
+            double BaselineMicroseconds = 0.0;
+
+            if (TimeTolerance <= 0.0 || !Current.TryGetNumberField(Timing.Key, Microseconds))
+            {
+                continue;
+            }
+
+            const bool bHasBaseline = Baseline != nullptr
+                && Baseline->TryGetNumberField(Timing.Key, BaselineMicroseconds)
+                && BaselineMicroseconds > 0.0;
+
+            const double MaxMicroseconds = bHasBaseline ? BaselineMicroseconds * TimeTolerance : Timing.Value;
+
+            if (Microseconds > MaxMicroseconds)
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s %s is %.2f, over %.2f (%s)"),
+                    *Case.Name,
+                    Timing.Key,
+                    Microseconds,
+                    MaxMicroseconds,
+                    bHasBaseline ? TEXT("baseline") : TEXT("budget")
+                );
+                Errors++;
+            }
+        }
+
+        if (Baseline == nullptr)
+        {
+            return Errors;
+        }
+
+        // Counters that may only go down
+        static const TCHAR* const Counters[] = { TEXT("passCount"), TEXT("textureCount"), TEXT("peakBytes"), TEXT("totalBytes") };
+
+        for (const TCHAR* Counter : Counters)
+        {
+            const double Value = Current.GetNumberField(Counter);
+            const double BaselineValue = Baseline->GetNumberField(Counter);
+
+            if (Value > BaselineValue)
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s %s went up from %.0f to %.0f"), *Case.Name, Counter, BaselineValue, Value);
+                Errors++;
+            }
+            else if (Value < BaselineValue)
+            {
+                UE_LOG(LogPrettyPostProcess, Display, TEXT("Structure: %s %s went down from %.0f to %.0f (update the baseline)"), *Case.Name, Counter, BaselineValue, Value);
+            }
+        }
+
+        // Every texture has to be in the baseline, with the same size and format
+        const auto GetTextureKeys = [](const FJsonObject& Object)
+        {
+            TArray<FString> Keys;
+            const TArray<TSharedPtr<FJsonValue>>* Textures = nullptr;
+
+            if (Object.TryGetArrayField(TEXT("textures"), Textures))
+            {
+                for (const TSharedPtr<FJsonValue>& Value : *Textures)
+                {
+                    const TSharedPtr<FJsonObject>& Texture = Value->AsObject();
+                    const TArray<TSharedPtr<FJsonValue>>& Size = Texture->GetArrayField(TEXT("size"));
+
+                    Keys.Add(GetTextureKey(
+                        Texture->GetStringField(TEXT("name")),
+                        FIntPoint(int32(Size[0]->AsNumber()), int32(Size[1]->AsNumber())),
+                        Texture->GetStringField(TEXT("format"))
+                    ));
+                }
+            }
+
+            return Keys;
+        };
+
+        TArray<FString> BaselineTextures = GetTextureKeys(*Baseline);
+
+        for (const FString& Texture : GetTextureKeys(Current))
+        {
+            if (BaselineTextures.RemoveSingle(Texture) == 0)
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s creates %s, which is not in the baseline"), *Case.Name, *Texture);
+                Errors++;
+            }
+        }
+
+        return Errors;
+    }
+
+    bool ReadBaseline(const FString& BaselinePath, TMap<FString, TSharedPtr<FJsonObject>>& OutCases)
+    {
+        FString BaselineJson;
+        TSharedPtr<FJsonObject> Baseline;
+
+        if (!FFileHelper::LoadFileToString(BaselineJson, *BaselinePath)
+            || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineJson), Baseline)
+            || !Baseline.IsValid())
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: can't read the baseline '%s' (create it with -UpdateBaseline)"), *BaselinePath);
+            return false;
+        }
+
+        if (Baseline->GetIntegerField(TEXT("schema")) != StructureSchemaVersion)
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: the baseline '%s' is from another version, update it"), *BaselinePath);
+            return false;
+        }
+
+        for (const TSharedPtr<FJsonValue>& Value : Baseline->GetArrayField(TEXT("cases")))
+        {
+            const TSharedPtr<FJsonObject>& Case = Value->AsObject();
+            OutCases.Add(Case->GetStringField(TEXT("name")), Case);
+        }
+
+        return true;
+    }
+}
+
+bool FPostProcessStructureCheck::Run(const FOptions& Options)
+{
+    check(IsInGameThread());
+
+    UPostProcessSubsystem* Subsystem = GEngine != nullptr ? GEngine->GetEngineSubsystem<UPostProcessSubsystem>() : nullptr;
+
+    if (Options.bRender && (Subsystem == nullptr || !FApp::CanEverRender()))
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: rendering the cases needs a renderer (commandlets need -AllowCommandletRendering, and no -nullrhi)"));
+        return false;
+    }
+
+    const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("PrettyPostProcess"));
+
+    FString BaselinePath = Options.BaselinePath;
+
+    if (BaselinePath.IsEmpty() && Plugin.IsValid())
+    {
+        BaselinePath = Plugin->GetBaseDir() / TEXT("Config") / TEXT("StructureBaseline.json");
+    }
+
+    const FString OutputPath = Options.OutputPath.IsEmpty()
+        ? FPaths::ProjectSavedDir() / TEXT("PrettyPostProcess") / TEXT("Structure.json")
+        : Options.OutputPath;
+
+    const UPostProcessDataAsset* BaseAsset = Options.Asset != nullptr ? Options.Asset : GetDefault<UPostProcessDataAsset>();
+
+    // The settings proxy only takes the textures that are loaded, they are
+    // kept alive until the check is done
+    TArray<FSoftObjectPath> TexturePaths;
+    BaseAsset->GetTexturePaths(TexturePaths);
+
+    TArray<TStrongObjectPtr<UObject>> Textures;
+
+    for (const FSoftObjectPath& TexturePath : TexturePaths)
+    {
+        if (UObject* Texture = TexturePath.TryLoad())
+        {
+            Textures.Emplace(Texture);
+        }
+    }
+
+    TMap<FString, TSharedPtr<FJsonObject>> BaselineCases;
+
+    if (!Options.bUpdateBaseline && !ReadBaseline(BaselinePath, BaselineCases))
+    {
+        return false;
+    }
+
+    TUniquePtr<FCaseRenderer> Renderer;
+
+    if (Options.bRender)
+    {
+        Renderer = MakeUnique<FCaseRenderer>(*Subsystem);
+    }
+
+    //--------------------------------
+    // Cases
+    //--------------------------------
+    const TArray<FStructureCase> Cases = BuildCases();
+
+    TArray<TSharedPtr<FJsonValue>> JsonCases;
+    int32 Errors = 0;
+
+    for (int32 CaseIndex = 0; CaseIndex < Cases.Num(); CaseIndex++)
+    {
+        const FStructureCase& Case = Cases[CaseIndex];
+
+        // A revision of its own, so that no plan cached for another case is reused
+        TStrongObjectPtr<UPostProcessDataAsset> Asset(NewObject<UPostProcessDataAsset>(
+            GetTransientPackage(),
+            NAME_None,
+            RF_Transient,
+            const_cast<UPostProcessDataAsset*>(BaseAsset)
+        ));
+
+        if (Case.EditAsset)
+        {
+            Case.EditAsset(*Asset);
+        }
+
+        Asset->Revision = MAX_uint32 - uint32(CaseIndex);
+
+        // The proxy only copies the settings (no uniform buffer needed here)
+        const FPostProcessSettingsProxy Settings(*Asset);
+
+        const FPostProcessRenderContext Context = MakeContext(Case, Settings);
+
+        FPostProcessStructure Structure;
+        UPostProcessSubsystem::DescribePassPlan(Context, Structure);
+
+        const double PlanMicroseconds = TimePassPlan(Settings, Context.Plan.Key, FMath::Max(Options.Iterations, 1));
+        const TSharedRef<FJsonObject> JsonCase = MakeJsonCase(Case, Context.Plan, Structure, PlanMicroseconds);
+
+        int32 CaseErrors = 0;
+
+        if (Renderer.IsValid() && Renderer->CanRender(Case))
+        {
+            double RenderMicroseconds = 0.0;
+            const FRecordedView* View = Renderer->Render(Case, *Asset, FMath::Max(Options.RenderIterations, 1), RenderMicroseconds);
+
+            if (View == nullptr)
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %s wasn't rendered by the plugin"), *Case.Name);
+                CaseErrors++;
+            }
+            else if (View->Structure.GetPasses().ContainsByPredicate([](const FString& Pass) { return Pass.Contains(TEXT("%")); }))
+            {
+                UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: pass names aren't formatted, draw events are compiled out of this build"));
+                Errors++;
+                break;
+            }
+            else
+            {
+                // Described from the recorded plan: scene textures are
+                // quantized, their extent may not be the one of the case
+                FPostProcessStructure Described;
+                UPostProcessSubsystem::DescribePassPlan(View->Context, Described);
+
+                if (!MatchesDescription(Case.Name, View->Structure, Described))
+                {
+                    CaseErrors++;
+                }
+
+                JsonCase->SetNumberField(TEXT("renderUs"), RenderMicroseconds);
+            }
+        }
+        else if (Renderer.IsValid())
+        {
+            UE_LOG(LogPrettyPostProcess, Display, TEXT("Structure: %s not rendered, this RHI renders it differently"), *Case.Name);
+        }
+
+        const TSharedPtr<FJsonObject>* Baseline = BaselineCases.Find(Case.Name);
+
+        if (Baseline == nullptr && !Options.bUpdateBaseline)
+        {
+            UE_LOG(LogPrettyPostProcess, Warning, TEXT("Structure: %s is not in the baseline"), *Case.Name);
+        }
+
+        CaseErrors += CheckCase(Case, *JsonCase, Baseline != nullptr ? Baseline->Get() : nullptr, Options.bUpdateBaseline ? 0.0 : Options.TimeTolerance);
+        Errors += CaseErrors;
+
+        UE_LOG(LogPrettyPostProcess, Display, TEXT("Structure: %s: %d passes, %d textures, %.2f MB peak%s"),
+            *Case.Name,
+            Structure.GetPasses().Num(),
+            Structure.GetTextures().Num(),
+            double(Structure.GetPeakBytes()) / (1024.0 * 1024.0),
+            CaseErrors > 0 ? TEXT(" FAILED") : TEXT("")
+        );
+
+        JsonCases.Add(MakeShared<FJsonValueObject>(JsonCase));
+    }
+
+    Renderer.Reset();
+
+    //--------------------------------
+    // Report
+    //--------------------------------
+    TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetNumberField(TEXT("schema"), StructureSchemaVersion);
+    Report->SetStringField(TEXT("pluginVersion"), Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString());
+    Report->SetStringField(TEXT("engineVersion"), FEngineVersion::Current().ToString());
+    Report->SetStringField(TEXT("asset"), BaseAsset->GetPathName());
+    Report->SetBoolField(TEXT("rendered"), Options.bRender);
+    Report->SetArrayField(TEXT("cases"), JsonCases);
+
+    FString Json;
+    const TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+
+    // A baseline recording disabled stages would be no use
+    const bool bWriteBaseline = Options.bUpdateBaseline && Errors == 0;
+    const FString& ReportPath = bWriteBaseline ? BaselinePath : OutputPath;
+
+    if (!FJsonSerializer::Serialize(Report, Writer) || !FFileHelper::SaveStringToFile(Json, *ReportPath))
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: can't write '%s'"), *ReportPath);
+        return false;
+    }
+
+    if (Errors > 0)
+    {
+        UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: %d regressions over %d cases, report written to '%s'"), Errors, Cases.Num(), *ReportPath);
+        return false;
+    }
+
+    UE_LOG(LogPrettyPostProcess, Display, TEXT("Structure: %d cases checked, report written to '%s'"), Cases.Num(), *ReportPath);
+
+    return true;
+}
@@ -0,0 +1,55 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPostProcessDataAsset;
+
+// Checks the structure of the render graph against a baseline. For a
+// matrix of view sizes, quality presets, console variables, feature
+// levels, format support and data asset settings, the passes and textures
+// the pass plan describes (see UPostProcessSubsystem::DescribePassPlan)
+// are compared with the baseline. Fails when a case has more passes, more
+// textures, a texture that is new or larger, or more transient memory than
+// the baseline, when a stage disabled by the settings still has passes,
+// or when building the plan got slower. Needs no GPU (runs with -nullrhi).
+// With FOptions::bRender, the cases this RHI can render are also rendered
+// as scene captures: Render() has to record what the plan describes, and
+// the time it takes is checked too.
+// Run by the PrettyPostProcess.Structure automation tests and the
+// PostProcessStructure commandlet.
+class FPostProcessStructureCheck
+{
+public:
+    struct FOptions
+    {
+        // <Plugin>/Config/StructureBaseline.json when empty
+        FString BaselinePath;
+
+        // <Project>/Saved/PrettyPostProcess/Structure.json when empty
+        FString OutputPath;
+
+        // Settings the cases start from, the defaults when null.
+        // Its textures are loaded by the check.
+        const UPostProcessDataAsset* Asset = nullptr;
+
+        // Runs timed per case, and how much slower than the baseline a
+        // case may get (0: timings aren't checked). Cases the baseline has
+        // no timings for are held to fixed budgets instead.
+        int32 Iterations = 100;
+        int32 RenderIterations = 5;
+        double TimeTolerance = 2.0;
+
+        // Also render the cases as scene captures (needs a renderer, and
+        // -AllowCommandletRendering in a commandlet)
+        bool bRender = false;
+
+        // Write the baseline instead of checking against it
+        bool bUpdateBaseline = false;
+    };
+
+    // Check every case and write the report (game thread).
+    // Returns false on regressions or when the check can't run.
+    static bool Run(const FOptions& Options);
+};
@@ -0,0 +1,44 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessStructureCommandlet.h"
+#include "PostProcessDataAsset.h"
+#include "PostProcessStructureCheck.h"
+#include "PrettyPostProcess.h"
+
+UPostProcessStructureCommandlet::UPostProcessStructureCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+
+    HelpDescription = TEXT("Checks the passes and textures of the plugin against a baseline.");
+    HelpUsage = TEXT("-run=PostProcessStructure [-Baseline=] [-Output=] [-Asset=] [-Iterations=] [-TimeTolerance=] [-Render -AllowCommandletRendering] [-RenderIterations=] [-UpdateBaseline]");
+}
+
+int32 UPostProcessStructureCommandlet::Main(const FString& Params)
+{
+    FPostProcessStructureCheck::FOptions Options;
+    FParse::Value(*Params, TEXT("Baseline="), Options.BaselinePath);
+    FParse::Value(*Params, TEXT("Output="), Options.OutputPath);
+    FParse::Value(*Params, TEXT("Iterations="), Options.Iterations);
+    FParse::Value(*Params, TEXT("TimeTolerance="), Options.TimeTolerance);
+    FParse::Value(*Params, TEXT("RenderIterations="), Options.RenderIterations);
+    Options.bRender = FParse::Param(*Params, TEXT("Render"));
+    Options.bUpdateBaseline = FParse::Param(*Params, TEXT("UpdateBaseline"));
+
+    FString AssetPath;
+
+    if (FParse::Value(*Params, TEXT("Asset="), AssetPath))
+    {
+        Options.Asset = LoadObject<UPostProcessDataAsset>(nullptr, *AssetPath);
+
+        if (Options.Asset == nullptr)
+        {
+            UE_LOG(LogPrettyPostProcess, Error, TEXT("Structure: can't load the data asset '%s'"), *AssetPath);
+            return 1;
+        }
+    }
+
+    return FPostProcessStructureCheck::Run(Options) ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PostProcessStructureCommandlet.generated.h"
+
+// Runs the structure check (see FPostProcessStructureCheck) outside of
+// the automation framework. Needs no GPU (-nullrhi is fine) unless the
+// cases are also rendered with -Render, which needs
+// -AllowCommandletRendering.
+//
+// UnrealEditor-Cmd <Project> -run=PostProcessStructure -nullrhi
+//     -Baseline=<StructureBaseline.json> -Output=<Structure.json>
+//     -Asset=<Data Asset path> -Iterations=100 -TimeTolerance=2
+//     -Render -RenderIterations=5 -UpdateBaseline
+UCLASS()
+class UPostProcessStructureCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UPostProcessStructureCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,38 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PostProcessStructureCheck.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Structure of the render graph against Config/StructureBaseline.json,
+// with the default settings (see FPostProcessStructureCheck). No GPU needed.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FPostProcessStructureTest,
+    "PrettyPostProcess.Structure",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FPostProcessStructureTest::RunTest(const FString& Parameters)
+{
+    // Regressions are logged as errors, which fail the test on their own
+    return FPostProcessStructureCheck::Run(FPostProcessStructureCheck::FOptions());
+}
+
+// Same, with the cases this RHI can render also rendered: Render() has to
+// record what the plans describe
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FPostProcessStructureRenderTest,
+    "PrettyPostProcess.Structure.Render",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::NonNullRHI | EAutomationTestFlags::EngineFilter
+)
+
+bool FPostProcessStructureRenderTest::RunTest(const FString& Parameters)
+{
+    FPostProcessStructureCheck::FOptions Options;
+    Options.bRender = true;
+
+    return FPostProcessStructureCheck::Run(Options);
+}
+
+#endif
@@ -3,10 +3,31 @@
 
 #include "PostProcessSubsystem.h"
 #include "PostProcessDataAsset.h"
+#include "PostProcessAutoSkip.h"
+#include "PostProcessBudget.h"
+#include "PostProcessCapture.h"
+#include "PostProcessCaptureRecorder.h"
+#include "PostProcessFootprint.h"
+#include "PostProcessStructure.h"
+#include "PostProcessSettingsProxy.h"
+#include "PostProcessStaticCache.h"
+#include "PrettyPostProcess.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/FileManager.h"
 #include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
 #include "RenderGraph.h"
+#include "RenderGraphUtils.h"
 #include "SystemTextures.h"
 #include "ScreenPass.h"
+#include "Misc/ScopeRWLock.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "PipelineStateCache.h"
+#include "CommonRenderResources.h"
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
 #if ENGINE_MAJOR_VERSION >= 5 && ENGINE_MINOR_VERSION >= 4
 #include "DataDrivenShaderPlatformInfo.h"
 #endif
@@ -23,14 +44,158 @@
 #define VECTOR4 FVector4
 #endif
 
+//----------------------------------------------------------
+// Permutations
+//----------------------------------------------------------
+
+// Read only: they decide which permutations get compiled (and cooked),
+// so they have to be set in the ini files ([SystemSettings] section).
+TAutoConsoleVariable<int32> CVarGhostCountPermutations(
+    TEXT("r.PrettyPostProcess.Permutations.GhostCounts"),
+    0xFF,
+    TEXT("Bit mask of the ghost counts the ghost shaders are compiled for (bit 0 = 1 ghost, bit 7 = 8 ghosts).\n")
+    TEXT("The 8 ghosts permutation is always compiled. A count that isn't renders with the next compiled one,\n")
+    TEXT("which may show ghosts the quality preset would have dropped."),
+    ECVF_ReadOnly);
+
+TAutoConsoleVariable<int32> CVarSpecializedPermutations(
+    TEXT("r.PrettyPostProcess.Permutations.Specialized"),
+    1,
+    TEXT(" 0: Only compile the generic permutations (chroma shift, starburst texture and every mix input enabled)\n")
+    TEXT(" 1: Also compile the permutations without them, picked when the settings allow it"),
+    ECVF_ReadOnly);
+
 namespace
 {
+    constexpr int32 MaxGhostCount = 8;
+
+    // Ghost loop fully unrolled for a fixed number of ghosts
+    class FGhostCountDim : SHADER_PERMUTATION_RANGE_INT("GHOST_COUNT", 1, MaxGhostCount);
+
+    // Chromatic shift of the ghosts and halo (3 fetches instead of 1)
+    class FChromaShiftDim : SHADER_PERMUTATION_BOOL("USE_CHROMA_SHIFT");
+
+    // Starburst noise texture set in the data asset
+    // (without it the fetch is replaced by the white fallback value)
+    class FStarburstTextureDim : SHADER_PERMUTATION_BOOL("USE_STARBURST_TEXTURE");
+
+    // Inputs of the final mix
+    class FMixBloomDim : SHADER_PERMUTATION_BOOL("USE_BLOOM");
+    class FMixFlareDim : SHADER_PERMUTATION_BOOL("USE_FLARE");
+    class FMixGlareDim : SHADER_PERMUTATION_BOOL("USE_GLARE");
+
+    // Tile max map bound, dark areas are skipped (SM5 only)
+    class FTileMaxDim : SHADER_PERMUTATION_BOOL("USE_TILE_MAX");
+
+    bool IsGhostCountCompiled(int32 GhostCount)
+    {
+        return GhostCount == MaxGhostCount
+            || (CVarGhostCountPermutations.GetValueOnAnyThread() & (1 << (GhostCount - 1))) != 0;
+    }
+
+    // A disabled feature is only compiled as its own permutation when
+    // specialized permutations are allowed, the generic one is always there.
+    bool IsFeatureCompiled(bool bEnabled)
+    {
+        return bEnabled || CVarSpecializedPermutations.GetValueOnAnyThread() != 0;
+    }
+
+    // Permutation used to render a number of ghosts
+    int32 GetGhostCountPermutation(int32 GhostCount)
+    {
+        for (int32 Count = FMath::Max(GhostCount, 1); Count < MaxGhostCount; Count++)
+        {
+            if (IsGhostCountCompiled(Count))
+            {
+                return Count;
+            }
+        }
+
+        return MaxGhostCount;
+    }
+
+    // Permutation used for a feature (falls back to the generic one)
+    bool GetFeaturePermutation(bool bEnabled)
+    {
+        return !IsFeatureCompiled(bEnabled) || bEnabled;
+    }
+
+    // The tile max map is built with a compute shader, so never on mobile
+    bool IsTileMaxCompiled(const FGlobalShaderPermutationParameters& Parameters, bool bTileMax)
+    {
+        return !bTileMax || IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+    }
+
     // RDG buffer input shared by all passes
     BEGIN_SHADER_PARAMETER_STRUCT(FCustomPostProcessParameters, )
+    SHADER_PARAMETER_STRUCT_REF(FPrettyPostProcessSettingsParameters, Settings)
     SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+    SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Input)
     RENDER_TARGET_BINDING_SLOTS()
     END_SHADER_PARAMETER_STRUCT()
 
+    // RDG buffer input/output shared by all compute passes
+    BEGIN_SHADER_PARAMETER_STRUCT(FCustomComputeParameters, )
+    SHADER_PARAMETER_STRUCT_REF(FPrettyPostProcessSettingsParameters, Settings)
+    SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+    SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Input)
+    SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, RWOutputTexture)
+    SHADER_PARAMETER(VECTOR2, OutputSize)
+    END_SHADER_PARAMETER_STRUCT()
+
+    // Tile max map lookup (see IsInputLit in PrettyPostProcess.ush)
+    BEGIN_SHADER_PARAMETER_STRUCT(FTileMaxParameters, )
+    SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, TileMaxTexture)
+    SHADER_PARAMETER(VECTOR2, TileMaxScale)
+    SHADER_PARAMETER(float, TileMaxThreshold)
+    END_SHADER_PARAMETER_STRUCT()
+
+    // Base of the compute variants that run on the async compute queue
+    class FCustomComputeShader : public FGlobalShader
+    {
+    public:
+        static constexpr int32 ThreadGroupSize = 8;
+
+        FCustomComputeShader() = default;
+        FCustomComputeShader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+            : FGlobalShader(Initializer)
+        {}
+
+        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+        {
+            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+        }
+
+        static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+        {
+            FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+            OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZE"), ThreadGroupSize);
+        }
+    };
+
+    // Base of the raster passes. They also run on the mobile feature
+    // levels (ES3.1), where REDUCED_PIPELINE selects fewer taps and
+    // half precision color math.
+    class FCustomScreenPassShader : public FGlobalShader
+    {
+    public:
+        FCustomScreenPassShader() = default;
+        FCustomScreenPassShader(const ShaderMetaType::CompiledShaderInitializerType& Initializer)
+            : FGlobalShader(Initializer)
+        {}
+
+        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+        {
+            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::ES3_1);
+        }
+
+        static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+        {
+            FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+            OutEnvironment.SetDefine(TEXT("REDUCED_PIPELINE"), IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5) ? 0 : 1);
+        }
+    };
+
     // The vertex shader to draw a rectangle.
     class FCustomScreenPassVS : public FGlobalShader
     {
@@ -49,115 +214,142 @@ namespace
     };
     IMPLEMENT_GLOBAL_SHADER(FCustomScreenPassVS, "/CustomShaders/ScreenPass.usf", "CustomScreenPassVS", SF_Vertex);
 
-#if WITH_EDITOR
-    // Editor rescale shader
-    class FEditorRescalePS : public FGlobalShader
-    {
-    public:
-        DECLARE_GLOBAL_SHADER(FEditorRescalePS);
-        SHADER_USE_PARAMETER_STRUCT(FEditorRescalePS, FGlobalShader);
-
-        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
-        SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
-        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-        SHADER_PARAMETER(VECTOR2, InputViewportSize)
-        END_SHADER_PARAMETER_STRUCT()
-
-        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
-        {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
-        }
-    };
-    IMPLEMENT_GLOBAL_SHADER(FEditorRescalePS, "/CustomShaders/EditorRescale.usf", "RescalePS", SF_Pixel);
-#endif
-
     //----------------------------------------------------------
     // Bloom shaders
     //----------------------------------------------------------
 
     // Bloom downsample
-    class FDownsamplePS : public FGlobalShader
+    class FDownsamplePS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FDownsamplePS);
-        SHADER_USE_PARAMETER_STRUCT(FDownsamplePS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FDownsamplePS, FCustomScreenPassShader);
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
         SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
         SHADER_PARAMETER(VECTOR2, InputSize)
         END_SHADER_PARAMETER_STRUCT()
-
-        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
-        {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
-        }
     };
     IMPLEMENT_GLOBAL_SHADER(FDownsamplePS, "/CustomShaders/Downsample.usf", "DownsamplePS", SF_Pixel);
 
     // Bloom upsample + combine
-    class FUpsampleCombinePS : public FGlobalShader
+    class FUpsampleCombinePS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FUpsampleCombinePS);
-        SHADER_USE_PARAMETER_STRUCT(FUpsampleCombinePS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FUpsampleCombinePS, FCustomScreenPassShader);
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
         SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
         SHADER_PARAMETER(VECTOR2, InputSize)
         SHADER_PARAMETER_RDG_TEXTURE(Texture2D, PreviousTexture)
+        SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Previous)
         SHADER_PARAMETER(float, Radius)
         END_SHADER_PARAMETER_STRUCT()
+    };
+    IMPLEMENT_GLOBAL_SHADER(FUpsampleCombinePS, "/CustomShaders/Upsample.usf", "UpsampleCombinePS", SF_Pixel);
 
-        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    // Max luminance per tile of the flare input
+    class FTileMaxCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FTileMaxCS);
+        SHADER_USE_PARAMETER_STRUCT(FTileMaxCS, FCustomComputeShader);
+
+        // One thread group per tile
+        static constexpr int32 TileSize = ThreadGroupSize;
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+        SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Input)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, RWTileMaxTexture)
+        END_SHADER_PARAMETER_STRUCT()
+    };
+    IMPLEMENT_GLOBAL_SHADER(FTileMaxCS, "/CustomShaders/TileMax.usf", "TileMaxCS", SF_Compute);
+
+    // Average luminance of the scene color over a fixed grid, for the
+    // static cache. One thread group per cell.
+    class FSignatureCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FSignatureCS);
+        SHADER_USE_PARAMETER_STRUCT(FSignatureCS, FCustomComputeShader);
+
+        static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
         {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+            FCustomComputeShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+            OutEnvironment.SetDefine(TEXT("SIGNATURE_SIZE"), FPostProcessStaticCache::SignatureSize);
         }
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+        SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Input)
+        SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float>, RWSignatureTexture)
+        END_SHADER_PARAMETER_STRUCT()
     };
-    IMPLEMENT_GLOBAL_SHADER(FUpsampleCombinePS, "/CustomShaders/Upsample.usf", "UpsampleCombinePS", SF_Pixel);
+    IMPLEMENT_GLOBAL_SHADER(FSignatureCS, "/CustomShaders/Signature.usf", "SignatureCS", SF_Compute);
 
     //----------------------------------------------------------
     // Flare shaders
     //----------------------------------------------------------
 
     // Blur shader (use Dual Kawase method)
-    class FKawaseBlurDownPS : public FGlobalShader
+    BEGIN_SHADER_PARAMETER_STRUCT(FKawaseBlurParameters, )
+    SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+    SHADER_PARAMETER(VECTOR2, BufferSize)
+    END_SHADER_PARAMETER_STRUCT()
+
+    class FKawaseBlurDownPS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FKawaseBlurDownPS);
-        SHADER_USE_PARAMETER_STRUCT(FKawaseBlurDownPS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FKawaseBlurDownPS, FCustomScreenPassShader);
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
-        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-        SHADER_PARAMETER(VECTOR2, BufferSize)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FKawaseBlurParameters, Blur)
         END_SHADER_PARAMETER_STRUCT()
-
-        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
-        {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
-        }
     };
-    class FKawaseBlurUpPS : public FGlobalShader
+    class FKawaseBlurUpPS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FKawaseBlurUpPS);
-        SHADER_USE_PARAMETER_STRUCT(FKawaseBlurUpPS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FKawaseBlurUpPS, FCustomScreenPassShader);
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
-        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-        SHADER_PARAMETER(VECTOR2, BufferSize)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FKawaseBlurParameters, Blur)
         END_SHADER_PARAMETER_STRUCT()
+    };
+    class FKawaseBlurDownCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FKawaseBlurDownCS);
+        SHADER_USE_PARAMETER_STRUCT(FKawaseBlurDownCS, FCustomComputeShader);
 
-        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
-        {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
-        }
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_STRUCT_INCLUDE(FCustomComputeParameters, Compute)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FKawaseBlurParameters, Blur)
+        END_SHADER_PARAMETER_STRUCT()
+    };
+    class FKawaseBlurUpCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FKawaseBlurUpCS);
+        SHADER_USE_PARAMETER_STRUCT(FKawaseBlurUpCS, FCustomComputeShader);
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_STRUCT_INCLUDE(FCustomComputeParameters, Compute)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FKawaseBlurParameters, Blur)
+        END_SHADER_PARAMETER_STRUCT()
     };
     IMPLEMENT_GLOBAL_SHADER(FKawaseBlurDownPS, "/CustomShaders/DualKawaseBlur.usf", "KawaseBlurDownsamplePS", SF_Pixel);
     IMPLEMENT_GLOBAL_SHADER(FKawaseBlurUpPS, "/CustomShaders/DualKawaseBlur.usf", "KawaseBlurUpsamplePS", SF_Pixel);
+    IMPLEMENT_GLOBAL_SHADER(FKawaseBlurDownCS, "/CustomShaders/DualKawaseBlur.usf", "KawaseBlurDownsampleCS", SF_Compute);
+    IMPLEMENT_GLOBAL_SHADER(FKawaseBlurUpCS, "/CustomShaders/DualKawaseBlur.usf", "KawaseBlurUpsampleCS", SF_Compute);
 
     // Chromatic shift shader
     class FLensFlareChromaPS : public FGlobalShader
@@ -180,79 +372,139 @@ namespace
     IMPLEMENT_GLOBAL_SHADER(FLensFlareChromaPS, "/CustomShaders/Chroma.usf", "ChromaPS", SF_Pixel);
 
     // Ghost shader
-    class FLensFlareGhostsPS : public FGlobalShader
+    BEGIN_SHADER_PARAMETER_STRUCT(FLensFlareGhostsParameters, )
+    SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+    SHADER_PARAMETER_STRUCT_INCLUDE(FTileMaxParameters, TileMax)
+    END_SHADER_PARAMETER_STRUCT()
+
+    using FLensFlareGhostsPermutationDomain = TShaderPermutationDomain<FGhostCountDim, FChromaShiftDim, FTileMaxDim>;
+
+    bool ShouldCompileGhostsPermutation(const FLensFlareGhostsPermutationDomain& PermutationVector)
+    {
+        return IsGhostCountCompiled(PermutationVector.Get<FGhostCountDim>())
+            && IsFeatureCompiled(PermutationVector.Get<FChromaShiftDim>());
+    }
+
+    class FLensFlareGhostsPS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FLensFlareGhostsPS);
-        SHADER_USE_PARAMETER_STRUCT(FLensFlareGhostsPS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FLensFlareGhostsPS, FCustomScreenPassShader);
+
+        using FPermutationDomain = FLensFlareGhostsPermutationDomain;
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
-        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-        SHADER_PARAMETER_ARRAY(VECTOR4, GhostColors, [8])
-			// temporary evil hack due to the float param being converted to Vector4D with SHADER_PARAMETER_SCALAR_ARRAY
-        SHADER_PARAMETER_ARRAY(VECTOR4, GhostScales, [8])
-        SHADER_PARAMETER(float, Intensity)
-        SHADER_PARAMETER(float, ChromaShift)
-        SHADER_PARAMETER(float, Compression)
-		SHADER_PARAMETER(VECTOR2, InputScreenSize)
-		SHADER_PARAMETER_TEXTURE(Texture2D, StarburstTexture)
-		SHADER_PARAMETER_SAMPLER(SamplerState, StarburstSampler)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FLensFlareGhostsParameters, Ghosts)
         END_SHADER_PARAMETER_STRUCT()
 
         static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
         {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+            const FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+            return FCustomScreenPassShader::ShouldCompilePermutation(Parameters)
+                && ShouldCompileGhostsPermutation(PermutationVector)
+                && IsTileMaxCompiled(Parameters, PermutationVector.Get<FTileMaxDim>());
+        }
+    };
+    class FLensFlareGhostsCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FLensFlareGhostsCS);
+        SHADER_USE_PARAMETER_STRUCT(FLensFlareGhostsCS, FCustomComputeShader);
+
+        using FPermutationDomain = FLensFlareGhostsPermutationDomain;
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_STRUCT_INCLUDE(FCustomComputeParameters, Compute)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FLensFlareGhostsParameters, Ghosts)
+        END_SHADER_PARAMETER_STRUCT()
+
+        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+        {
+            return FCustomComputeShader::ShouldCompilePermutation(Parameters)
+                && ShouldCompileGhostsPermutation(FPermutationDomain(Parameters.PermutationId));
         }
     };
     IMPLEMENT_GLOBAL_SHADER(FLensFlareGhostsPS, "/CustomShaders/Ghosts.usf", "GhostsPS", SF_Pixel);
+    IMPLEMENT_GLOBAL_SHADER(FLensFlareGhostsCS, "/CustomShaders/Ghosts.usf", "GhostsCS", SF_Compute);
+
+    // Starburst shader
+    BEGIN_SHADER_PARAMETER_STRUCT(FLensFlareStarburstParameters, )
+    SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+    SHADER_PARAMETER(VECTOR2, InputScreenSize)
+    SHADER_PARAMETER_TEXTURE(Texture2D, StarburstTexture)
+    SHADER_PARAMETER_SAMPLER(SamplerState, StarburstSampler)
+    END_SHADER_PARAMETER_STRUCT()
 
-    // Ghost shader
-    class FLensFlareStarburstPS : public FGlobalShader
+    using FLensFlareStarburstPermutationDomain = TShaderPermutationDomain<FStarburstTextureDim>;
+
+    class FLensFlareStarburstPS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FLensFlareStarburstPS);
-        SHADER_USE_PARAMETER_STRUCT(FLensFlareStarburstPS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FLensFlareStarburstPS, FCustomScreenPassShader);
+
+        using FPermutationDomain = FLensFlareStarburstPermutationDomain;
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
-        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-		SHADER_PARAMETER(VECTOR2, InputScreenSize)
-		SHADER_PARAMETER_TEXTURE(Texture2D, StarburstTexture)
-		SHADER_PARAMETER_SAMPLER(SamplerState, StarburstSampler)
-        SHADER_PARAMETER(float, StarburstIntensity)
-        SHADER_PARAMETER(float, StarburstOffset)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FLensFlareStarburstParameters, Starburst)
         END_SHADER_PARAMETER_STRUCT()
 
         static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
         {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+            return FCustomScreenPassShader::ShouldCompilePermutation(Parameters)
+                && IsFeatureCompiled(FPermutationDomain(Parameters.PermutationId).Get<FStarburstTextureDim>());
+        }
+    };
+    class FLensFlareStarburstCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FLensFlareStarburstCS);
+        SHADER_USE_PARAMETER_STRUCT(FLensFlareStarburstCS, FCustomComputeShader);
+
+        using FPermutationDomain = FLensFlareStarburstPermutationDomain;
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_STRUCT_INCLUDE(FCustomComputeParameters, Compute)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FLensFlareStarburstParameters, Starburst)
+        END_SHADER_PARAMETER_STRUCT()
+
+        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+        {
+            return FCustomComputeShader::ShouldCompilePermutation(Parameters)
+                && IsFeatureCompiled(FPermutationDomain(Parameters.PermutationId).Get<FStarburstTextureDim>());
         }
     };
     IMPLEMENT_GLOBAL_SHADER(FLensFlareStarburstPS, "/CustomShaders/Starburst.usf", "StarburstPS", SF_Pixel);
+    IMPLEMENT_GLOBAL_SHADER(FLensFlareStarburstCS, "/CustomShaders/Starburst.usf", "StarburstCS", SF_Compute);
 
-    class FLensFlareHaloPS : public FGlobalShader
+    class FLensFlareHaloPS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FLensFlareHaloPS);
-        SHADER_USE_PARAMETER_STRUCT(FLensFlareHaloPS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FLensFlareHaloPS, FCustomScreenPassShader);
+
+        using FPermutationDomain = TShaderPermutationDomain<FChromaShiftDim, FStarburstTextureDim, FTileMaxDim>;
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
             SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
             SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-            SHADER_PARAMETER(float, Width)
-            SHADER_PARAMETER(float, Mask)
-            SHADER_PARAMETER(float, Compression)
-            SHADER_PARAMETER(float, Intensity)
-            SHADER_PARAMETER(float, ChromaShift)
 			SHADER_PARAMETER(VECTOR2, InputScreenSize)
 			SHADER_PARAMETER_TEXTURE(Texture2D, StarburstTexture)
 			SHADER_PARAMETER_SAMPLER(SamplerState, StarburstSampler)
+            SHADER_PARAMETER_STRUCT_INCLUDE(FTileMaxParameters, TileMax)
             END_SHADER_PARAMETER_STRUCT()
 
             static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
         {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+            const FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+            return FCustomScreenPassShader::ShouldCompilePermutation(Parameters)
+                && IsFeatureCompiled(PermutationVector.Get<FChromaShiftDim>())
+                && IsFeatureCompiled(PermutationVector.Get<FStarburstTextureDim>())
+                && IsTileMaxCompiled(Parameters, PermutationVector.Get<FTileMaxDim>());
         }
     };
     IMPLEMENT_GLOBAL_SHADER(FLensFlareHaloPS, "/CustomShaders/Halo.usf", "HaloPS", SF_Pixel);
@@ -261,6 +513,20 @@ namespace
     // Glare shaders
     //----------------------------------------------------------
 
+    // Glare layout shared by the vertex and geometry stages.
+    // Uploaded once per pass as a uniform buffer instead of
+    // setting the same loose parameters on both stages.
+    // (The glare settings themselves are in the settings buffer.)
+    BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FGlarePassParameters, )
+    SHADER_PARAMETER(FIntPoint, TileCount)
+    SHADER_PARAMETER(float, TileSize)
+    SHADER_PARAMETER(VECTOR4, PixelSize)
+    SHADER_PARAMETER(VECTOR2, BufferSize)
+    SHADER_PARAMETER(VECTOR2, BufferRatio)
+    END_GLOBAL_SHADER_PARAMETER_STRUCT()
+
+    IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FGlarePassParameters, "GlarePass");
+
     // Glare shader pass
     class FGlareVS : public FGlobalShader
     {
@@ -268,13 +534,19 @@ namespace
         DECLARE_GLOBAL_SHADER(FGlareVS);
         SHADER_USE_PARAMETER_STRUCT(FGlareVS, FGlobalShader);
 
+        using FPermutationDomain = TShaderPermutationDomain<FTileMaxDim>;
+
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
         SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
-        SHADER_PARAMETER(FIntPoint, TileCount)
-        SHADER_PARAMETER(VECTOR4, PixelSize)
-        SHADER_PARAMETER(VECTOR2, BufferSize)
+        SHADER_PARAMETER_STRUCT_REF(FGlarePassParameters, GlarePass)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FTileMaxParameters, TileMax)
         END_SHADER_PARAMETER_STRUCT()
+
+        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+        {
+            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+        }
     };
     class FGlareGS : public FGlobalShader
     {
@@ -283,65 +555,138 @@ namespace
         SHADER_USE_PARAMETER_STRUCT(FGlareGS, FGlobalShader);
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
-        SHADER_PARAMETER(VECTOR4, PixelSize)
-        SHADER_PARAMETER(VECTOR2, BufferSize)
-        SHADER_PARAMETER(VECTOR2, BufferRatio)
-        SHADER_PARAMETER(float, GlareIntensity)
-        SHADER_PARAMETER(float, GlareDivider)
-        SHADER_PARAMETER(VECTOR4, GlareTint)
-			// this was [3] float array before, consolidated out of Vector4 evil hack
-        SHADER_PARAMETER(VECTOR4, GlareScales)
+        SHADER_PARAMETER_STRUCT_REF(FPrettyPostProcessSettingsParameters, Settings)
+        SHADER_PARAMETER_STRUCT_REF(FGlarePassParameters, GlarePass)
         END_SHADER_PARAMETER_STRUCT()
+
+        static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+        {
+            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+        }
     };
-    class FGlarePS : public FGlobalShader
+    class FGlarePS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FGlarePS);
-        SHADER_USE_PARAMETER_STRUCT(FGlarePS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FGlarePS, FCustomScreenPassShader);
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_SAMPLER(SamplerState, GlareSampler)
         SHADER_PARAMETER_TEXTURE(Texture2D, GlareTexture)
         END_SHADER_PARAMETER_STRUCT()
+    };
+    IMPLEMENT_GLOBAL_SHADER(FGlareVS, "/CustomShaders/Glare.usf", "GlareVS", SF_Vertex);
+    IMPLEMENT_GLOBAL_SHADER(FGlareGS, "/CustomShaders/Glare.usf", "GlareGS", SF_Geometry);
+    IMPLEMENT_GLOBAL_SHADER(FGlarePS, "/CustomShaders/Glare.usf", "GlarePS", SF_Pixel);
+
+    // Geometry shader free glare (mobile): one instance per tile, its
+    // three quads are expanded from the vertex ID.
+    class FGlareQuadVS : public FCustomScreenPassShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FGlareQuadVS);
+        SHADER_USE_PARAMETER_STRUCT(FGlareQuadVS, FCustomScreenPassShader);
+
+        // 3 quads of 2 triangles
+        static constexpr uint32 NumPrimitives = 6;
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
+        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+        SHADER_PARAMETER_STRUCT_REF(FGlarePassParameters, GlarePass)
+        END_SHADER_PARAMETER_STRUCT()
+    };
+    IMPLEMENT_GLOBAL_SHADER(FGlareQuadVS, "/CustomShaders/Glare.usf", "GlareQuadVS", SF_Vertex);
+
+    // Matches FGlareSprite in Glare.usf
+    struct FGlareSprite
+    {
+        FVector2f TilePos;
+        FVector3f Color;
+        float Luminance;
+    };
+
+    // Compute setup of the glare: sample every tile on the compute
+    // queue and append the bright ones to a sprite list.
+    class FGlareSetupCS : public FCustomComputeShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FGlareSetupCS);
+        SHADER_USE_PARAMETER_STRUCT(FGlareSetupCS, FCustomComputeShader);
+
+        using FPermutationDomain = TShaderPermutationDomain<FTileMaxDim>;
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_RDG_TEXTURE(Texture2D, InputTexture)
+        SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Input)
+        SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
+        SHADER_PARAMETER_STRUCT_REF(FGlarePassParameters, GlarePass)
+        SHADER_PARAMETER_STRUCT_INCLUDE(FTileMaxParameters, TileMax)
+        SHADER_PARAMETER_RDG_BUFFER_UAV(RWStructuredBuffer<FGlareSprite>, RWGlareSprites)
+        SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWGlareDrawArgs)
+        END_SHADER_PARAMETER_STRUCT()
+    };
+    class FGlareSpriteVS : public FGlobalShader
+    {
+    public:
+        DECLARE_GLOBAL_SHADER(FGlareSpriteVS);
+        SHADER_USE_PARAMETER_STRUCT(FGlareSpriteVS, FGlobalShader);
+
+        BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FGlareSprite>, GlareSprites)
+        SHADER_PARAMETER_STRUCT_REF(FGlarePassParameters, GlarePass)
+        END_SHADER_PARAMETER_STRUCT()
 
         static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
         {
             return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
         }
     };
-    IMPLEMENT_GLOBAL_SHADER(FGlareVS, "/CustomShaders/Glare.usf", "GlareVS", SF_Vertex);
-    IMPLEMENT_GLOBAL_SHADER(FGlareGS, "/CustomShaders/Glare.usf", "GlareGS", SF_Geometry);
-    IMPLEMENT_GLOBAL_SHADER(FGlarePS, "/CustomShaders/Glare.usf", "GlarePS", SF_Pixel);
+    IMPLEMENT_GLOBAL_SHADER(FGlareSetupCS, "/CustomShaders/Glare.usf", "GlareSetupCS", SF_Compute);
+    IMPLEMENT_GLOBAL_SHADER(FGlareSpriteVS, "/CustomShaders/Glare.usf", "GlareSpriteVS", SF_Vertex);
+
+    // Raster pass drawing the sprites emitted by FGlareSetupCS
+    BEGIN_SHADER_PARAMETER_STRUCT(FGlareSpritePassParameters, )
+    SHADER_PARAMETER_RDG_BUFFER_SRV(StructuredBuffer<FGlareSprite>, GlareSprites)
+    RDG_BUFFER_ACCESS(IndirectDrawArgs, ERHIAccess::IndirectArgs)
+    RENDER_TARGET_BINDING_SLOTS()
+    END_SHADER_PARAMETER_STRUCT()
 
     //----------------------------------------------------------
 
     // Final bloom mix shader
-    class FMixPS : public FGlobalShader
+    class FMixPS : public FCustomScreenPassShader
     {
     public:
         DECLARE_GLOBAL_SHADER(FMixPS);
-        SHADER_USE_PARAMETER_STRUCT(FMixPS, FGlobalShader);
+        SHADER_USE_PARAMETER_STRUCT(FMixPS, FCustomScreenPassShader);
+
+        using FPermutationDomain = TShaderPermutationDomain<FMixBloomDim, FMixFlareDim, FMixGlareDim>;
 
         BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
         SHADER_PARAMETER_STRUCT_INCLUDE(FCustomPostProcessParameters, Pass)
         SHADER_PARAMETER_SAMPLER(SamplerState, InputSampler)
         SHADER_PARAMETER_RDG_TEXTURE(Texture2D, BloomTexture)
+        SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Bloom)
         SHADER_PARAMETER(float, BloomIntensity)
 		SHADER_PARAMETER(VECTOR2, InputScreenSize)
+        SHADER_PARAMETER(VECTOR4, TileUVRect)
         SHADER_PARAMETER_RDG_TEXTURE(Texture2D, GlareTexture)
+        SHADER_PARAMETER_STRUCT(FScreenPassTextureViewportParameters, Glare)
         SHADER_PARAMETER_TEXTURE(Texture2D, GradientTexture)
         SHADER_PARAMETER_SAMPLER(SamplerState, GradientSampler)
-        SHADER_PARAMETER(VECTOR4, FlareTint)
-        SHADER_PARAMETER(VECTOR2, InputViewportSize)
         SHADER_PARAMETER(VECTOR2, BufferSize)
         SHADER_PARAMETER(VECTOR2, PixelSize)
-        SHADER_PARAMETER(FIntVector, MixPass)
-        SHADER_PARAMETER(float, FlareIntensity)
         END_SHADER_PARAMETER_STRUCT()
 
         static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
         {
-            return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+            const FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+            return FCustomScreenPassShader::ShouldCompilePermutation(Parameters)
+                && IsFeatureCompiled(PermutationVector.Get<FMixBloomDim>())
+                && IsFeatureCompiled(PermutationVector.Get<FMixFlareDim>())
+                && IsFeatureCompiled(PermutationVector.Get<FMixGlareDim>());
         }
     };
     IMPLEMENT_GLOBAL_SHADER(FMixPS, "/CustomShaders/Mix.usf", "MixPS", SF_Pixel);
@@ -391,137 +736,1567 @@ TAutoConsoleVariable<int32> CVarRenderGlarePass(
     TEXT(" 1: Render glare pass (star shape)"),
     ECVF_RenderThreadSafe);
 
-//----------------------------------------------------------
+TAutoConsoleVariable<int32> CVarQuality(
+    TEXT("r.PrettyPostProcess.Quality"),
+    -1,
+    TEXT("Pipeline preset (bloom passes, blur steps, ghosts, glare density, resolution and precision)\n")
+    TEXT(" -1: Follow sg.PostProcessQuality\n")
+    TEXT(" 0: Low\n")
+    TEXT(" 1: Medium\n")
+    TEXT(" 2: High\n")
+    TEXT(" 3: Epic\n")
+    TEXT(" 4: Cinematic"),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<float> CVarBudget(
+    TEXT("r.PrettyPostProcess.Budget"),
+    0.0f,
+    TEXT("GPU time budget of the whole effect in milliseconds (0 to disable).\n")
+    TEXT("When above it, glare, then flare, then bloom are progressively degraded.\n")
+    TEXT("Stages are timed on the graphics queue, so async compute is disabled while a budget is set."),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSceneCaptureQuality(
+    TEXT("r.PrettyPostProcess.SceneCaptureQuality"),
+    1,
+    TEXT("What scene captures, planar reflections and reflection captures render\n")
+    TEXT(" 0: Nothing\n")
+    TEXT(" 1: Bloom only\n")
+    TEXT(" 2: Reduced bloom and flare\n")
+    TEXT(" 3: Everything"),
+    ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarMinViewSize(
+    TEXT("r.PrettyPostProcess.MinViewSize"),
+    64,
+    TEXT("Views smaller than this size (in pixels, on either axis) are skipped entirely (thumbnails, minimaps, etc.)"),
+    ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarReducedViewSize(
+    TEXT("r.PrettyPostProcess.ReducedViewSize"),
+    480,
+    TEXT("Views smaller than this size (in pixels, on either axis) render the reduced pipeline"),
+    ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarPrecachePipelines(
+    TEXT("r.PrettyPostProcess.PrecachePipelines"),
+    1,
+    TEXT(" 0: Pipelines are created at first use\n")
+    TEXT(" 1: Precache every pipeline of the plugin at startup (when PSO precaching is enabled)"),
+    ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarMobileGlare(
+    TEXT("r.PrettyPostProcess.Mobile.Glare"),
+    1,
+    TEXT(" 0: Don't render the glare on the mobile feature levels\n")
+    TEXT(" 1: Render the glare with quads expanded in the vertex shader (no geometry shader)"),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarAsyncCompute(
+    TEXT("r.PrettyPostProcess.AsyncCompute"),
+    1,
+    TEXT(" 0: Render flare and glare on the graphics queue\n")
+    TEXT(" 1: Render flare and glare with compute shaders on the async compute queue (when supported)"),
+    ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarTileMax(
+    TEXT("r.PrettyPostProcess.TileMax"),
+    1,
+    TEXT(" 0: Ghosts, halo and glare sample the whole screen\n")
+    TEXT(" 1: Build a max luminance map of the flare input and skip the dark areas (not on mobile)"),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<float> CVarTileMaxThreshold(
+    TEXT("r.PrettyPostProcess.TileMax.Threshold"),
+    0.01f,
+    TEXT("Luminance (sum of the channels) under which the ghosts and halo skip a fetch.\n")
+    TEXT("The glare always uses its own sprite threshold, which is exact."),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarTiledResolution(
+    TEXT("r.PrettyPostProcess.Tiled.Resolution"),
+    1024,
+    TEXT("Tiled renders: max size of the whole frame the low frequency stages (small bloom levels, flare, halo, glare) run at.\n")
+    TEXT("Bounds their memory whatever the output resolution, the tiles only compute the bloom levels above it."),
+    ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarAutoSkip(
+    TEXT("r.PrettyPostProcess.AutoSkip"),
+    1,
+    TEXT(" 0: Always render flare and glare\n")
+    TEXT(" 1: Read the max luminance map back and stop rendering flare and glare while the view stays too dark for them (needs r.PrettyPostProcess.TileMax)"),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarStaticCache(
+    TEXT("r.PrettyPostProcess.StaticCache"),
+    0,
+    TEXT(" 0: Render every frame\n")
+    TEXT(" 1: Reuse the output of the previous frames while the camera, the settings and the scene color stay the same\n")
+    TEXT("    (menus, pause screens, photo mode). Scene color changes are read back a few frames late, not on mobile."),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<float> CVarStaticCacheThreshold(
+    TEXT("r.PrettyPostProcess.StaticCache.Threshold"),
+    0.01f,
+    TEXT("Relative change of the average luminance of a screen cell (16x16 grid) over which a view is no longer static."),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarStaticCacheFrames(
+    TEXT("r.PrettyPostProcess.StaticCache.Frames"),
+    4,
+    TEXT("Static frames in a row (as read back) before a view reuses its output."),
+    ECVF_Scalability | ECVF_RenderThreadSafe);
 
+//----------------------------------------------------------
+// Stats
+//----------------------------------------------------------
+// GPU time of each stage ("stat gpu" and the GPU category of the CSV
+// profiler). Nested stats are exclusive, PrettyPostProcess only keeps what
+// the stages don't cover. Passes on the async compute queue are not
+// measured by the engine, the flare and glare need
+// r.PrettyPostProcess.AsyncCompute 0 to show up.
 DECLARE_GPU_STAT(PrettyPostProcess)
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessBloomDown, TEXT("PrettyPostProcess Bloom Down"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessBloomUp, TEXT("PrettyPostProcess Bloom Up"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessHalo, TEXT("PrettyPostProcess Halo"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessGhosts, TEXT("PrettyPostProcess Ghosts"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessBlur, TEXT("PrettyPostProcess Blur"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessStarburst, TEXT("PrettyPostProcess Starburst"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessGlare, TEXT("PrettyPostProcess Glare"))
+DECLARE_GPU_STAT_NAMED(PrettyPostProcessMix, TEXT("PrettyPostProcess Mix"))
+
+// CPU time of the render functions ("stat PrettyPostProcess", also
+// timing events in Insights) and of the same scopes in the CSV profiler
+DECLARE_STATS_GROUP(TEXT("PrettyPostProcess"), STATGROUP_PrettyPostProcess, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Render"), STAT_PrettyPostProcess_Render, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("BuildPassPlan"), STAT_PrettyPostProcess_BuildPassPlan, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderBloomDownsample"), STAT_PrettyPostProcess_RenderBloomDownsample, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderBloomUpsample"), STAT_PrettyPostProcess_RenderBloomUpsample, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderDownsample"), STAT_PrettyPostProcess_RenderDownsample, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderTileMax"), STAT_PrettyPostProcess_RenderTileMax, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderSignature"), STAT_PrettyPostProcess_RenderSignature, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderUpsampleCombine"), STAT_PrettyPostProcess_RenderUpsampleCombine, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderFlarePass"), STAT_PrettyPostProcess_RenderFlarePass, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderGhosts"), STAT_PrettyPostProcess_RenderGhosts, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderBlur"), STAT_PrettyPostProcess_RenderBlur, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderStarburst"), STAT_PrettyPostProcess_RenderStarburst, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderHalo"), STAT_PrettyPostProcess_RenderHalo, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderGlarePass"), STAT_PrettyPostProcess_RenderGlarePass, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderGlare"), STAT_PrettyPostProcess_RenderGlare, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("RenderTiledLowFrequency"), STAT_PrettyPostProcess_RenderTiledLowFrequency, STATGROUP_PrettyPostProcess);
+DECLARE_CYCLE_STAT(TEXT("Mix"), STAT_PrettyPostProcess_Mix, STATGROUP_PrettyPostProcess);
+
+// What the views recorded this frame, summed over the views
+DECLARE_DWORD_COUNTER_STAT(TEXT("Passes"), STAT_PrettyPostProcess_Passes, STATGROUP_PrettyPostProcess);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Texture Memory (MB)"), STAT_PrettyPostProcess_TextureMemory, STATGROUP_PrettyPostProcess);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ghosts"), STAT_PrettyPostProcess_Ghosts, STATGROUP_PrettyPostProcess);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Glare Sprites"), STAT_PrettyPostProcess_GlareSprites, STATGROUP_PrettyPostProcess);
+
+CSV_DEFINE_CATEGORY(PrettyPostProcess, true);
+
+TRACE_DECLARE_INT_COUNTER(PrettyPostProcessPasses, TEXT("PrettyPostProcess/Passes"));
+TRACE_DECLARE_MEMORY_COUNTER(PrettyPostProcessTextureMemory, TEXT("PrettyPostProcess/TextureMemory"));
+TRACE_DECLARE_INT_COUNTER(PrettyPostProcessGhosts, TEXT("PrettyPostProcess/Ghosts"));
+TRACE_DECLARE_INT_COUNTER(PrettyPostProcessGlareSprites, TEXT("PrettyPostProcess/GlareSprites"));
+
+// CPU scope of a render function: cycle stat and CSV timer
+#define PRETTYPOSTPROCESS_CPU_SCOPE(Name) \
+    SCOPE_CYCLE_COUNTER(STAT_PrettyPostProcess_##Name); \
+    CSV_SCOPED_TIMING_STAT(PrettyPostProcess, Name)
 
 //----------------------------------------------------------
 // Subsystem core functions
 //----------------------------------------------------------
 
-void UPostProcessSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+// Ends a warm-up once the pipelines it requested are compiled
+static void EndWarmUp(const TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe>& PendingWarmUps, const FGraphEventArray& CompileEvents)
 {
-    Super::Initialize(Collection);
+    if (CompileEvents.Num() == 0)
+    {
+        PendingWarmUps->Decrement();
+        return;
+    }
+
+    FFunctionGraphTask::CreateAndDispatchWhenReady(
+        [PendingWarmUps]()
+        {
+            PendingWarmUps->Decrement();
+        },
+        TStatId(),
+        &CompileEvents,
+        ENamedThreads::AnyThread
+    );
+}
+
+void UPostProcessSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    //--------------------------------
+    // Setup delegate
+    //--------------------------------
+    FPP_CustomBloomFlare::FDelegate Delegate = FPP_CustomBloomFlare::FDelegate::CreateLambda(
+        [=, this](FRDGBuilder& GraphBuilder, const FViewInfo& View, const FScreenPassTexture& SceneColor, FScreenPassTexture& Output)
+        {
+            Render(GraphBuilder, View, SceneColor, Output);
+        });
+
+    const bool bPrecachePipelines = CVarPrecachePipelines.GetValueOnGameThread() != 0
+        && PipelineStateCache::IsPSOPrecachingEnabled();
+
+    if (bPrecachePipelines)
+    {
+        PendingWarmUps->Increment();
+    }
+
+    ENQUEUE_RENDER_COMMAND(BindRenderThreadDelegates)([this, Delegate, bPrecachePipelines](FRHICommandListImmediate& RHICmdList)
+        {
+            // States are created before the delegate is visible so that
+            // concurrent Render() calls never have to initialize them.
+            InitStates();
+
+            if (bPrecachePipelines)
+            {
+                FGraphEventArray CompileEvents;
+                PrecachePipelines(RHICmdList, GMaxRHIFeatureLevel, CompileEvents);
+                EndWarmUp(PendingWarmUps, CompileEvents);
+            }
+
+            BudgetGovernor = MakeShared<FPostProcessBudgetGovernor>();
+            AutoSkip = MakeShared<FPostProcessAutoSkip>();
+            StaticCache = MakeShared<FPostProcessStaticCache>();
+            CaptureRecorder = MakeShared<FPostProcessCaptureRecorder>();
+
+            RenderDelegateHandle = PP_CustomBloomFlare.Add(Delegate);
+        });
+
+    //--------------------------------
+    // Data asset loading
+    // NOTE: Ideally this would be something that Developer Setting would set,
+	//		 however, it crashes everytime you adjust the values. This is not
+	//		 ideal, but works.
+    //--------------------------------
+    DataAssetHandle = StreamableManager.RequestAsyncLoad(
+        GetDefaultDataAssetPath(),
+        FStreamableDelegate::CreateUObject(this, &UPostProcessSubsystem::OnDataAssetLoaded),
+        FStreamableManager::AsyncLoadHighPriority
+    );
+
+#if WITH_EDITOR
+    ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddUObject(
+        this,
+        &UPostProcessSubsystem::OnObjectPropertyChanged
+    );
+#endif
+}
+
+void UPostProcessSubsystem::Deinitialize()
+{
+#if WITH_EDITOR
+    FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+#endif
+
+    for (TSharedPtr<FStreamableHandle>* Handle : { &DataAssetHandle, &PendingTexturesHandle, &TexturesHandle })
+    {
+        if (Handle->IsValid())
+        {
+            (*Handle)->CancelHandle();
+            Handle->Reset();
+        }
+    }
+
+    // The queries, readbacks, uniform buffer, blend and sampler states have
+    // to be released on the render thread, once Render() can no longer be called
+    ENQUEUE_RENDER_COMMAND(ReleaseRenderResources)([this](FRHICommandListImmediate& RHICmdList)
+        {
+            PP_CustomBloomFlare.Remove(RenderDelegateHandle);
+            RenderDelegateHandle.Reset();
+
+            ClearBlendState = nullptr;
+            AdditiveBlendState = nullptr;
+            BilinearClampSampler = nullptr;
+            BilinearBorderSampler = nullptr;
+            BilinearRepeatSampler = nullptr;
+            NearestRepeatSampler = nullptr;
+
+            {
+                FScopeLock Lock(&FootprintLock);
+                StructureCallback = nullptr;
+            }
+
+            BudgetGovernor.Reset();
+            AutoSkip.Reset();
+            StaticCache.Reset();
+            CaptureRecorder.Reset();
+            SettingsProxy.Reset();
+            Tile.Reset();
+            TiledFrame = FPostProcessTiledFrame();
+        });
+
+    // The command uses the subsystem, which may be destroyed right after
+    FlushRenderingCommands();
+}
+
+void UPostProcessSubsystem::UpdateSettingsProxy()
+{
+    TSharedPtr<FPostProcessSettingsProxy, ESPMode::ThreadSafe> NewProxy;
+
+    const UPostProcessDataAsset* Asset = DataAssetOverride != nullptr ? DataAssetOverride : PostProcessDataAsset;
+
+    if (Asset != nullptr)
+    {
+        NewProxy = MakeShared<FPostProcessSettingsProxy, ESPMode::ThreadSafe>(*Asset);
+    }
+
+    // Views being recorded keep their own reference to the previous proxy
+    ENQUEUE_RENDER_COMMAND(UpdateSettingsProxy)(
+        [this, NewProxy](FRHICommandListImmediate& RHICmdList)
+        {
+            if (NewProxy.IsValid())
+            {
+                NewProxy->InitRHI();
+            }
+
+            SettingsProxy = NewProxy;
+        });
+}
+
+FSoftObjectPath UPostProcessSubsystem::GetDefaultDataAssetPath()
+{
+    return FSoftObjectPath(TEXT("/PrettyPostProcess/DA_PostProcess_Default.DA_PostProcess_Default"));
+}
+
+void UPostProcessSubsystem::SetDataAssetOverride(UPostProcessDataAsset* Asset)
+{
+    DataAssetOverride = Asset;
+
+    // While the textures of the data asset are loading, going back to it
+    // waits for them like the first time
+    if (Asset != nullptr || !PendingTexturesHandle.IsValid())
+    {
+        UpdateSettingsProxy();
+    }
+}
+
+void UPostProcessSubsystem::OnDataAssetLoaded()
+{
+    PostProcessDataAsset = Cast<UPostProcessDataAsset>(DataAssetHandle->GetLoadedAsset());
+
+    // The asset stays referenced by the property above
+    DataAssetHandle.Reset();
+
+    RequestTextures();
+}
+
+void UPostProcessSubsystem::RequestTextures()
+{
+    if (PostProcessDataAsset == nullptr)
+    {
+        return;
+    }
+
+    // A newer set of textures supersedes the one still in flight
+    if (PendingTexturesHandle.IsValid())
+    {
+        PendingTexturesHandle->CancelHandle();
+        PendingTexturesHandle.Reset();
+    }
+
+    TArray<FSoftObjectPath> Paths;
+    PostProcessDataAsset->GetTexturePaths(Paths);
+
+    if (Paths.Num() == 0)
+    {
+        OnTexturesLoaded();
+        return;
+    }
+
+    PendingTexturesHandle = StreamableManager.RequestAsyncLoad(
+        MoveTemp(Paths),
+        FStreamableDelegate::CreateUObject(this, &UPostProcessSubsystem::OnTexturesLoaded),
+        FStreamableManager::AsyncLoadHighPriority
+    );
+}
+
+void UPostProcessSubsystem::OnTexturesLoaded()
+{
+    if (PendingTexturesHandle.IsValid())
+    {
+        TArray<UObject*> Textures;
+        PendingTexturesHandle->GetLoadedAssets(Textures);
+
+        // These textures are small and sampled every frame, keep all their
+        // mips resident so the proxy never reads a partially streamed one.
+        for (UObject* Object : Textures)
+        {
+            if (UTexture2D* Texture = Cast<UTexture2D>(Object))
+            {
+                Texture->bForceMiplevelsToBeResident = true;
+                Texture->bIgnoreStreamingMipBias = true;
+            }
+        }
+    }
+
+    // The previous textures are released once the new proxy is queued,
+    // the render command releasing their resources comes after it.
+    UpdateSettingsProxy();
+
+    TexturesHandle = MoveTemp(PendingTexturesHandle);
+}
+
+#if WITH_EDITOR
+void UPostProcessSubsystem::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+{
+    if (Object != nullptr && Object == PostProcessDataAsset)
+    {
+        // Textures may have been swapped, the proxy is rebuilt once they are loaded
+        RequestTextures();
+    }
+}
+#endif
+
+
+// Presets indexed like sg.PostProcessQuality.
+// Epic matches the look of the data asset as authored.
+static const FPostProcessQualityPreset GQualityPresets[] =
+{
+    // Passes, BlurSteps, Ghosts, GlareTileSize, FlareMip, HighPrecision
+    { 4, 1, 4, 4, 1, false }, // Low
+    { 5, 1, 6, 4, 0, false }, // Medium
+    { 6, 2, 8, 2, 0, false }, // High
+    { 7, 8, 8, 2, 0, false }, // Epic
+    { 7, 8, 8, 2, 0, true  }  // Cinematic
+};
+
+const FPostProcessQualityPreset& FPostProcessQualityPreset::Get(int32 Quality)
+{
+    return GQualityPresets[FMath::Clamp(Quality, 0, int32(UE_ARRAY_COUNT(GQualityPresets)) - 1)];
+}
+
+static const FPostProcessQualityPreset& GetQualityPreset()
+{
+    int32 Quality = CVarQuality.GetValueOnRenderThread();
+
+    if (Quality < 0)
+    {
+        static const TConsoleVariableData<int32>* CVarPostProcessQuality =
+            IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("sg.PostProcessQuality"));
+
+        Quality = CVarPostProcessQuality != nullptr ? CVarPostProcessQuality->GetValueOnAnyThread() : 3;
+    }
+
+    return FPostProcessQualityPreset::Get(Quality);
+}
+
+// Format of the intermediate buffers
+static EPixelFormat GetIntermediateFormat(const FPostProcessRenderContext& Context)
+{
+    // Mobile: always the smallest HDR format (half the bandwidth of FP16)
+    // when it can be rendered to.
+    if (Context.bMobile)
+    {
+        return Context.bR11G11B10RenderTarget ? PF_FloatR11G11B10 : PF_FloatRGBA;
+    }
+
+    return Context.Preset.bHighPrecision ? PF_FloatRGBA : PF_FloatRGB;
+}
+
+// Pick what a view is allowed to render based on what kind of view it is
+static EPostProcessViewQuality GetViewQuality(const FViewInfo& View)
+{
+    EPostProcessViewQuality Quality = EPostProcessViewQuality::Full;
+
+    const int32 ViewSize = FMath::Min(View.ViewRect.Width(), View.ViewRect.Height());
+
+    if (ViewSize < CVarMinViewSize.GetValueOnRenderThread())
+    {
+        return EPostProcessViewQuality::Skip;
+    }
+
+    if (ViewSize < CVarReducedViewSize.GetValueOnRenderThread())
+    {
+        Quality = EPostProcessViewQuality::Reduced;
+    }
+
+    if (View.bIsSceneCapture || View.bIsPlanarReflection || View.bIsReflectionCapture)
+    {
+        const int32 CaptureQuality = FMath::Clamp(
+            CVarSceneCaptureQuality.GetValueOnRenderThread(),
+            int32(EPostProcessViewQuality::Skip),
+            int32(EPostProcessViewQuality::Full)
+        );
+
+        Quality = FMath::Min(Quality, EPostProcessViewQuality(CaptureQuality));
+    }
+
+    // Views (and scene capture components) can opt out of the lens
+    // effects through the regular "Lens Flares" show flag.
+    if (View.Family != nullptr && !View.Family->EngineShowFlags.LensFlares)
+    {
+        Quality = FMath::Min(Quality, EPostProcessViewQuality::BloomOnly);
+    }
+
+    return Quality;
+}
+
+void UPostProcessSubsystem::InitStates()
+{
+    if (ClearBlendState != nullptr)
+    {
+        return;
+    }
+
+    // Blend modes from:
+    // '/Engine/Source/Runtime/RenderCore/Private/ClearQuad.cpp'
+    // '/Engine/Source/Runtime/Renderer/Private/PostProcess/PostProcessMaterial.cpp'
+    ClearBlendState = TStaticBlendState<>::GetRHI();
+    AdditiveBlendState = TStaticBlendState<CW_RGB, BO_Add, BF_One, BF_One>::GetRHI();
+
+    BilinearClampSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+    BilinearBorderSampler = TStaticSamplerState<SF_Bilinear, AM_Border, AM_Border, AM_Border>::GetRHI();
+    BilinearRepeatSampler = TStaticSamplerState<SF_Bilinear, AM_Wrap, AM_Wrap, AM_Wrap>::GetRHI();
+    NearestRepeatSampler = TStaticSamplerState<SF_Point, AM_Wrap, AM_Wrap, AM_Wrap>::GetRHI();
+}
+
+// Report a pass to the footprint being captured, if any
+template<typename TShaderParameters>
+inline void TrackPass(
+    const FPostProcessRenderContext& Context,
+    const TCHAR* PassName,
+    const TShaderParameters* PassParameters
+)
+{
+    if (Context.Footprint != nullptr)
+    {
+        Context.Footprint->AddPass(PassName, PassParameters);
+    }
+
+    if (Context.Counters != nullptr)
+    {
+        Context.Counters->Passes++;
+    }
+}
+
+// Create a transient texture, counted in the stats
+// (RDG keeps the name pointer, it has to be a literal.)
+static FRDGTextureRef CreatePassTexture(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    const FRDGTextureDesc& Description,
+    const TCHAR* Name
+)
+{
+    if (Context.Counters != nullptr)
+    {
+        Context.Counters->TextureBytes += FPostProcessFootprint::GetTextureSize(Description.Extent, Description.Format);
+    }
+
+    return GraphBuilder.CreateTexture(Description, Name);
+}
+
+// The function that draw a shader into a given RenderGraph texture
+template<typename TShaderParameters, typename TShaderClassVertex, typename TShaderClassPixel>
+inline void DrawShaderPass(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    FRDGEventName&& PassName,
+    TShaderParameters* PassParameters,
+    TShaderMapRef<TShaderClassVertex> VertexShader,
+    TShaderMapRef<TShaderClassPixel> PixelShader,
+    FRHIBlendState* BlendState,
+    const FIntRect& Viewport
+)
+{
+    const FScreenPassPipelineState PipelineState(VertexShader, PixelShader, BlendState);
+
+    TrackPass(Context, PassName.GetTCHAR(), PassParameters);
+
+    GraphBuilder.AddPass(
+        MoveTemp(PassName),
+        PassParameters,
+        ERDGPassFlags::Raster,
+        [PixelShader, PassParameters, Viewport, PipelineState](FRHICommandList& RHICmdList)
+        {
+            RHICmdList.SetViewport(
+                Viewport.Min.X, Viewport.Min.Y, 0.0f,
+                Viewport.Max.X, Viewport.Max.Y, 1.0f
+            );
+
+            SetScreenPassPipelineState(RHICmdList, PipelineState);
+
+            SetShaderParameters(
+                RHICmdList,
+                PixelShader,
+                PixelShader.GetPixelShader(),
+                *PassParameters
+            );
+
+            UE::Renderer::PostProcess::DrawRectangle(
+                RHICmdList,                             // FRHICommandList
+                PipelineState.VertexShader,             // const TShaderRefBase VertexShader
+                0.0f, 0.0f,                             // float X, float Y
+                Viewport.Width(), Viewport.Height(),    // float SizeX, float SizeY
+                0.0f, 0.0f,                             // float U, float V
+                Viewport.Width(),                       // float SizeU
+                Viewport.Height(),                      // float SizeV
+                Viewport.Size(),                        // FIntPoint TargetSize
+                Viewport.Size(),                        // FIntPoint TextureSize
+                EDrawRectangleFlags::EDRF_Default       // EDrawRectangleFlags Flags
+            );
+
+        });
+}
+
+// The function that dispatch a compute shader over a given viewport,
+// on the async compute queue by default (compute variant of DrawShaderPass)
+template<typename TShaderClass>
+inline void DispatchShaderPass(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    FRDGEventName&& PassName,
+    typename TShaderClass::FParameters* PassParameters,
+    TShaderMapRef<TShaderClass> ComputeShader,
+    const FIntRect& Viewport,
+    ERDGPassFlags PassFlags = ERDGPassFlags::AsyncCompute
+)
+{
+    TrackPass(Context, PassName.GetTCHAR(), PassParameters);
+
+    FComputeShaderUtils::AddPass(
+        GraphBuilder,
+        MoveTemp(PassName),
+        PassFlags,
+        ComputeShader,
+        PassParameters,
+        FComputeShaderUtils::GetGroupCount(Viewport.Size(), FCustomComputeShader::ThreadGroupSize)
+    );
+}
+
+// Format of the textures written by compute passes. R11G11B10 is
+// not a valid typed UAV everywhere, so fallback on FP16 if needed.
+static EPixelFormat GetComputeFormat(const FPostProcessRenderContext& Context)
+{
+    return !Context.Preset.bHighPrecision && Context.bR11G11B10TypedUAVStore
+        ? PF_FloatR11G11B10
+        : PF_FloatRGBA;
+}
+
+// Texture written by a compute pass
+// (RDG keeps the name pointer, it has to be a literal.)
+static FRDGTextureRef CreateComputeTexture(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    const TCHAR* Name,
+    const FIntPoint& Extent
+)
+{
+    const FRDGTextureDesc Description = FRDGTextureDesc::Create2D(
+        Extent,
+        GetComputeFormat(Context),
+        FClearValueBinding::Black,
+        TexCreate_ShaderResource | TexCreate_UAV
+    );
+
+    return CreatePassTexture(GraphBuilder, Context, Description, Name);
+}
+
+// Viewport of an internal target. The extent is kept (it only depends on
+// the scene color extent) but the rect is moved to the origin: only the
+// scene color can be offset and compute passes write from the origin.
+static FScreenPassTextureViewport GetTargetViewport(const FScreenPassTextureViewport& Viewport)
+{
+    return FScreenPassTextureViewport(Viewport.Extent, FIntRect(FIntPoint::ZeroValue, Viewport.Rect.Size()));
+}
+
+// Viewport parameters of a texture read by a pass. Internal textures are
+// allocated at fixed extents and only their view rect holds valid data.
+static FScreenPassTextureViewportParameters GetTextureViewportParameters(const FScreenPassTexture& Texture)
+{
+    return GetScreenPassTextureViewportParameters(FScreenPassTextureViewport(Texture));
+}
+
+// Same over a part of the rect (UVRect: min and max in viewport UV), for
+// a tile reading a whole frame texture. Fetches are still clamped to the
+// whole rect. Only the UV fields are cropped, shaders go through them.
+static FScreenPassTextureViewportParameters GetTextureViewportParameters(const FScreenPassTexture& Texture, const FVector4f& UVRect)
+{
+    FScreenPassTextureViewportParameters Parameters = GetTextureViewportParameters(Texture);
+
+    const FVector2f UVMin = Parameters.UVViewportMin + Parameters.UVViewportSize * FVector2f(UVRect.X, UVRect.Y);
+    const FVector2f UVMax = Parameters.UVViewportMin + Parameters.UVViewportSize * FVector2f(UVRect.Z, UVRect.W);
+
+    Parameters.UVViewportMin = UVMin;
+    Parameters.UVViewportMax = UVMax;
+    Parameters.UVViewportSize = UVMax - UVMin;
+    Parameters.UVViewportSizeInverse = FVector2f(1.0f, 1.0f) / Parameters.UVViewportSize;
+
+    return Parameters;
+}
+
+static FCustomComputeParameters GetComputeParameters(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    const FScreenPassTexture& InputTexture,
+    FRDGTextureRef OutputTexture,
+    const FIntRect& Viewport
+)
+{
+    FCustomComputeParameters Parameters;
+    Parameters.Settings = Context.Settings->GetUniformBuffer();
+    Parameters.InputTexture = InputTexture.Texture;
+    Parameters.Input = GetTextureViewportParameters(InputTexture);
+    Parameters.RWOutputTexture = GraphBuilder.CreateUAV(OutputTexture);
+    Parameters.OutputSize = FVector2f(Viewport.Size());
+    return Parameters;
+}
+
+// Tile max lookup of a pass, unbound (and compiled out) without a map
+static FTileMaxParameters GetTileMaxParameters(const FPostProcessRenderContext& Context)
+{
+    FTileMaxParameters Parameters;
+    Parameters.TileMaxTexture = Context.TileMaxTexture;
+    Parameters.TileMaxScale = Context.TileMaxScale;
+    Parameters.TileMaxThreshold = CVarTileMaxThreshold.GetValueOnRenderThread();
+    return Parameters;
+}
+
+// Pipeline shared by the glare raster paths: a point list expanded by
+// the GS, or a triangle list expanded by the vertex shader on mobile.
+static void SetGlarePipelineState(
+    FRHICommandList& RHICmdList,
+    FRHIVertexShader* VertexShader,
+    FRHIGeometryShader* GeometryShader,
+    FRHIPixelShader* PixelShader,
+    FRHIBlendState* BlendState,
+    EPrimitiveType PrimitiveType
+)
+{
+    FGraphicsPipelineStateInitializer GraphicsPSOInit;
+    RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
+    GraphicsPSOInit.BlendState = BlendState;
+    GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
+    GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+    GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GEmptyVertexDeclaration.VertexDeclarationRHI;
+    GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader;
+    GraphicsPSOInit.BoundShaderState.SetGeometryShader(GeometryShader);
+    GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader;
+    GraphicsPSOInit.PrimitiveType = PrimitiveType;
+    // TODO: Get StencilRef for this
+    SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
+}
+
+//----------------------------------------------------------
+// Pipeline precaching
+//----------------------------------------------------------
+
+// Formats the passes can render to (see GetIntermediateFormat)
+static TArrayView<const EPixelFormat> GetIntermediateFormats(ERHIFeatureLevel::Type FeatureLevel)
+{
+    static const EPixelFormat DesktopFormats[] = { PF_FloatRGB, PF_FloatRGBA };
+    static const EPixelFormat MobileFormats[] = { PF_FloatR11G11B10, PF_FloatRGBA };
+
+    if (FeatureLevel >= ERHIFeatureLevel::SM5)
+    {
+        return DesktopFormats;
+    }
+
+    return MobileFormats;
+}
+
+// Fixed function state shared by all the graphics pipelines
+// (matches FScreenPassPipelineState and SetGlarePipelineState)
+static FGraphicsPipelineStateInitializer GetPipelineInitializer(FRHIBlendState* BlendState, EPixelFormat Format)
+{
+    FGraphicsPipelineStateInitializer Initializer;
+    Initializer.BlendState = BlendState;
+    Initializer.RasterizerState = TStaticRasterizerState<>::GetRHI();
+    Initializer.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+    Initializer.RenderTargetsEnabled = 1;
+    Initializer.RenderTargetFormats[0] = UE_PIXELFORMAT_TO_UINT8(Format);
+    Initializer.RenderTargetFlags[0] = TexCreate_RenderTargetable | TexCreate_ShaderResource;
+    Initializer.NumSamples = 1;
+    return Initializer;
+}
+
+// A shader of the map, null when it isn't compiled for the platform.
+// (The typed getters assert on missing shaders.)
+template<typename ShaderType>
+static TShaderRef<FShader> FindShader(FGlobalShaderMap* ShaderMap, int32 PermutationId = 0)
+{
+    return ShaderMap->GetShader(&ShaderType::GetStaticType(), PermutationId);
+}
+
+// Every compiled permutation of a shader
+template<typename ShaderType>
+static void CollectPermutations(FGlobalShaderMap* ShaderMap, TArray<TShaderRef<FShader>>& OutShaders)
+{
+    for (int32 PermutationId = 0; PermutationId < ShaderType::FPermutationDomain::PermutationCount; PermutationId++)
+    {
+        // Pruned permutations are simply not in the map
+        TShaderRef<FShader> Shader = FindShader<ShaderType>(ShaderMap, PermutationId);
+
+        if (Shader.IsValid())
+        {
+            OutShaders.Add(Shader);
+        }
+    }
+}
+
+// Every graphics pipeline the plugin can bind, for all the shader
+// permutations and render target format combinations.
+static void CollectGraphicsPipelines(
+    FGlobalShaderMap* ShaderMap,
+    ERHIFeatureLevel::Type FeatureLevel,
+    TArray<FGraphicsPipelineStateInitializer>& OutInitializers
+)
+{
+    FRHIBlendState* ClearBlendState = TStaticBlendState<>::GetRHI();
+    FRHIBlendState* AdditiveBlendState = TStaticBlendState<CW_RGB, BO_Add, BF_One, BF_One>::GetRHI();
+
+    // Full screen passes (see DrawShaderPass)
+    TShaderRef<FShader> VertexShader = FindShader<FCustomScreenPassVS>(ShaderMap);
+
+    TArray<TShaderRef<FShader>> PixelShaders;
+    CollectPermutations<FDownsamplePS>(ShaderMap, PixelShaders);
+    CollectPermutations<FUpsampleCombinePS>(ShaderMap, PixelShaders);
+    CollectPermutations<FKawaseBlurDownPS>(ShaderMap, PixelShaders);
+    CollectPermutations<FKawaseBlurUpPS>(ShaderMap, PixelShaders);
+    CollectPermutations<FLensFlareGhostsPS>(ShaderMap, PixelShaders);
+    CollectPermutations<FLensFlareStarburstPS>(ShaderMap, PixelShaders);
+    CollectPermutations<FLensFlareHaloPS>(ShaderMap, PixelShaders);
+    CollectPermutations<FMixPS>(ShaderMap, PixelShaders);
+
+    // Glare sprites (point list expanded by the geometry shader)
+    TArray<TShaderRef<FShader>> GlareVertexShaders;
+    CollectPermutations<FGlareVS>(ShaderMap, GlareVertexShaders);
+    CollectPermutations<FGlareSpriteVS>(ShaderMap, GlareVertexShaders);
+
+    TShaderRef<FShader> GlareGeometryShader = FindShader<FGlareGS>(ShaderMap);
+    TShaderRef<FShader> GlarePixelShader = FindShader<FGlarePS>(ShaderMap);
+
+    // Glare quads (mobile)
+    TShaderRef<FShader> GlareQuadVertexShader = FindShader<FGlareQuadVS>(ShaderMap);
+
+    for (EPixelFormat Format : GetIntermediateFormats(FeatureLevel))
+    {
+        for (const TShaderRef<FShader>& PixelShader : PixelShaders)
+        {
+            if (!VertexShader.IsValid())
+            {
+                continue;
+            }
+
+            FGraphicsPipelineStateInitializer& Initializer = OutInitializers.Add_GetRef(GetPipelineInitializer(ClearBlendState, Format));
+            Initializer.BoundShaderState.VertexDeclarationRHI = GFilterVertexDeclaration.VertexDeclarationRHI;
+            Initializer.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
+            Initializer.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
+            Initializer.PrimitiveType = PT_TriangleList;
+        }
+
+        if (!GlarePixelShader.IsValid())
+        {
+            continue;
+        }
+
+        for (const TShaderRef<FShader>& GlareVertexShader : GlareVertexShaders)
+        {
+            if (!GlareGeometryShader.IsValid())
+            {
+                continue;
+            }
+
+            FGraphicsPipelineStateInitializer& Initializer = OutInitializers.Add_GetRef(GetPipelineInitializer(AdditiveBlendState, Format));
+            Initializer.BoundShaderState.VertexDeclarationRHI = GEmptyVertexDeclaration.VertexDeclarationRHI;
+            Initializer.BoundShaderState.VertexShaderRHI = GlareVertexShader.GetVertexShader();
+            Initializer.BoundShaderState.SetGeometryShader(GlareGeometryShader.GetGeometryShader());
+            Initializer.BoundShaderState.PixelShaderRHI = GlarePixelShader.GetPixelShader();
+            Initializer.PrimitiveType = PT_PointList;
+        }
+
+        if (GlareQuadVertexShader.IsValid())
+        {
+            FGraphicsPipelineStateInitializer& Initializer = OutInitializers.Add_GetRef(GetPipelineInitializer(AdditiveBlendState, Format));
+            Initializer.BoundShaderState.VertexDeclarationRHI = GEmptyVertexDeclaration.VertexDeclarationRHI;
+            Initializer.BoundShaderState.VertexShaderRHI = GlareQuadVertexShader.GetVertexShader();
+            Initializer.BoundShaderState.PixelShaderRHI = GlarePixelShader.GetPixelShader();
+            Initializer.PrimitiveType = PT_TriangleList;
+        }
+    }
+}
+
+// Every compute shader of the async compute path
+static void CollectComputeShaders(FGlobalShaderMap* ShaderMap, TArray<FRHIComputeShader*>& OutShaders)
+{
+    TArray<TShaderRef<FShader>> ComputeShaders;
+    CollectPermutations<FKawaseBlurDownCS>(ShaderMap, ComputeShaders);
+    CollectPermutations<FKawaseBlurUpCS>(ShaderMap, ComputeShaders);
+    CollectPermutations<FLensFlareGhostsCS>(ShaderMap, ComputeShaders);
+    CollectPermutations<FLensFlareStarburstCS>(ShaderMap, ComputeShaders);
+    CollectPermutations<FGlareSetupCS>(ShaderMap, ComputeShaders);
+    CollectPermutations<FTileMaxCS>(ShaderMap, ComputeShaders);
+    CollectPermutations<FSignatureCS>(ShaderMap, ComputeShaders);
+
+    for (const TShaderRef<FShader>& ComputeShader : ComputeShaders)
+    {
+        OutShaders.Add(ComputeShader.GetComputeShader());
+    }
+}
+
+void UPostProcessSubsystem::PrecachePipelines(FRHICommandListImmediate& RHICmdList, ERHIFeatureLevel::Type FeatureLevel, FGraphEventArray& OutCompileEvents)
+{
+    FGlobalShaderMap* ShaderMap = GetGlobalShaderMap(FeatureLevel);
+
+    if (ShaderMap == nullptr)
+    {
+        return;
+    }
+
+    TArray<FGraphicsPipelineStateInitializer> GraphicsInitializers;
+    TArray<FRHIComputeShader*> ComputeShaders;
+
+    CollectGraphicsPipelines(ShaderMap, FeatureLevel, GraphicsInitializers);
+    CollectComputeShaders(ShaderMap, ComputeShaders);
+
+    // With PSO precaching the pipelines are compiled in the background,
+    // otherwise they are created right away (this blocks, which is fine
+    // behind a loading screen).
+    const bool bPrecache = PipelineStateCache::IsPSOPrecachingEnabled();
+
+    // Requests already compiled (or failed) have no event
+    const auto AddCompileEvent = [&OutCompileEvents](const FPSOPrecacheRequestResult& Result)
+    {
+        if (Result.AsyncCompileEvent.IsValid() && !Result.AsyncCompileEvent->IsComplete())
+        {
+            OutCompileEvents.Add(Result.AsyncCompileEvent);
+        }
+    };
+
+    for (const FGraphicsPipelineStateInitializer& Initializer : GraphicsInitializers)
+    {
+        if (bPrecache)
+        {
+            AddCompileEvent(PipelineStateCache::PrecacheGraphicsPipelineState(Initializer));
+        }
+        else
+        {
+            PipelineStateCache::GetAndOrCreateGraphicsPipelineState(RHICmdList, Initializer, EApplyRendertargetOption::DoNothing);
+        }
+    }
+
+    for (FRHIComputeShader* ComputeShader : ComputeShaders)
+    {
+        if (bPrecache)
+        {
+            AddCompileEvent(PipelineStateCache::PrecacheComputePipelineState(ComputeShader));
+        }
+        else
+        {
+            PipelineStateCache::GetAndOrCreateComputePipelineState(RHICmdList, ComputeShader, false);
+        }
+    }
+}
+
+void UPostProcessSubsystem::WarmUpPipelines()
+{
+    // Counted from now on, so IsWarmingUp() is true before the command runs
+    PendingWarmUps->Increment();
+
+    ENQUEUE_RENDER_COMMAND(PrettyPostProcessWarmUp)(
+        [PendingWarmUps = PendingWarmUps](FRHICommandListImmediate& RHICmdList)
+        {
+            FGraphEventArray CompileEvents;
+            PrecachePipelines(RHICmdList, GMaxRHIFeatureLevel, CompileEvents);
+            EndWarmUp(PendingWarmUps, CompileEvents);
+        });
+}
+
+bool UPostProcessSubsystem::IsWarmingUp() const
+{
+    return PendingWarmUps->GetValue() > 0;
+}
+
+static FAutoConsoleCommand CmdWarmUpPipelines(
+    TEXT("r.PrettyPostProcess.WarmUp"),
+    TEXT("Compile every pipeline of the plugin now (meant for loading screens)"),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            if (GEngine != nullptr)
+            {
+                if (UPostProcessSubsystem* Subsystem = GEngine->GetEngineSubsystem<UPostProcessSubsystem>())
+                {
+                    Subsystem->WarmUpPipelines();
+                }
+            }
+        })
+);
+
+//----------------------------------------------------------
+// Footprint
+//----------------------------------------------------------
+
+void UPostProcessSubsystem::DumpFootprint()
+{
+    ENQUEUE_RENDER_COMMAND(DumpFootprint)([this](FRHICommandListImmediate& RHICmdList)
+        {
+            FScopeLock Lock(&FootprintLock);
+            bFootprintRequested = true;
+        });
+}
+
+bool UPostProcessSubsystem::ShouldCaptureFootprint()
+{
+    FScopeLock Lock(&FootprintLock);
+
+    // Every view of the first frame rendered after the request
+    if (bFootprintRequested)
+    {
+        bFootprintRequested = false;
+        FootprintFrameNumber = GFrameCounterRenderThread;
+    }
+
+    return FootprintFrameNumber == GFrameCounterRenderThread;
+}
+
+static FAutoConsoleCommand CmdDumpFootprint(
+    TEXT("r.PrettyPostProcess.DumpFootprint"),
+    TEXT("Log the transient textures of the views rendered next frame, their lifetime and the peak memory"),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            if (GEngine != nullptr)
+            {
+                if (UPostProcessSubsystem* Subsystem = GEngine->GetEngineSubsystem<UPostProcessSubsystem>())
+                {
+                    Subsystem->DumpFootprint();
+                }
+            }
+        })
+);
+
+void UPostProcessSubsystem::SetStructureCallback(FStructureCallback Callback)
+{
+    ENQUEUE_RENDER_COMMAND(SetStructureCallback)([this, Callback = MoveTemp(Callback)](FRHICommandListImmediate& RHICmdList) mutable
+        {
+            FScopeLock Lock(&FootprintLock);
+            StructureCallback = MoveTemp(Callback);
+        });
+}
+
+bool UPostProcessSubsystem::ShouldRecordStructure()
+{
+    FScopeLock Lock(&FootprintLock);
+    return StructureCallback != nullptr;
+}
+
+void UPostProcessSubsystem::RecordStructure(const FPostProcessRenderContext& Context, const FPostProcessFootprint& Footprint, uint64 StartCycles)
+{
+    const double RenderMicroseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0;
+
+    FPostProcessStructure Structure;
+    Footprint.GetStructure(Structure);
+
+    // Also serializes the views recorded in parallel
+    FScopeLock Lock(&FootprintLock);
+
+    if (StructureCallback)
+    {
+        StructureCallback(Context, Structure, RenderMicroseconds);
+    }
+}
+
+//----------------------------------------------------------
+// Capture
+//----------------------------------------------------------
+
+void UPostProcessSubsystem::Capture(const FString& Filename)
+{
+    // The asset Render() uses, see UpdateSettingsProxy
+    const UPostProcessDataAsset* Asset = DataAssetOverride != nullptr ? DataAssetOverride : PostProcessDataAsset;
+
+    if (Asset == nullptr)
+    {
+        UE_LOG(LogPrettyPostProcess, Warning, TEXT("Capture: the data asset isn't loaded yet, nothing to capture"));
+        return;
+    }
+
+    FString Path = Filename;
+
+    if (Path.IsEmpty())
+    {
+        Path = FPaths::ProjectSavedDir() / TEXT("PrettyPostProcess") / TEXT("Captures")
+            / FString::Printf(TEXT("Capture_%s.%s"), *FDateTime::Now().ToString(), FPostProcessCapture::Extension);
+    }
+    else if (FPaths::GetExtension(Path).IsEmpty())
+    {
+        Path += TEXT(".");
+        Path += FPostProcessCapture::Extension;
+    }
+
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+
+    // Settings are read here, as Render() will see them next frame
+    TUniquePtr<FPostProcessCapture> NewCapture = MakeUnique<FPostProcessCapture>();
+    NewCapture->CaptureSettings(*Asset);
+
+    ENQUEUE_RENDER_COMMAND(CapturePrettyPostProcess)(
+        [this, NewCapture = MoveTemp(NewCapture), Path](FRHICommandListImmediate& RHICmdList) mutable
+        {
+            if (CaptureRecorder.IsValid())
+            {
+                CaptureRecorder->Request(MoveTemp(NewCapture), Path);
+            }
+        });
+}
+
+static FAutoConsoleCommand CmdCapture(
+    TEXT("r.PrettyPostProcess.Capture"),
+    TEXT("Save the inputs of the next main view (scene color, view, console variables and data asset) to a capture file.\n")
+    TEXT("Optional argument: file name, Saved/PrettyPostProcess/Captures by default."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            if (GEngine != nullptr)
+            {
+                if (UPostProcessSubsystem* Subsystem = GEngine->GetEngineSubsystem<UPostProcessSubsystem>())
+                {
+                    Subsystem->Capture(Args.Num() > 0 ? Args[0] : FString());
+                }
+            }
+        })
+);
+
+//----------------------------------------------------------
+// Tiled render
+//----------------------------------------------------------
+
+void UPostProcessSubsystem::BeginTiledRender(FIntPoint FrameSize)
+{
+    ENQUEUE_RENDER_COMMAND(BeginTiledRender)([this, FrameSize](FRHICommandListImmediate& RHICmdList)
+        {
+            FPostProcessTile NewTile;
+            NewTile.FrameSize = FrameSize;
+            NewTile.Rect = FIntRect(FIntPoint::ZeroValue, FrameSize);
+            Tile = NewTile;
+        });
+}
+
+void UPostProcessSubsystem::EndTiledRender()
+{
+    ENQUEUE_RENDER_COMMAND(EndTiledRender)([this](FRHICommandListImmediate& RHICmdList)
+        {
+            FScopeLock Lock(&TiledFrameLock);
+            Tile.Reset();
+            TiledFrame = FPostProcessTiledFrame();
+        });
+}
+
+void UPostProcessSubsystem::SetRenderFrame()
+{
+    ENQUEUE_RENDER_COMMAND(SetRenderFrame)([this](FRHICommandListImmediate& RHICmdList)
+        {
+            if (Tile.IsSet())
+            {
+                Tile->Rect = FIntRect(FIntPoint::ZeroValue, Tile->FrameSize);
+                Tile->bFrame = true;
+                Tile->FrameIndex++;
+            }
+        });
+}
+
+void UPostProcessSubsystem::SetRenderTile(const FIntRect& TileRect)
+{
+    ENQUEUE_RENDER_COMMAND(SetRenderTile)([this, TileRect](FRHICommandListImmediate& RHICmdList)
+        {
+            if (Tile.IsSet())
+            {
+                Tile->Rect = TileRect;
+                Tile->bFrame = false;
+            }
+        });
+}
+
+// Bloom level the tiles of a frame stop at, and size of the whole frame at
+// that level (the atlas the low frequency stages run on). Only depends on
+// the frame, so that its prepass and its tiles agree whatever their
+// resolution. False when the atlas wouldn't have two levels of its own.
+static bool GetTiledLayout(const FIntPoint& FrameSize, int32 PassAmount, int32& OutLevel, FIntPoint& OutAtlasSize)
+{
+    const int32 MaxSize = FMath::Max(CVarTiledResolution.GetValueOnRenderThread(), 16);
+
+    // Level 0 is the half resolution scene color
+    OutLevel = 1;
+    OutAtlasSize = FIntPoint::DivideAndRoundUp(FrameSize, 4);
+
+    while (OutLevel + 2 < PassAmount && OutAtlasSize.GetMax() > MaxSize)
+    {
+        OutLevel++;
+        OutAtlasSize = FIntPoint::DivideAndRoundUp(OutAtlasSize, 2);
+    }
+
+    return OutLevel + 2 <= PassAmount;
+}
+
+//----------------------------------------------------------
+// Pass plan
+//----------------------------------------------------------
+
+// Frames a plan is kept around without being used
+static constexpr uint64 PassPlanLifetime = 120;
+
+// Views without a state (most scene captures) are told apart by their
+// rect. A collision only costs a rebuild since the plan key is compared.
+static uint32 GetViewKey(const FViewInfo& View, const FIntRect& ViewRect)
+{
+    return View.GetViewKey() != 0
+        ? View.GetViewKey()
+        : HashCombine(GetTypeHash(ViewRect.Min), GetTypeHash(ViewRect.Max));
+}
+
+// Luminance under which Glare.usf emits no sprite
+static constexpr float GlareSpriteThreshold = 0.1f;
+
+FPostProcessPassPlan UPostProcessSubsystem::GetPassPlan(
+    const FViewInfo& View,
+    const FPostProcessSettingsProxy& Settings,
+    const FPostProcessPassPlanKey& Key
+)
+{
+    const uint32 ViewKey = GetViewKey(View, Key.ViewRect);
+
+    const uint64 FrameNumber = GFrameCounterRenderThread;
+
+    // Common case: the plan was already validated this frame
+    {
+        FReadScopeLock ReadLock(PassPlansLock);
+
+        const FPostProcessPassPlan* Plan = PassPlans.Find(ViewKey);
+
+        if (Plan != nullptr && Plan->LastUsedFrame == FrameNumber && Plan->Key == Key)
+        {
+            return *Plan;
+        }
+    }
+
+    FWriteScopeLock WriteLock(PassPlansLock);
+
+    FPostProcessPassPlan* Plan = PassPlans.Find(ViewKey);
+
+    if (Plan == nullptr)
+    {
+        // Drop the plans of the views that went away
+        for (auto It = PassPlans.CreateIterator(); It; ++It)
+        {
+            if (FrameNumber - It.Value().LastUsedFrame > PassPlanLifetime)
+            {
+                It.RemoveCurrent();
+            }
+        }
+
+        Plan = &PassPlans.Add(ViewKey);
+        BuildPassPlan(Settings, Key, *Plan);
+    }
+    else if (!(Plan->Key == Key))
+    {
+        BuildPassPlan(Settings, Key, *Plan);
+    }
+
+    Plan->LastUsedFrame = FrameNumber;
+
+    return *Plan;
+}
+
+void UPostProcessSubsystem::BuildPassPlan(
+    const FPostProcessSettingsProxy& Settings,
+    const FPostProcessPassPlanKey& Key,
+    FPostProcessPassPlan& Plan
+)
+{
+    PRETTYPOSTPROCESS_CPU_SCOPE(BuildPassPlan);
+
+    const FPrettyPostProcessSettingsParameters& Parameters = Settings.GetParameters();
+
+    Plan.Key = Key;
+
+    //--------------------------------
+    // Bloom levels
+    //--------------------------------
+    int32 MaxPassAmount = FMath::Min(Key.BloomPassAmount, Key.Preset.BloomPassAmount);
+
+    // Bloom only views keep the whole bloom, only the reduced pipeline has fewer passes
+    if (Key.Quality == EPostProcessViewQuality::Reduced)
+    {
+        MaxPassAmount = FMath::Min(MaxPassAmount, 4);
+    }
+
+    // Limit pass amount to not going smaller than specified resolution limit
+    int32 PassAmount = 1;
+    FIntPoint ViewSize = Key.ViewSize;
+
+    while (PassAmount < MaxPassAmount
+        && ViewSize.X > Key.BloomResLimit && ViewSize.Y > Key.BloomResLimit)
+    {
+        PassAmount++;
+        ViewSize /= 2;
+    }
+
+    Plan.PassAmount = PassAmount;
+
+    // Each level is allocated from the extent of the previous one rather
+    // than from the view rect. With dynamic resolution the extents then stay
+    // the same every frame (only the rendered rect changes) and the
+    // transient allocations can be reused.
+    Plan.BloomViewports.Reset();
+
+    FScreenPassTextureViewport Viewport(Key.Extent, Key.ViewRect);
+
+    for (int32 i = 0; i < PassAmount; i++)
+    {
+        if (i > 0)
+        {
+            Viewport = GetTargetViewport(GetDownscaledViewport(Viewport, FIntPoint(2, 2)));
+        }
+
+        Plan.BloomViewports.Add(Viewport);
+    }
+
+    //--------------------------------
+    // Ghosts
+    //--------------------------------
+    // The visible ghosts are packed at the front of the settings buffer,
+    // only keep as many as the quality preset allows.
+    Plan.GhostCount = 0;
+
+    if (Parameters.GhostIntensity > SMALL_NUMBER)
+    {
+        Plan.GhostCount = FMath::Min(Settings.GetGhostCount(), Key.Preset.GhostCount);
+    }
 
     //--------------------------------
-    // Setup delegate
+    // Stages
     //--------------------------------
-    FPP_CustomBloomFlare::FDelegate Delegate = FPP_CustomBloomFlare::FDelegate::CreateLambda(
-        [=, this](FRDGBuilder& GraphBuilder, const FViewInfo& View, const FScreenPassTexture& SceneColor, FScreenPassTexture& Output)
-        {
-            Render(GraphBuilder, View, SceneColor, Output);
-        });
+    // Flare and glare are both scaled by the flare intensity and tint in the mix
+    const bool bFlareVisible = Parameters.FlareIntensity > SMALL_NUMBER && !Parameters.FlareTint.IsNearlyZero3();
 
-    ENQUEUE_RENDER_COMMAND(BindRenderThreadDelegates)([Delegate](FRHICommandListImmediate& RHICmdList)
-        {
-            PP_CustomBloomFlare.Add(Delegate);
-        });
+    const bool bGlareVisible = Parameters.GlareIntensity > SMALL_NUMBER
+        && Parameters.GlareTint.W > SMALL_NUMBER
+        && FMath::Max3(Parameters.GlareScales.X, Parameters.GlareScales.Y, Parameters.GlareScales.Z) > 0.0001f;
+
+    Plan.bRenderFlare = Key.bRenderFlare
+        && Key.Quality >= EPostProcessViewQuality::Reduced
+        && bFlareVisible
+        && Plan.GhostCount > 0
+        && Key.Preset.FlareMip < PassAmount;
+
+    Plan.bRenderStarburst = Plan.bRenderFlare && Parameters.StarburstIntensity > SMALL_NUMBER;
+
+    // The halo is mixed into the second upsample
+    Plan.bRenderHalo = Key.bRenderHalo
+        && Key.Quality == EPostProcessViewQuality::Full
+        && Parameters.HaloIntensity > SMALL_NUMBER
+        && PassAmount > 2;
+
+    Plan.bRenderGlare = Key.bRenderGlare
+        && Key.Quality == EPostProcessViewQuality::Full
+        && bFlareVisible
+        && bGlareVisible
+        && Key.Preset.FlareMip + 1 < PassAmount;
 
     //--------------------------------
-    // Data asset loading
-    // NOTE: Ideally this would be something that Developer Setting would set,
-	//		 however, it crashes everytime you adjust the values. This is not
-	//		 ideal, but works.
+    // Permutations
+    //--------------------------------
+    // Features that have no effect with the current settings are
+    // compiled out (unless their permutation was pruned in the ini).
+    Plan.GhostPermutation = GetGhostCountPermutation(Plan.GhostCount);
+    Plan.bGhostChromaShift = GetFeaturePermutation(Parameters.GhostChromaShift != 0.0f);
+    Plan.bHaloChromaShift = GetFeaturePermutation(Parameters.HaloChromaShift != 0.0f);
+    Plan.bStarburstTexture = GetFeaturePermutation(Settings.HasStarburstNoise());
+
+    //--------------------------------
+    // Flare blur
     //--------------------------------
-    FString Path = "PostProcessDataAsset'/PrettyPostProcess/DA_PostProcess_Default.DA_PostProcess_Default'";
-    
-    PostProcessDataAsset = LoadObject<UPostProcessDataAsset>(nullptr, *Path);
+    Plan.BlurSteps = 0;
+    Plan.BlurViewports.Reset();
+
+    if (Plan.bRenderFlare)
+    {
+        Plan.BlurSteps = FMath::Min(
+            Settings.GetBlurSteps(),
+            Key.Quality == EPostProcessViewQuality::Reduced ? 1 : Key.Preset.BlurSteps
+        );
+
+        // The blur reads the ghosts target, laid out like the flare
+        // level but from the origin. Extents are derived from the input
+        // extent, not its rect, so they stay the same when the view
+        // rect changes.
+        const FScreenPassTextureViewport InputViewport = GetTargetViewport(Plan.BloomViewports[Key.Preset.FlareMip]);
+
+        int32 Divider = 2;
+
+        for (int32 i = 0; i < Plan.BlurSteps * 2; i++)
+        {
+            Plan.BlurViewports.Add(GetTargetViewport(GetDownscaledViewport(InputViewport, FIntPoint(Divider, Divider))));
+
+            if (i < (Plan.BlurSteps - 1))
+            {
+                Divider *= 2;
+            }
+            else
+            {
+                Divider /= 2;
+            }
+        }
+    }
 }
 
-void UPostProcessSubsystem::Deinitialize()
+void UPostProcessSubsystem::DescribePassPlan(
+    const FPostProcessRenderContext& Context,
+    FPostProcessStructure& Structure
+)
 {
-    ClearBlendState = nullptr;
-    AdditiveBlendState = nullptr;
-    BilinearClampSampler = nullptr;
-    BilinearBorderSampler = nullptr;
-    BilinearRepeatSampler = nullptr;
-    NearestRepeatSampler = nullptr;
-}
+    // Follows Render() for a view that is not a tile: same passes, in the
+    // same order, with the same textures. Buffers and the passes added by
+    // engine helpers (UAV clears, readbacks) are left out, like in the
+    // footprint. The scene color is external (INDEX_NONE).
+    const FPostProcessPassPlan& Plan = Context.Plan;
+    const FPostProcessQualityPreset& Preset = Context.Preset;
 
+    const EPixelFormat Format = GetIntermediateFormat(Context);
+    const EPixelFormat FlareFormat = Context.bAsyncCompute ? GetComputeFormat(Context) : Format;
 
-void UPostProcessSubsystem::InitStates()
-{
-    if (ClearBlendState != nullptr)
+    //--------------------------------
+    // Bloom downsample
+    //--------------------------------
+    // One texture per level, Levels[0] being the scene color
+    TArray<int32, TInlineAllocator<8>> Levels;
+    int32 TileMax = INDEX_NONE;
+
+    if (Plan.PassAmount > 1)
     {
-        return;
+        int32 Divider = 2;
+
+        for (int32 i = 0; i < Plan.PassAmount; i++)
+        {
+            const FScreenPassTextureViewport& Viewport = Plan.BloomViewports[i];
+            int32 Texture = INDEX_NONE;
+
+            if (i > 0)
+            {
+                Texture = Structure.CreateTexture(TEXT("Downsample"), Viewport.Extent, Format);
+
+                Structure.AddPass(
+                    FString::Printf(TEXT("Downsample_%d_(1/%d)_%dx%d"), i, Divider, Viewport.Rect.Width(), Viewport.Rect.Height()),
+                    { Levels.Last(), Texture }
+                );
+            }
+
+            if (i == Preset.FlareMip && Context.bTileMax)
+            {
+                const FIntPoint Extent = FIntPoint::DivideAndRoundUp(Viewport.Extent, FTileMaxCS::TileSize);
+                TileMax = Structure.CreateTexture(TEXT("TileMax"), Extent, PF_R32_UINT);
+
+                Structure.AddPass(FString::Printf(TEXT("TileMax_%dx%d"), Extent.X, Extent.Y), { Texture, TileMax });
+            }
+
+            Levels.Add(Texture);
+            Divider *= 2;
+        }
     }
 
-    // Blend modes from:
-    // '/Engine/Source/Runtime/RenderCore/Private/ClearQuad.cpp'
-    // '/Engine/Source/Runtime/Renderer/Private/PostProcess/PostProcessMaterial.cpp'
-    ClearBlendState = TStaticBlendState<>::GetRHI();
-    AdditiveBlendState = TStaticBlendState<CW_RGB, BO_Add, BF_One, BF_One>::GetRHI();
+    //--------------------------------
+    // Flare
+    //--------------------------------
+    int32 Flare = INDEX_NONE;
 
-    BilinearClampSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
-    BilinearBorderSampler = TStaticSamplerState<SF_Bilinear, AM_Border, AM_Border, AM_Border>::GetRHI();
-    BilinearRepeatSampler = TStaticSamplerState<SF_Bilinear, AM_Wrap, AM_Wrap, AM_Wrap>::GetRHI();
-    NearestRepeatSampler = TStaticSamplerState<SF_Point, AM_Wrap, AM_Wrap, AM_Wrap>::GetRHI();
-}
+    if (Plan.bRenderFlare && Levels.IsValidIndex(Preset.FlareMip))
+    {
+        FIntPoint Extent = Plan.BloomViewports[Preset.FlareMip].Extent;
 
-// The function that draw a shader into a given RenderGraph texture
-template<typename TShaderParameters, typename TShaderClassVertex, typename TShaderClassPixel>
-inline void DrawShaderPass(
-    FRDGBuilder& GraphBuilder,
-    const FString& PassName,
-    TShaderParameters* PassParameters,
-    TShaderMapRef<TShaderClassVertex> VertexShader,
-    TShaderMapRef<TShaderClassPixel> PixelShader,
-    FRHIBlendState* BlendState,
-    const FIntRect& Viewport
-)
-{
-    const FScreenPassPipelineState PipelineState(VertexShader, PixelShader, BlendState);
+        Flare = Structure.CreateTexture(TEXT("FlareGhosts"), Extent, FlareFormat);
+        Structure.AddPass(TEXT("FlareGhosts"), { Levels[Preset.FlareMip], TileMax, Flare });
 
-    GraphBuilder.AddPass(
-        FRDGEventName(TEXT("%s"), *PassName),
-        PassParameters,
-        ERDGPassFlags::Raster,
-        [PixelShader, PassParameters, Viewport, PipelineState](FRHICommandListImmediate& RHICmdList)
+        for (int32 i = 0; i < Plan.BlurViewports.Num(); i++)
         {
-            RHICmdList.SetViewport(
-                Viewport.Min.X, Viewport.Min.Y, 0.0f,
-                Viewport.Max.X, Viewport.Max.Y, 1.0f
+            const FScreenPassTextureViewport& Viewport = Plan.BlurViewports[i];
+            const int32 Texture = Structure.CreateTexture(TEXT("KawaseBlur"), Viewport.Extent, FlareFormat);
+
+            Structure.AddPass(
+                FString::Printf(TEXT("KawaseBlur_%d_%s_%dx%d"), i, i < Plan.BlurSteps ? TEXT("Down") : TEXT("Up"), Viewport.Rect.Width(), Viewport.Rect.Height()),
+                { Flare, Texture }
             );
 
-            SetScreenPassPipelineState(RHICmdList, PipelineState);
+            Flare = Texture;
+            Extent = Viewport.Extent;
+        }
 
-            SetShaderParameters(
-                RHICmdList,
-                PixelShader,
-                PixelShader.GetPixelShader(),
-                *PassParameters
-            );
+        if (Plan.bRenderStarburst)
+        {
+            const int32 Texture = Structure.CreateTexture(TEXT("FlareStarburst"), Extent, FlareFormat);
+            Structure.AddPass(TEXT("FlareStarburst"), { Flare, Texture });
 
-            UE::Renderer::PostProcess::DrawRectangle(
-                RHICmdList,                             // FRHICommandList
-                PipelineState.VertexShader,             // const TShaderRefBase VertexShader
-                0.0f, 0.0f,                             // float X, float Y
-                Viewport.Width(), Viewport.Height(),    // float SizeX, float SizeY
-                Viewport.Min.X, Viewport.Min.Y,         // float U, float V
-                Viewport.Width(),                       // float SizeU
-                Viewport.Height(),                      // float SizeV
-                Viewport.Size(),                        // FIntPoint TargetSize
-                Viewport.Size(),                        // FIntPoint TextureSize
-                EDrawRectangleFlags::EDRF_Default       // EDrawRectangleFlags Flags
-            );
+            Flare = Texture;
+        }
+    }
 
-        });
-}
+    //--------------------------------
+    // Glare
+    //--------------------------------
+    int32 Glare = INDEX_NONE;
 
-FVector2f GetInputViewportSize(const FIntRect& Input, const FIntPoint& Extent)
-{
-    // Based on GetScreenPassTextureViewportParameters()
-    // Engine/Source/Runtime/Renderer/Private/ScreenPass.cpp
+    if (Plan.bRenderGlare && Levels.IsValidIndex(Preset.FlareMip + 1))
+    {
+        const int32 Input = Levels[Preset.FlareMip + 1];
+
+        Glare = Structure.CreateTexture(TEXT("GlareRenderPass"), Plan.BloomViewports[Preset.FlareMip + 1].Extent, Format);
+
+        if (Context.bAsyncCompute)
+        {
+            Structure.AddPass(TEXT("GlareRenderPassSetup"), { Input, TileMax });
+            Structure.AddPass(TEXT("GlareRenderPass"), { Glare });
+        }
+        else
+        {
+            Structure.AddPass(TEXT("GlareRenderPass"), { Input, TileMax, Glare });
+        }
+    }
+
+    //--------------------------------
+    // Bloom upsample
+    //--------------------------------
+    int32 Bloom = INDEX_NONE;
+
+    if (Plan.PassAmount > 1)
+    {
+        TArray<int32, TInlineAllocator<8>> Upsample = Levels;
+
+        for (int32 i = Plan.PassAmount - 2; i >= 0; i--)
+        {
+            const FScreenPassTextureViewport& Viewport = Plan.BloomViewports[i];
+
+            if (i == 1 && Plan.bRenderHalo)
+            {
+                const int32 Halo = Structure.CreateTexture(TEXT("HaloPass"), Viewport.Extent, Format);
+                Structure.AddPass(TEXT("HaloPass"), { Upsample[i], TileMax, Halo });
 
-    FVector2f ExtentInverse = FVector2f(1.0f / Extent.X, 1.0f / Extent.Y);
+                Upsample[i] = Halo;
+            }
 
-    FVector2f RectMin = FVector2f(Input.Min);
-    FVector2f RectMax = FVector2f(Input.Max);
+            const int32 Texture = Structure.CreateTexture(TEXT("UpsampleCombine"), Viewport.Extent, Format);
 
-    FVector2f Min = RectMin * ExtentInverse;
-    FVector2f Max = RectMax * ExtentInverse;
+            Structure.AddPass(
+                FString::Printf(TEXT("UpsampleCombine_%d_%dx%d"), i, Viewport.Rect.Width(), Viewport.Rect.Height()),
+                { Upsample[i], Upsample[i + 1], Texture }
+            );
+
+            Upsample[i] = Texture;
+        }
+
+        Bloom = Upsample[0];
+    }
 
-    return (Max - Min);
+    //--------------------------------
+    // Mix
+    //--------------------------------
+    const int32 Mix = Structure.CreateTexture(TEXT("Mix"), Plan.Key.Extent, Format);
+    Structure.AddPass(TEXT("Mix"), { Bloom, Flare, Glare, Mix });
 }
 
 //----------------------------------------------------------
@@ -530,19 +2305,24 @@ FVector2f GetInputViewportSize(const FIntRect& Input, const FIntPoint& Extent)
 
 FRDGTextureRef UPostProcessSubsystem::RenderDownsample(
     FRDGBuilder& GraphBuilder,
-    const FString& PassName,
+    const FPostProcessRenderContext& Context,
+    FRDGEventName&& PassName,
     const FViewInfo& View,
-    FRDGTextureRef InputTexture,
-    const FIntRect& Viewport
+    const FScreenPassTexture& InputTexture,
+    const FScreenPassTextureViewport& OutputViewport
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderDownsample);
+
+    const FIntRect& Viewport = OutputViewport.Rect;
+
     // Build texture
-    FRDGTextureDesc Description = InputTexture->Desc;
+    FRDGTextureDesc Description = InputTexture.Texture->Desc;
     Description.Reset();
-    Description.Extent = Viewport.Size();
-    Description.Format = PF_FloatRGB;
+    Description.Extent = OutputViewport.Extent;
+    Description.Format = GetIntermediateFormat(Context);
     Description.ClearValue = FClearValueBinding(FLinearColor::Black);
-    FRDGTextureRef TargetTexture = GraphBuilder.CreateTexture(Description, *PassName);
+    FRDGTextureRef TargetTexture = CreatePassTexture(GraphBuilder, Context, Description, TEXT("Downsample"));
 
     // Render shader
     TShaderMapRef<FCustomScreenPassVS> VertexShader(View.ShaderMap);
@@ -550,14 +2330,18 @@ FRDGTextureRef UPostProcessSubsystem::RenderDownsample(
 
     FDownsamplePS::FParameters* PassParameters = GraphBuilder.AllocParameters<FDownsamplePS::FParameters>();
 
-    PassParameters->Pass.InputTexture = InputTexture;
+    PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+
+    PassParameters->Pass.InputTexture = InputTexture.Texture;
+    PassParameters->Pass.Input = GetTextureViewportParameters(InputTexture);
     PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(TargetTexture, ERenderTargetLoadAction::ENoAction);
     PassParameters->InputSampler = BilinearBorderSampler;
     PassParameters->InputSize = FVector2f(Viewport.Size());
 
     DrawShaderPass(
         GraphBuilder,
-        PassName,
+        Context,
+        MoveTemp(PassName),
         PassParameters,
         VertexShader,
         PixelShader,
@@ -570,38 +2354,135 @@ FRDGTextureRef UPostProcessSubsystem::RenderDownsample(
 
 
 
+void UPostProcessSubsystem::RenderTileMax(
+    FRDGBuilder& GraphBuilder,
+    FPostProcessRenderContext& Context,
+    const FViewInfo& View,
+    const FScreenPassTexture& InputTexture
+)
+{
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderTileMax);
+
+    // Sized from the extent so that the allocation doesn't follow the view rect
+    const int32 TileSize = FTileMaxCS::TileSize;
+    const FIntPoint Extent = FIntPoint::DivideAndRoundUp(InputTexture.Texture->Desc.Extent, TileSize);
+
+    const FRDGTextureDesc Description = FRDGTextureDesc::Create2D(
+        Extent,
+        PF_R32_UINT,
+        FClearValueBinding::None,
+        TexCreate_ShaderResource | TexCreate_UAV
+    );
+
+    FRDGTextureRef TileMaxTexture = CreatePassTexture(GraphBuilder, Context, Description, TEXT("TileMax"));
+
+    TShaderMapRef<FTileMaxCS> ComputeShader(View.ShaderMap);
+
+    FTileMaxCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FTileMaxCS::FParameters>();
+    PassParameters->InputTexture = InputTexture.Texture;
+    PassParameters->Input = GetTextureViewportParameters(InputTexture);
+    PassParameters->RWTileMaxTexture = GraphBuilder.CreateUAV(TileMaxTexture);
+
+    // One group per tile, on the queue of the passes reading it
+    DispatchShaderPass(
+        GraphBuilder,
+        Context,
+        RDG_EVENT_NAME("TileMax_%dx%d", Extent.X, Extent.Y),
+        PassParameters,
+        ComputeShader,
+        InputTexture.ViewRect,
+        Context.bAsyncCompute ? ERDGPassFlags::AsyncCompute : ERDGPassFlags::Compute
+    );
+
+    Context.TileMaxTexture = TileMaxTexture;
+    Context.TileMaxScale = FVector2f(InputTexture.ViewRect.Size()) / float(TileSize);
+}
+
+FRDGTextureRef UPostProcessSubsystem::RenderSignature(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    const FViewInfo& View,
+    const FScreenPassTexture& SceneColor
+)
+{
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderSignature);
+
+    const int32 SignatureSize = FPostProcessStaticCache::SignatureSize;
+
+    const FRDGTextureDesc Description = FRDGTextureDesc::Create2D(
+        FIntPoint(SignatureSize, SignatureSize),
+        PF_R32_FLOAT,
+        FClearValueBinding::None,
+        TexCreate_ShaderResource | TexCreate_UAV
+    );
+
+    FRDGTextureRef SignatureTexture = CreatePassTexture(GraphBuilder, Context, Description, TEXT("Signature"));
+
+    TShaderMapRef<FSignatureCS> ComputeShader(View.ShaderMap);
+
+    FSignatureCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSignatureCS::FParameters>();
+    PassParameters->InputTexture = SceneColor.Texture;
+    PassParameters->InputSampler = BilinearClampSampler;
+    PassParameters->Input = GetTextureViewportParameters(SceneColor);
+    PassParameters->RWSignatureTexture = GraphBuilder.CreateUAV(SignatureTexture);
+
+    // One group per cell, on the graphics queue as it is copied back right away
+    const int32 GroupSize = FCustomComputeShader::ThreadGroupSize;
+
+    DispatchShaderPass(
+        GraphBuilder,
+        Context,
+        RDG_EVENT_NAME("Signature_%dx%d", SignatureSize, SignatureSize),
+        PassParameters,
+        ComputeShader,
+        FIntRect(0, 0, SignatureSize * GroupSize, SignatureSize * GroupSize),
+        ERDGPassFlags::Compute
+    );
+
+    return SignatureTexture;
+}
+
 FRDGTextureRef UPostProcessSubsystem::RenderUpsampleCombine(
     FRDGBuilder& GraphBuilder,
-    const FString& PassName,
+    const FPostProcessRenderContext& Context,
+    FRDGEventName&& PassName,
     const FViewInfo& View,
     const FScreenPassTexture& InputTexture,
     const FScreenPassTexture& PreviousTexture,
-    float Radius
+    float Radius,
+    const FVector4f& PreviousUVRect
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderUpsampleCombine);
+
     // Build texture
     FRDGTextureDesc Description = InputTexture.Texture->Desc;
     Description.Reset();
-    Description.Extent = InputTexture.ViewRect.Size();
-    Description.Format = PF_FloatRGB;
+    Description.Format = GetIntermediateFormat(Context);
     Description.ClearValue = FClearValueBinding(FLinearColor::Black);
-    FRDGTextureRef TargetTexture = GraphBuilder.CreateTexture(Description, *PassName);
+    FRDGTextureRef TargetTexture = CreatePassTexture(GraphBuilder, Context, Description, TEXT("UpsampleCombine"));
 
     TShaderMapRef<FCustomScreenPassVS> VertexShader(View.ShaderMap);
     TShaderMapRef<FUpsampleCombinePS> PixelShader(View.ShaderMap);
 
     FUpsampleCombinePS::FParameters* PassParameters = GraphBuilder.AllocParameters<FUpsampleCombinePS::FParameters>();
 
+    PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+
     PassParameters->Pass.InputTexture = InputTexture.Texture;
+    PassParameters->Pass.Input = GetTextureViewportParameters(InputTexture);
     PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(TargetTexture, ERenderTargetLoadAction::ENoAction);
     PassParameters->InputSampler = BilinearClampSampler;
-    PassParameters->InputSize = FVector2f(PreviousTexture.ViewRect.Size());
+    PassParameters->InputSize = FVector2f(PreviousTexture.ViewRect.Size())
+        * FVector2f(PreviousUVRect.Z - PreviousUVRect.X, PreviousUVRect.W - PreviousUVRect.Y);
     PassParameters->PreviousTexture = PreviousTexture.Texture;
+    PassParameters->Previous = GetTextureViewportParameters(PreviousTexture, PreviousUVRect);
     PassParameters->Radius = Radius;
 
     DrawShaderPass(
         GraphBuilder,
-        PassName,
+        Context,
+        MoveTemp(PassName),
         PassParameters,
         VertexShader,
         PixelShader,
@@ -616,188 +2497,223 @@ FRDGTextureRef UPostProcessSubsystem::RenderUpsampleCombine(
 // Render functions - Flare
 //----------------------------------------------------------
 
-FRDGTextureRef UPostProcessSubsystem::RenderBlur(
+FScreenPassTexture UPostProcessSubsystem::RenderBlur(
     FRDGBuilder& GraphBuilder,
-    FRDGTextureRef InputTexture,
-    const FViewInfo& View,
-    const FIntRect& Viewport,
-    int BlurSteps
+    const FPostProcessRenderContext& Context,
+    const FScreenPassTexture& InputTexture,
+    const FViewInfo& View
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderBlur);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessBlur);
+
     // Shader setup
     TShaderMapRef<FCustomScreenPassVS>  VertexShader(View.ShaderMap);
     TShaderMapRef<FKawaseBlurDownPS>    PixelShaderDown(View.ShaderMap);
     TShaderMapRef<FKawaseBlurUpPS>      PixelShaderUp(View.ShaderMap);
 
     // Data setup
-    FRDGTextureRef PreviousBuffer = InputTexture;
-    const FRDGTextureDesc& InputDescription = InputTexture->Desc;
+    FScreenPassTexture PreviousBuffer = InputTexture;
+    const FRDGTextureDesc& InputDescription = InputTexture.Texture->Desc;
 
-    const FString PassDownName = TEXT("Down");
-    const FString PassUpName = TEXT("Up");
-    const int32 ArraySize = BlurSteps * 2;
+    // Viewport resolutions come from the pass plan
+    const int32 BlurSteps = Context.Plan.BlurSteps;
+    const TArrayView<const FScreenPassTextureViewport> Viewports = Context.Plan.BlurViewports;
 
-    // Viewport resolutions
-    int32 Divider = 2;
-    TArray<FIntRect> Viewports;
-    for (int32 i = 0; i < ArraySize; i++)
-    {
-        FIntRect NewRect = FIntRect(
-            0,
-            0,
-            Viewport.Width() / Divider,
-            Viewport.Height() / Divider
+    // Render
+    for (int32 i = 0; i < Viewports.Num(); i++)
+    {
+        const FIntRect& Viewport = Viewports[i].Rect;
+
+        FVector2f ViewportResolution = FVector2f(
+            Viewport.Width(),
+            Viewport.Height()
         );
 
-        Viewports.Add(NewRect);
+        const TCHAR* PassDirection = (i < BlurSteps) ? TEXT("Down") : TEXT("Up");
 
-        if (i < (BlurSteps - 1))
-        {
-            Divider *= 2;
-        }
-        else
+        FKawaseBlurParameters BlurParameters;
+        BlurParameters.InputSampler = BilinearClampSampler;
+        BlurParameters.BufferSize = ViewportResolution;
+
+        FRDGTextureRef Buffer = nullptr;
+
+        if (Context.bAsyncCompute)
         {
-            Divider /= 2;
+            Buffer = CreateComputeTexture(GraphBuilder, Context, TEXT("KawaseBlur"), Viewports[i].Extent);
+
+            if (i < BlurSteps)
+            {
+                TShaderMapRef<FKawaseBlurDownCS> ComputeShader(View.ShaderMap);
+                FKawaseBlurDownCS::FParameters* PassDownParameters = GraphBuilder.AllocParameters<FKawaseBlurDownCS::FParameters>();
+                PassDownParameters->Compute = GetComputeParameters(GraphBuilder, Context, PreviousBuffer, Buffer, Viewport);
+                PassDownParameters->Blur = BlurParameters;
+
+                DispatchShaderPass(
+                    GraphBuilder,
+                    Context,
+                    RDG_EVENT_NAME("KawaseBlur_%d_%s_%dx%d", i, PassDirection, Viewport.Width(), Viewport.Height()),
+                    PassDownParameters,
+                    ComputeShader,
+                    Viewport
+                );
+            }
+            else
+            {
+                TShaderMapRef<FKawaseBlurUpCS> ComputeShader(View.ShaderMap);
+                FKawaseBlurUpCS::FParameters* PassUpParameters = GraphBuilder.AllocParameters<FKawaseBlurUpCS::FParameters>();
+                PassUpParameters->Compute = GetComputeParameters(GraphBuilder, Context, PreviousBuffer, Buffer, Viewport);
+                PassUpParameters->Blur = BlurParameters;
+
+                DispatchShaderPass(
+                    GraphBuilder,
+                    Context,
+                    RDG_EVENT_NAME("KawaseBlur_%d_%s_%dx%d", i, PassDirection, Viewport.Width(), Viewport.Height()),
+                    PassUpParameters,
+                    ComputeShader,
+                    Viewport
+                );
+            }
+
+            PreviousBuffer = FScreenPassTexture(Buffer, Viewport);
+            continue;
         }
-    }
 
-    // Render
-    for (int32 i = 0; i < ArraySize; i++)
-    {
         // Build texture
         FRDGTextureDesc BlurDesc = InputDescription;
         BlurDesc.Reset();
-        BlurDesc.Extent = Viewports[i].Size();
-        BlurDesc.Format = PF_FloatRGB;
+        BlurDesc.Extent = Viewports[i].Extent;
+        BlurDesc.Format = GetIntermediateFormat(Context);
         BlurDesc.NumMips = 1;
         BlurDesc.ClearValue = FClearValueBinding(FLinearColor::Transparent);
 
-        FVector2f ViewportResolution = FVector2f(
-            Viewports[i].Width(),
-            Viewports[i].Height()
-        );
-
-        const FString PassName =
-            FString("KawaseBlur")
-            + FString::Printf(TEXT("_%i_"), i)
-            + ((i < BlurSteps) ? PassDownName : PassUpName)
-            + FString::Printf(TEXT("_%ix%i"), Viewports[i].Width(), Viewports[i].Height());
-
-        FRDGTextureRef Buffer = GraphBuilder.CreateTexture(BlurDesc, *PassName);
+        Buffer = CreatePassTexture(GraphBuilder, Context, BlurDesc, TEXT("KawaseBlur"));
 
         // Render shader
         if (i < BlurSteps)
         {
             FKawaseBlurDownPS::FParameters* PassDownParameters = GraphBuilder.AllocParameters<FKawaseBlurDownPS::FParameters>();
-            PassDownParameters->Pass.InputTexture = PreviousBuffer;
+            PassDownParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+            PassDownParameters->Pass.InputTexture = PreviousBuffer.Texture;
+            PassDownParameters->Pass.Input = GetTextureViewportParameters(PreviousBuffer);
             PassDownParameters->Pass.RenderTargets[0] = FRenderTargetBinding(Buffer, ERenderTargetLoadAction::ENoAction);
-            PassDownParameters->InputSampler = BilinearClampSampler;
-            PassDownParameters->BufferSize = ViewportResolution;
+            PassDownParameters->Blur = BlurParameters;
 
             DrawShaderPass(
                 GraphBuilder,
-                PassName,
+                Context,
+                RDG_EVENT_NAME("KawaseBlur_%d_%s_%dx%d", i, PassDirection, Viewport.Width(), Viewport.Height()),
                 PassDownParameters,
                 VertexShader,
                 PixelShaderDown,
                 ClearBlendState,
-                Viewports[i]
+                Viewport
             );
         }
         else
         {
             FKawaseBlurUpPS::FParameters* PassUpParameters = GraphBuilder.AllocParameters<FKawaseBlurUpPS::FParameters>();
-            PassUpParameters->Pass.InputTexture = PreviousBuffer;
+            PassUpParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+            PassUpParameters->Pass.InputTexture = PreviousBuffer.Texture;
+            PassUpParameters->Pass.Input = GetTextureViewportParameters(PreviousBuffer);
             PassUpParameters->Pass.RenderTargets[0] = FRenderTargetBinding(Buffer, ERenderTargetLoadAction::ENoAction);
-            PassUpParameters->InputSampler = BilinearClampSampler;
-            PassUpParameters->BufferSize = ViewportResolution;
+            PassUpParameters->Blur = BlurParameters;
 
             DrawShaderPass(
                 GraphBuilder,
-                PassName,
+                Context,
+                RDG_EVENT_NAME("KawaseBlur_%d_%s_%dx%d", i, PassDirection, Viewport.Width(), Viewport.Height()),
                 PassUpParameters,
                 VertexShader,
                 PixelShaderUp,
                 ClearBlendState,
-                Viewports[i]
+                Viewport
             );
         }
 
-        PreviousBuffer = Buffer;
+        PreviousBuffer = FScreenPassTexture(Buffer, Viewport);
     }
 
     return PreviousBuffer;
 }
 
-FRDGTextureRef UPostProcessSubsystem::RenderGhosts(
+FScreenPassTexture UPostProcessSubsystem::RenderGhosts(
     FRDGBuilder& GraphBuilder,
-    const FString& PassName,
+    const FPostProcessRenderContext& Context,
+    const TCHAR* PassName,
     const FViewInfo& View,
-    FRDGTextureRef InputTexture,
-    const FIntRect& Viewport
+    const FScreenPassTexture& InputTexture
 )
 {
-    FRDGTextureRef TargetTexture = nullptr;
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderGhosts);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessGhosts);
+
+    if (Context.Counters != nullptr)
+    {
+        Context.Counters->Ghosts += Context.Plan.GhostCount;
+    }
+
+    // Same size as the input
+    const FIntRect Viewport(FIntPoint::ZeroValue, InputTexture.ViewRect.Size());
+    const FIntPoint& Extent = InputTexture.Texture->Desc.Extent;
+
+    FScreenPassTexture TargetTexture;
     FRDGTextureRef GhostsTexture = nullptr;
     {
         //----------------------------------------------------------
         // Ghosts
         //----------------------------------------------------------
 
+        // Shader parameters
+        FLensFlareGhostsParameters GhostsParameters;
+        // (ghost colors and scales are in the settings buffer)
+        GhostsParameters.InputSampler = BilinearBorderSampler;
+        GhostsParameters.TileMax = GetTileMaxParameters(Context);
+
+        // The ghost count and chroma shift are compiled in
+        FLensFlareGhostsPermutationDomain PermutationVector;
+        PermutationVector.Set<FGhostCountDim>(Context.Plan.GhostPermutation);
+        PermutationVector.Set<FChromaShiftDim>(Context.Plan.bGhostChromaShift);
+        PermutationVector.Set<FTileMaxDim>(Context.TileMaxTexture != nullptr);
+
+        if (Context.bAsyncCompute)
+        {
+            GhostsTexture = CreateComputeTexture(GraphBuilder, Context, PassName, Extent);
+
+            TShaderMapRef<FLensFlareGhostsCS> ComputeShader(View.ShaderMap, PermutationVector);
+
+            FLensFlareGhostsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FLensFlareGhostsCS::FParameters>();
+            PassParameters->Compute = GetComputeParameters(GraphBuilder, Context, InputTexture, GhostsTexture, Viewport);
+            PassParameters->Ghosts = GhostsParameters;
+
+            DispatchShaderPass(GraphBuilder, Context, RDG_EVENT_NAME("%s", PassName), PassParameters, ComputeShader, Viewport);
+
+            return FScreenPassTexture(GhostsTexture, Viewport);
+        }
+
         // Build buffer
-        FRDGTextureDesc Description = InputTexture->Desc;
+        FRDGTextureDesc Description = InputTexture.Texture->Desc;
         Description.Reset();
-        Description.Extent = Viewport.Size();
-        Description.Format = PF_FloatRGB;
+        Description.Extent = Extent;
+        Description.Format = GetIntermediateFormat(Context);
         Description.ClearValue = FClearValueBinding(FLinearColor::Transparent);
-        GhostsTexture = GraphBuilder.CreateTexture(Description, *PassName);
+        GhostsTexture = CreatePassTexture(GraphBuilder, Context, Description, PassName);
 
-        // Shader parameters
         TShaderMapRef<FCustomScreenPassVS> VertexShader(View.ShaderMap);
-        TShaderMapRef<FLensFlareGhostsPS> PixelShader(View.ShaderMap);
+        TShaderMapRef<FLensFlareGhostsPS> PixelShader(View.ShaderMap, PermutationVector);
 
         FLensFlareGhostsPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FLensFlareGhostsPS::FParameters>();
-        PassParameters->Pass.InputTexture = InputTexture;
+        PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+        PassParameters->Pass.InputTexture = InputTexture.Texture;
+        PassParameters->Pass.Input = GetTextureViewportParameters(InputTexture);
         PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(GhostsTexture, ERenderTargetLoadAction::ENoAction);
-        PassParameters->InputSampler = BilinearBorderSampler;
-        PassParameters->Intensity = PostProcessDataAsset->GhostIntensity;
-        PassParameters->ChromaShift = PostProcessDataAsset->GhostChromaShift;
-        PassParameters->Compression = PostProcessDataAsset->GhostCompression;
-		PassParameters->InputScreenSize = FVector2f(Viewport.Size());
-
-		// Starburst
-		PassParameters->StarburstTexture = GWhiteTexture->TextureRHI;
-		PassParameters->StarburstSampler = BilinearRepeatSampler;
-
-		if (PostProcessDataAsset->StarburstNoise != nullptr)
-		{
-			const FTextureRHIRef TextureRHI = PostProcessDataAsset->StarburstNoise->GetResource()->TextureRHI;
-			PassParameters->StarburstTexture = TextureRHI;
-		}
-
-        PassParameters->GhostColors[0] = PostProcessDataAsset->Ghost1.Color;
-        PassParameters->GhostColors[1] = PostProcessDataAsset->Ghost2.Color;
-        PassParameters->GhostColors[2] = PostProcessDataAsset->Ghost3.Color;
-        PassParameters->GhostColors[3] = PostProcessDataAsset->Ghost4.Color;
-        PassParameters->GhostColors[4] = PostProcessDataAsset->Ghost5.Color;
-        PassParameters->GhostColors[5] = PostProcessDataAsset->Ghost6.Color;
-        PassParameters->GhostColors[6] = PostProcessDataAsset->Ghost7.Color;
-        PassParameters->GhostColors[7] = PostProcessDataAsset->Ghost8.Color;
-
-		// temporary evil hack due to the float param being converted to FVector4f with SHADER_PARAMETER_SCALAR_ARRAY in 5.1
-        PassParameters->GhostScales[0].X = PostProcessDataAsset->Ghost1.Scale;
-        PassParameters->GhostScales[1].X = PostProcessDataAsset->Ghost2.Scale;
-        PassParameters->GhostScales[2].X = PostProcessDataAsset->Ghost3.Scale;
-        PassParameters->GhostScales[3].X = PostProcessDataAsset->Ghost4.Scale;
-        PassParameters->GhostScales[4].X = PostProcessDataAsset->Ghost5.Scale;
-        PassParameters->GhostScales[5].X = PostProcessDataAsset->Ghost6.Scale;
-        PassParameters->GhostScales[6].X = PostProcessDataAsset->Ghost7.Scale;
-        PassParameters->GhostScales[7].X = PostProcessDataAsset->Ghost8.Scale;
+        PassParameters->Ghosts = GhostsParameters;
 
         // Render
         DrawShaderPass(
             GraphBuilder,
-            PassName,
+            Context,
+            RDG_EVENT_NAME("%s", PassName),
             PassParameters,
             VertexShader,
             PixelShader,
@@ -805,52 +2721,73 @@ FRDGTextureRef UPostProcessSubsystem::RenderGhosts(
             Viewport
         );
 
-        TargetTexture = GhostsTexture;
+        TargetTexture = FScreenPassTexture(GhostsTexture, Viewport);
     }
 
     return TargetTexture;
 }
 
-FRDGTextureRef UPostProcessSubsystem::RenderStarburst(
+FScreenPassTexture UPostProcessSubsystem::RenderStarburst(
     FRDGBuilder& GraphBuilder,
-    const FString& PassName,
-    FRDGTextureRef InputTexture,
-    const FViewInfo& View,
-    const FIntRect& Viewport
+    const FPostProcessRenderContext& Context,
+    const TCHAR* PassName,
+    const FScreenPassTexture& InputTexture,
+    const FViewInfo& View
 )
 {
-    // Shader setup
-    TShaderMapRef<FCustomScreenPassVS>      VertexShader(View.ShaderMap);
-    TShaderMapRef<FLensFlareStarburstPS>    PixelShader(View.ShaderMap);
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderStarburst);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessStarburst);
 
     // Data setup
-    FRDGTextureRef TargetTexture = nullptr;
-    FRDGTextureRef PreviousBuffer = InputTexture;
-    const FRDGTextureDesc& InputDescription = InputTexture->Desc;
-    FRDGTextureRef Buffer = GraphBuilder.CreateTexture(InputDescription, *PassName);
+    const FIntRect Viewport(FIntPoint::ZeroValue, InputTexture.ViewRect.Size());
+    FScreenPassTexture TargetTexture;
+    FScreenPassTexture PreviousBuffer = InputTexture;
 
-    FLensFlareStarburstPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FLensFlareStarburstPS::FParameters>();
-    PassParameters->Pass.InputTexture = PreviousBuffer;
-    PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(Buffer, ERenderTargetLoadAction::ENoAction);
-    PassParameters->InputSampler = BilinearBorderSampler;
-    PassParameters->InputScreenSize = FVector2f(Viewport.Size());
+    FLensFlareStarburstParameters StarburstParameters;
+    StarburstParameters.InputSampler = BilinearBorderSampler;
+    StarburstParameters.InputScreenSize = FVector2f(Viewport.Size());
 
     // Starburst
-    PassParameters->StarburstTexture = GWhiteTexture->TextureRHI;
-    PassParameters->StarburstSampler = BilinearRepeatSampler;
-    PassParameters->StarburstIntensity = PostProcessDataAsset->StarburstIntensity;
-    PassParameters->StarburstOffset = PostProcessDataAsset->StarburstOffset;
+    StarburstParameters.StarburstTexture = Context.Settings->GetStarburstNoise();
+    StarburstParameters.StarburstSampler = BilinearRepeatSampler;
+
+    FLensFlareStarburstPermutationDomain PermutationVector;
+    PermutationVector.Set<FStarburstTextureDim>(Context.Plan.bStarburstTexture);
 
-    if (PostProcessDataAsset->StarburstNoise != nullptr)
+    if (Context.bAsyncCompute)
     {
-        const FTextureRHIRef TextureRHI = PostProcessDataAsset->StarburstNoise->GetResource()->TextureRHI;
-        PassParameters->StarburstTexture = TextureRHI;
+        FRDGTextureRef Buffer = CreateComputeTexture(GraphBuilder, Context, PassName, InputTexture.Texture->Desc.Extent);
+
+        TShaderMapRef<FLensFlareStarburstCS> ComputeShader(View.ShaderMap, PermutationVector);
+
+        FLensFlareStarburstCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FLensFlareStarburstCS::FParameters>();
+        PassParameters->Compute = GetComputeParameters(GraphBuilder, Context, PreviousBuffer, Buffer, Viewport);
+        PassParameters->Starburst = StarburstParameters;
+
+        DispatchShaderPass(GraphBuilder, Context, RDG_EVENT_NAME("%s", PassName), PassParameters, ComputeShader, Viewport);
+
+        return FScreenPassTexture(Buffer, Viewport);
     }
 
+    // Shader setup
+    TShaderMapRef<FCustomScreenPassVS>      VertexShader(View.ShaderMap);
+    TShaderMapRef<FLensFlareStarburstPS>    PixelShader(View.ShaderMap, PermutationVector);
+
+    const FRDGTextureDesc& InputDescription = InputTexture.Texture->Desc;
+    FRDGTextureRef Buffer = CreatePassTexture(GraphBuilder, Context, InputDescription, PassName);
+
+    FLensFlareStarburstPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FLensFlareStarburstPS::FParameters>();
+    PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+    PassParameters->Pass.InputTexture = PreviousBuffer.Texture;
+    PassParameters->Pass.Input = GetTextureViewportParameters(PreviousBuffer);
+    PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(Buffer, ERenderTargetLoadAction::ENoAction);
+    PassParameters->Starburst = StarburstParameters;
+
     // Render
     DrawShaderPass(
         GraphBuilder,
-        PassName,
+        Context,
+        RDG_EVENT_NAME("%s", PassName),
         PassParameters,
         VertexShader,
         PixelShader,
@@ -858,55 +2795,57 @@ FRDGTextureRef UPostProcessSubsystem::RenderStarburst(
         Viewport
     );
 
-    TargetTexture = Buffer;
+    TargetTexture = FScreenPassTexture(Buffer, Viewport);
 
     return TargetTexture;
 }
 
 FRDGTextureRef UPostProcessSubsystem::RenderHalo(
     FRDGBuilder& GraphBuilder,
-    const FString& PassName,
+    const FPostProcessRenderContext& Context,
+    const TCHAR* PassName,
     const FViewInfo& View,
     const FScreenPassTexture& InputTexture
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderHalo);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessHalo);
+
     // Build buffer
     FRDGTextureDesc Description = InputTexture.Texture->Desc;
     Description.Reset();
-    Description.Extent = InputTexture.ViewRect.Size();
-    Description.Format = PF_FloatRGB;
+    Description.Format = GetIntermediateFormat(Context);
     Description.ClearValue = FClearValueBinding(FLinearColor::Black);
-    FRDGTextureRef TargetTexture = GraphBuilder.CreateTexture(Description, *PassName);
+    FRDGTextureRef TargetTexture = CreatePassTexture(GraphBuilder, Context, Description, PassName);
 
     // Shader parameters
+    FLensFlareHaloPS::FPermutationDomain PermutationVector;
+    PermutationVector.Set<FChromaShiftDim>(Context.Plan.bHaloChromaShift);
+    PermutationVector.Set<FStarburstTextureDim>(Context.Plan.bStarburstTexture);
+    PermutationVector.Set<FTileMaxDim>(Context.TileMaxTexture != nullptr);
+
     TShaderMapRef<FCustomScreenPassVS> VertexShader(View.ShaderMap);
-    TShaderMapRef<FLensFlareHaloPS> PixelShader(View.ShaderMap);
+    TShaderMapRef<FLensFlareHaloPS> PixelShader(View.ShaderMap, PermutationVector);
 
     FLensFlareHaloPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FLensFlareHaloPS::FParameters>();
+    PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
     PassParameters->Pass.InputTexture = InputTexture.Texture;
+    PassParameters->Pass.Input = GetTextureViewportParameters(InputTexture);
     PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(TargetTexture, ERenderTargetLoadAction::ENoAction);
     PassParameters->InputSampler = BilinearBorderSampler;
-    PassParameters->Intensity = PostProcessDataAsset->HaloIntensity;
-    PassParameters->Width = PostProcessDataAsset->HaloWidth;
-    PassParameters->Mask = PostProcessDataAsset->HaloMask;
-    PassParameters->Compression = PostProcessDataAsset->HaloCompression;
-    PassParameters->ChromaShift = PostProcessDataAsset->HaloChromaShift;
 	PassParameters->InputScreenSize = FVector2f(InputTexture.ViewRect.Size());
 
 	// Starburst
-	PassParameters->StarburstTexture = GWhiteTexture->TextureRHI;
+	PassParameters->StarburstTexture = Context.Settings->GetStarburstNoise();
 	PassParameters->StarburstSampler = BilinearRepeatSampler;
 
-	if (PostProcessDataAsset->StarburstNoise != nullptr)
-	{
-		const FTextureRHIRef TextureRHI = PostProcessDataAsset->StarburstNoise->GetResource()->TextureRHI;
-		PassParameters->StarburstTexture = TextureRHI;
-	}
+    PassParameters->TileMax = GetTileMaxParameters(Context);
 
     // Render
     DrawShaderPass(
         GraphBuilder,
-        PassName,
+        Context,
+        RDG_EVENT_NAME("%s", PassName),
         PassParameters,
         VertexShader,
         PixelShader,
@@ -923,27 +2862,40 @@ FRDGTextureRef UPostProcessSubsystem::RenderHalo(
 // Render functions - Glare
 //----------------------------------------------------------
 
-FRDGTextureRef UPostProcessSubsystem::RenderGlare(
+FScreenPassTexture UPostProcessSubsystem::RenderGlare(
     FRDGBuilder& GraphBuilder,
-    const FString& PassName,
+    const FPostProcessRenderContext& Context,
+    const TCHAR* PassName,
     const FViewInfo& View,
-    FRDGTextureRef InputTexture,
-    const FIntRect& Viewport
+    const FScreenPassTexture& InputTexture
 )
 {
-    FRDGTextureRef TargetTexture = nullptr;
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderGlare);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessGlare);
+
+    // Same size as the input
+    const FIntRect Viewport(FIntPoint::ZeroValue, InputTexture.ViewRect.Size());
+
+    FScreenPassTexture TargetTexture;
 
     // Only render the Glare if its intensity is different from 0
-    if (PostProcessDataAsset->GlareIntensity > SMALL_NUMBER)
+    if (Context.Settings->GetParameters().GlareIntensity > SMALL_NUMBER)
     {
         // This compute the number of point that will be drawn
-        // Since we want one point for 2 by 2 pixel block we just 
-        // need to divide the resolution by two to get this value.
+        // Since we want one point per block of pixels (2 by 2 by
+        // default, depends on the quality preset) we just need to
+        // divide the resolution by the tile size to get this value.
+        const int32 TileSize = FMath::Max(Context.Preset.GlareTileSize, 1);
         FIntPoint TileCount = Viewport.Size();
-        TileCount.X = TileCount.X / 2;
-        TileCount.Y = TileCount.Y / 2;
+        TileCount.X = TileCount.X / TileSize;
+        TileCount.Y = TileCount.Y / TileSize;
         int32 Amount = TileCount.X * TileCount.Y;
 
+        if (Context.Counters != nullptr)
+        {
+            Context.Counters->GlareSprites += Amount;
+        }
+
         // Compute the ratio between the width and height
         // to know how to adjust the scaling of the quads.
         // (This assume width is bigger than height.)
@@ -953,12 +2905,11 @@ FRDGTextureRef UPostProcessSubsystem::RenderGlare(
         );
 
         // Build the buffer
-        FRDGTextureDesc Description = InputTexture->Desc;
+        FRDGTextureDesc Description = InputTexture.Texture->Desc;
         Description.Reset();
-        Description.Extent = Viewport.Size();
-        Description.Format = PF_FloatRGB;
+        Description.Format = GetIntermediateFormat(Context);
         Description.ClearValue = FClearValueBinding(FLinearColor::Transparent);
-        FRDGTextureRef GlareTexture = GraphBuilder.CreateTexture(Description, *PassName);
+        FRDGTextureRef GlareTexture = CreatePassTexture(GraphBuilder, Context, Description, PassName);
 
         // Setup a few other variables that will 
         // be needed by the shaders.
@@ -968,81 +2919,227 @@ FRDGTextureRef UPostProcessSubsystem::RenderGlare(
         PixelSize.Z = PixelSize.X;
         PixelSize.W = PixelSize.Y * -1.0f;
 
-        FVector2f BufferSize = FVector2f(Description.Extent);
+        FVector2f BufferSize = FVector2f(Viewport.Size());
 
-        // Setup shader
-        FCustomPostProcessParameters* PassParameters = GraphBuilder.AllocParameters<FCustomPostProcessParameters>();
-        PassParameters->InputTexture = InputTexture;
-        PassParameters->RenderTargets[0] = FRenderTargetBinding(GlareTexture, ERenderTargetLoadAction::EClear);
+        // Shared vertex/geometry settings
+        FGlarePassParameters GlareParameters;
+        GlareParameters.TileCount = TileCount;
+        GlareParameters.TileSize = float(TileSize);
+        GlareParameters.PixelSize = PixelSize;
+        GlareParameters.BufferSize = BufferSize;
+        GlareParameters.BufferRatio = BufferRatio;
 
-        // Vertex shader
-        FGlareVS::FParameters VertexParameters;
-        VertexParameters.Pass = *PassParameters;
-        VertexParameters.InputSampler = BilinearBorderSampler;
-        VertexParameters.TileCount = TileCount;
-        VertexParameters.PixelSize = PixelSize;
-        VertexParameters.BufferSize = BufferSize;
-
-        // Geometry shader
-        FGlareGS::FParameters GeometryParameters;
-        GeometryParameters.BufferSize = BufferSize;
-        GeometryParameters.BufferRatio = BufferRatio;
-        GeometryParameters.PixelSize = PixelSize;
-        GeometryParameters.GlareIntensity = PostProcessDataAsset->GlareIntensity;
-        GeometryParameters.GlareTint = FVector4f(PostProcessDataAsset->GlareTint);
-        GeometryParameters.GlareScales.X = PostProcessDataAsset->GlareScale.X;
-        GeometryParameters.GlareScales.Y = PostProcessDataAsset->GlareScale.Y;
-        GeometryParameters.GlareScales.Z = PostProcessDataAsset->GlareScale.Z;
-        GeometryParameters.GlareDivider = FMath::Max(PostProcessDataAsset->GlareDivider, 0.01f);
+        TUniformBufferRef<FGlarePassParameters> GlareUniformBuffer =
+            TUniformBufferRef<FGlarePassParameters>::CreateUniformBufferImmediate(GlareParameters, UniformBuffer_SingleFrame);
 
         // Pixel shader
         FGlarePS::FParameters PixelParameters;
         PixelParameters.GlareSampler = BilinearClampSampler;
-        PixelParameters.GlareTexture = GWhiteTexture->TextureRHI;
+        PixelParameters.GlareTexture = Context.Settings->GetGlareLineMask();
+
+        TShaderMapRef<FGlarePS> PixelShader(View.ShaderMap);
+
+        // Required for Lambda capture
+        FRHIBlendState* BlendState = this->AdditiveBlendState;
 
-        if (PostProcessDataAsset->GlareLineMask != nullptr)
+        if (Context.bMobile)
         {
-            const FTextureRHIRef TextureRHI = PostProcessDataAsset->GlareLineMask->GetResource()->TextureRHI;
-            PixelParameters.GlareTexture = TextureRHI;
+            // No geometry shader: every tile is an instance whose three
+            // quads are expanded by the vertex shader. Dark tiles output
+            // degenerate triangles.
+            FCustomPostProcessParameters* PassParameters = GraphBuilder.AllocParameters<FCustomPostProcessParameters>();
+            PassParameters->Settings = Context.Settings->GetUniformBuffer();
+            PassParameters->InputTexture = InputTexture.Texture;
+            PassParameters->Input = GetTextureViewportParameters(InputTexture);
+            PassParameters->RenderTargets[0] = FRenderTargetBinding(GlareTexture, ERenderTargetLoadAction::EClear);
+
+            TShaderMapRef<FGlareQuadVS> VertexShader(View.ShaderMap);
+
+            FGlareQuadVS::FParameters VertexParameters;
+            VertexParameters.Pass = *PassParameters;
+            VertexParameters.InputSampler = BilinearBorderSampler;
+            VertexParameters.GlarePass = GlareUniformBuffer;
+
+            TrackPass(Context, PassName, PassParameters);
+
+            GraphBuilder.AddPass(
+                RDG_EVENT_NAME("%s", PassName),
+                PassParameters,
+                ERDGPassFlags::Raster,
+                [
+                    VertexShader, VertexParameters,
+                    PixelShader, PixelParameters,
+                    BlendState, Viewport, Amount
+                ] (FRHICommandList& RHICmdList)
+                {
+                    RHICmdList.SetViewport(
+                        Viewport.Min.X, Viewport.Min.Y, 0.0f,
+                        Viewport.Max.X, Viewport.Max.Y, 1.0f
+                    );
+
+                    SetGlarePipelineState(
+                        RHICmdList,
+                        VertexShader.GetVertexShader(),
+                        nullptr,
+                        PixelShader.GetPixelShader(),
+                        BlendState,
+                        PT_TriangleList
+                    );
+
+                    SetShaderParameters(RHICmdList, VertexShader, VertexShader.GetVertexShader(), VertexParameters);
+                    SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), PixelParameters);
+
+                    RHICmdList.SetStreamSource(0, nullptr, 0);
+                    RHICmdList.DrawPrimitive(0, FGlareQuadVS::NumPrimitives, Amount);
+                });
+
+            return FScreenPassTexture(GlareTexture, Viewport);
         }
 
-        TShaderMapRef<FGlareVS> VertexShader(View.ShaderMap);
+        // Geometry shader
+        FGlareGS::FParameters GeometryParameters;
+        GeometryParameters.Settings = Context.Settings->GetUniformBuffer();
+        GeometryParameters.GlarePass = GlareUniformBuffer;
+
         TShaderMapRef<FGlareGS> GeometryShader(View.ShaderMap);
-        TShaderMapRef<FGlarePS> PixelShader(View.ShaderMap);
 
-        // Required for Lambda capture
-        FRHIBlendState* BlendState = this->AdditiveBlendState;
+        if (Context.bAsyncCompute)
+        {
+            // Tiles are sampled on the compute queue and only the
+            // bright ones end up in the sprite list that is drawn.
+            FRDGBufferRef SpriteBuffer = GraphBuilder.CreateBuffer(
+                FRDGBufferDesc::CreateStructuredDesc(sizeof(FGlareSprite), FMath::Max(Amount, 1)),
+                TEXT("GlareSprites")
+            );
+
+            FRDGBufferRef DrawArgsBuffer = GraphBuilder.CreateBuffer(
+                FRDGBufferDesc::CreateIndirectDesc<FRHIDrawIndirectParameters>(1),
+                TEXT("GlareDrawArgs")
+            );
+
+            FRDGBufferUAVRef DrawArgsUAV = GraphBuilder.CreateUAV(DrawArgsBuffer, PF_R32_UINT);
+            AddClearUAVPass(GraphBuilder, DrawArgsUAV, 0, ERDGPassFlags::AsyncCompute);
+
+            FGlareSetupCS::FPermutationDomain PermutationVector;
+            PermutationVector.Set<FTileMaxDim>(Context.TileMaxTexture != nullptr);
+
+            TShaderMapRef<FGlareSetupCS> ComputeShader(View.ShaderMap, PermutationVector);
+
+            FGlareSetupCS::FParameters* SetupParameters = GraphBuilder.AllocParameters<FGlareSetupCS::FParameters>();
+            SetupParameters->InputTexture = InputTexture.Texture;
+            SetupParameters->Input = GetTextureViewportParameters(InputTexture);
+            SetupParameters->InputSampler = BilinearBorderSampler;
+            SetupParameters->GlarePass = GlareUniformBuffer;
+            SetupParameters->TileMax = GetTileMaxParameters(Context);
+            SetupParameters->RWGlareSprites = GraphBuilder.CreateUAV(SpriteBuffer);
+            SetupParameters->RWGlareDrawArgs = DrawArgsUAV;
+
+            DispatchShaderPass(
+                GraphBuilder,
+                Context,
+                RDG_EVENT_NAME("%sSetup", PassName),
+                SetupParameters,
+                ComputeShader,
+                FIntRect(FIntPoint::ZeroValue, TileCount)
+            );
+
+            FGlareSpritePassParameters* PassParameters = GraphBuilder.AllocParameters<FGlareSpritePassParameters>();
+            PassParameters->GlareSprites = GraphBuilder.CreateSRV(SpriteBuffer);
+            PassParameters->IndirectDrawArgs = DrawArgsBuffer;
+            PassParameters->RenderTargets[0] = FRenderTargetBinding(GlareTexture, ERenderTargetLoadAction::EClear);
+
+            TShaderMapRef<FGlareSpriteVS> VertexShader(View.ShaderMap);
+
+            FGlareSpriteVS::FParameters VertexParameters;
+            VertexParameters.GlareSprites = PassParameters->GlareSprites;
+            VertexParameters.GlarePass = GlareUniformBuffer;
+
+            TrackPass(Context, PassName, PassParameters);
+
+            GraphBuilder.AddPass(
+                RDG_EVENT_NAME("%s", PassName),
+                PassParameters,
+                ERDGPassFlags::Raster,
+                [
+                    PassParameters,
+                    VertexShader, VertexParameters,
+                    GeometryShader, GeometryParameters,
+                    PixelShader, PixelParameters,
+                    BlendState, Viewport
+                ] (FRHICommandList& RHICmdList)
+                {
+                    RHICmdList.SetViewport(
+                        Viewport.Min.X, Viewport.Min.Y, 0.0f,
+                        Viewport.Max.X, Viewport.Max.Y, 1.0f
+                    );
+
+                    SetGlarePipelineState(
+                        RHICmdList,
+                        VertexShader.GetVertexShader(),
+                        GeometryShader.GetGeometryShader(),
+                        PixelShader.GetPixelShader(),
+                        BlendState,
+                        PT_PointList
+                    );
+
+                    SetShaderParameters(RHICmdList, VertexShader, VertexShader.GetVertexShader(), VertexParameters);
+                    SetShaderParameters(RHICmdList, GeometryShader, GeometryShader.GetGeometryShader(), GeometryParameters);
+                    SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), PixelParameters);
+
+                    PassParameters->IndirectDrawArgs->MarkResourceAsUsed();
+
+                    RHICmdList.SetStreamSource(0, nullptr, 0);
+                    RHICmdList.DrawPrimitiveIndirect(PassParameters->IndirectDrawArgs->GetIndirectRHICallBuffer(), 0);
+                });
+
+            return FScreenPassTexture(GlareTexture, Viewport);
+        }
+
+        // Vertex shader
+        // (its parameters are the pass parameters, so that RDG
+        // also sees the tile max map it reads)
+        FGlareVS::FPermutationDomain PermutationVector;
+        PermutationVector.Set<FTileMaxDim>(Context.TileMaxTexture != nullptr);
+
+        TShaderMapRef<FGlareVS> VertexShader(View.ShaderMap, PermutationVector);
+
+        FGlareVS::FParameters* PassParameters = GraphBuilder.AllocParameters<FGlareVS::FParameters>();
+        PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
+        PassParameters->Pass.InputTexture = InputTexture.Texture;
+        PassParameters->Pass.Input = GetTextureViewportParameters(InputTexture);
+        PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(GlareTexture, ERenderTargetLoadAction::EClear);
+        PassParameters->InputSampler = BilinearBorderSampler;
+        PassParameters->GlarePass = GlareUniformBuffer;
+        PassParameters->TileMax = GetTileMaxParameters(Context);
+
+        TrackPass(Context, PassName, PassParameters);
 
         GraphBuilder.AddPass(
-            RDG_EVENT_NAME("%s", *PassName),
+            RDG_EVENT_NAME("%s", PassName),
             PassParameters,
             ERDGPassFlags::Raster,
             [
-                VertexShader, VertexParameters,
+                PassParameters, VertexShader,
                 GeometryShader, GeometryParameters,
                 PixelShader, PixelParameters,
                 BlendState, Viewport, Amount
-            ] (FRHICommandListImmediate& RHICmdList)
+            ] (FRHICommandList& RHICmdList)
             {
                 RHICmdList.SetViewport(
                     Viewport.Min.X, Viewport.Min.Y, 0.0f,
                     Viewport.Max.X, Viewport.Max.Y, 1.0f
                 );
 
-                FGraphicsPipelineStateInitializer GraphicsPSOInit;
-                RHICmdList.ApplyCachedRenderTargets(GraphicsPSOInit);
-                GraphicsPSOInit.BlendState = BlendState;
-                GraphicsPSOInit.RasterizerState = TStaticRasterizerState<>::GetRHI();
-                GraphicsPSOInit.DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
-                GraphicsPSOInit.BoundShaderState.VertexDeclarationRHI = GEmptyVertexDeclaration.VertexDeclarationRHI;
-                GraphicsPSOInit.BoundShaderState.VertexShaderRHI = VertexShader.GetVertexShader();
-				GraphicsPSOInit.BoundShaderState.SetGeometryShader(GeometryShader.GetGeometryShader());
-                GraphicsPSOInit.BoundShaderState.PixelShaderRHI = PixelShader.GetPixelShader();
-                GraphicsPSOInit.PrimitiveType = PT_PointList;
-				// TODO: Get StencilRef for this
-                SetGraphicsPipelineState(RHICmdList, GraphicsPSOInit, 0);
-
-                SetShaderParameters(RHICmdList, VertexShader, VertexShader.GetVertexShader(), VertexParameters);
+                SetGlarePipelineState(
+                    RHICmdList,
+                    VertexShader.GetVertexShader(),
+                    GeometryShader.GetGeometryShader(),
+                    PixelShader.GetPixelShader(),
+                    BlendState,
+                    PT_PointList
+                );
+
+                SetShaderParameters(RHICmdList, VertexShader, VertexShader.GetVertexShader(), *PassParameters);
                 SetShaderParameters(RHICmdList, GeometryShader, GeometryShader.GetGeometryShader(), GeometryParameters);
                 SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), PixelParameters);
 
@@ -1050,7 +3147,7 @@ FRDGTextureRef UPostProcessSubsystem::RenderGlare(
                 RHICmdList.DrawPrimitive(0, 1, Amount);
             });
 
-        TargetTexture = GlareTexture;
+        TargetTexture = FScreenPassTexture(GlareTexture, Viewport);
 
     }
 
@@ -1063,47 +3160,38 @@ FRDGTextureRef UPostProcessSubsystem::RenderGlare(
 // Render passes
 //----------------------------------------------------------
 
-FScreenPassTexture UPostProcessSubsystem::RenderBloom(
+void UPostProcessSubsystem::RenderBloomDownsample(
     FRDGBuilder& GraphBuilder,
+    FPostProcessRenderContext& Context,
     const FViewInfo& View,
-    const FScreenPassTexture& SceneColor,
-    int32 PassAmount
+    const FScreenPassTexture& SceneColor
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderBloomDownsample);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessBloomDown);
+
     check(SceneColor.IsValid());
 
+    const int32 PassAmount = Context.Plan.PassAmount;
+
     if (PassAmount <= 1)
     {
-        return FScreenPassTexture();
+        return;
     }
 
-    RDG_EVENT_SCOPE(GraphBuilder, "BloomPass");
+    RDG_EVENT_SCOPE(GraphBuilder, "BloomDownsample");
+
+    // Level layouts come from the pass plan (see BuildPassPlan). A tile
+    // stops at the level the whole frame bloom takes over from.
+    const int32 LevelCount = Context.TiledLevel > 0 ? Context.TiledLevel + 1 : PassAmount;
 
-    //----------------------------------------------------------
-    // Downsample
-    //----------------------------------------------------------
-    int32 Width = View.ViewRect.Width();
-    int32 Height = View.ViewRect.Height();
     int32 Divider = 2;
-    FRDGTextureRef PreviousTexture = SceneColor.Texture;
+    FScreenPassTexture PreviousTexture = SceneColor;
 
-    for (int32 i = 0; i < PassAmount; i++)
+    for (int32 i = 0; i < LevelCount; i++)
     {
-        FIntRect Size{
-            0,
-            0,
-            FMath::Max(Width / Divider, 1),
-            FMath::Max(Height / Divider, 1)
-        };
-
-        const FString PassName = "Downsample_"
-            + FString::FromInt(i)
-            + "_(1/"
-            + FString::FromInt(Divider)
-            + ")_"
-            + FString::FromInt(Size.Width())
-            + "x"
-            + FString::FromInt(Size.Height());
+        const FScreenPassTextureViewport& Viewport = Context.Plan.BloomViewports[i];
+        const FIntRect& Size = Viewport.Rect;
 
         FRDGTextureRef Texture = nullptr;
 
@@ -1111,189 +3199,356 @@ FScreenPassTexture UPostProcessSubsystem::RenderBloom(
         // so we just reference it and continue.
         if (i == 0)
         {
-            Texture = PreviousTexture;
+            Texture = PreviousTexture.Texture;
         }
         else
         {
             Texture = RenderDownsample(
                 GraphBuilder,
-                PassName,
+                Context,
+                RDG_EVENT_NAME("Downsample_%d_(1/%d)_%dx%d", i, Divider, Size.Width(), Size.Height()),
                 View,
                 PreviousTexture,
-                Size
+                Viewport
             );
         }
 
-        //Store the first downsample pass for flares
-        if (i == 0)
+        //Store the downsample pass for flares
+        if (i == Context.Preset.FlareMip)
         {
             FScreenPassTexture OutputTexture(Texture, Size);
-            DownsampleTextureFlare = OutputTexture;
+            Context.DownsampleTextureFlare = OutputTexture;
         }
 
-        //Store the second downsample pass for glares
-        if (i == 1)
+        //Store the next downsample pass for glares
+        if (i == Context.Preset.FlareMip + 1)
         {
             FScreenPassTexture OutputTexture(Texture, Size);
-            DownsampleTextureGlare = OutputTexture;
+            Context.DownsampleTextureGlare = OutputTexture;
         }
 
         FScreenPassTexture DownsampleTexture(Texture, Size);
 
-        MipMapsDownsample.Add(DownsampleTexture);
-        PreviousTexture = Texture;
+        // Built from the level the flare reads, the glare reads the next
+        // one whose texels never get brighter than the ones they average
+        if (i == Context.Preset.FlareMip && Context.bTileMax)
+        {
+            RenderTileMax(GraphBuilder, Context, View, DownsampleTexture);
+        }
+
+        Context.MipMapsDownsample.Add(DownsampleTexture);
+        PreviousTexture = DownsampleTexture;
         Divider *= 2;
     }
+}
+
+FScreenPassTexture UPostProcessSubsystem::RenderBloomUpsample(
+    FRDGBuilder& GraphBuilder,
+    FPostProcessRenderContext& Context,
+    const FViewInfo& View
+)
+{
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderBloomUpsample);
+    RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessBloomUp);
+
+    const int32 PassAmount = Context.Plan.PassAmount;
+
+    if (PassAmount <= 1)
+    {
+        return FScreenPassTexture();
+    }
+
+    RDG_EVENT_SCOPE(GraphBuilder, "BloomUpsample");
 
-    //----------------------------------------------------------
-    // Upsample
-    //----------------------------------------------------------
     float Radius = CVarBloomRadius.GetValueOnRenderThread();
 
     // Copy downsamples into upsample so that
     // we can easily access current and previous
     // inputs during the upsample process
-    MipMapsUpsample.Append(MipMapsDownsample);
+    Context.MipMapsUpsample.Append(Context.MipMapsDownsample);
+
+    // A tile only upsamples its own levels, on top of the whole frame bloom
+    int32 LevelCount = PassAmount;
+
+    if (Context.TiledLevel > 0)
+    {
+        LevelCount = Context.TiledLevel + 1;
+        Context.MipMapsUpsample.SetNum(Context.TiledLevel);
+        Context.MipMapsUpsample.Add(Context.TiledBloom);
+    }
 
     // Starts at -2 since we need the last buffer
     // as the previous input (-2) and the one just
     // before as the current input (-1).
     // We also go from end to start of array to
     // go from small to big texture (going back up the mips)
-    for (int32 i = PassAmount - 2; i >= 0; i--)
+    for (int32 i = LevelCount - 2; i >= 0; i--)
     {
-        FIntRect CurrentSize = MipMapsUpsample[i].ViewRect;
-
-        const FString PassName = "UpsampleCombine_"
-            + FString::FromInt(i)
-            + "_"
-            + FString::FromInt(CurrentSize.Width())
-            + "x"
-            + FString::FromInt(CurrentSize.Height());
+        FIntRect CurrentSize = Context.MipMapsUpsample[i].ViewRect;
 
         // mix Halo pass into the upscaling process
-        if (i == 1 && CVarRenderHaloPass.GetValueOnRenderThread())
+        if (i == 1 && Context.Plan.bRenderHalo)
         {
             FRDGTextureRef HaloTexture = RenderHalo(
                 GraphBuilder,
-                "HaloPass" + FString::FromInt(i),
+                Context,
+                TEXT("HaloPass"),
                 View,
-                MipMapsUpsample[i]
+                Context.MipMapsUpsample[i]
             );
             FScreenPassTexture HaloMixTexture(HaloTexture, CurrentSize);
-            MipMapsUpsample[i] = HaloMixTexture;
+            Context.MipMapsUpsample[i] = HaloMixTexture;
         }
         FRDGTextureRef ResultTexture = RenderUpsampleCombine(
             GraphBuilder,
-            PassName,
+            Context,
+            RDG_EVENT_NAME("UpsampleCombine_%d_%dx%d", i, CurrentSize.Width(), CurrentSize.Height()),
             View,
-            MipMapsUpsample[i],     // Current texture
-            MipMapsUpsample[i + 1], // Previous texture,
-            Radius
+            Context.MipMapsUpsample[i],     // Current texture
+            Context.MipMapsUpsample[i + 1], // Previous texture,
+            Radius,
+            i + 1 == Context.TiledLevel ? Context.TileUVRect : FVector4f(0.0f, 0.0f, 1.0f, 1.0f)
         );
 
         FScreenPassTexture NewTexture(ResultTexture, CurrentSize);
-        MipMapsUpsample[i] = NewTexture;
+        Context.MipMapsUpsample[i] = NewTexture;
     }
 
-    return MipMapsUpsample[0];
+    return Context.MipMapsUpsample[0];
 }
 
 FScreenPassTexture UPostProcessSubsystem::RenderFlarePass(
     FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
     const FViewInfo& View,
     const FScreenPassTexture& SceneColor
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderFlarePass);
+
     check(SceneColor.IsValid());
 
-    if (!CVarRenderFlarePass.GetValueOnRenderThread())
+    if (!Context.Plan.bRenderFlare)
     {
         return FScreenPassTexture();
     }
 
     RDG_EVENT_SCOPE(GraphBuilder, "FlarePass");
 
-    int32 Width = SceneColor.ViewRect.Width();
-    int32 Height = SceneColor.ViewRect.Height();
-
-    FIntRect Size{
-            0,
-            0,
-            Width,
-            Height
-    };
-
-
-    FRDGTextureRef FlareTexture = nullptr;
+    FScreenPassTexture FlareTexture;
 
     FlareTexture = RenderGhosts(
         GraphBuilder,
-        "FlareGhosts",
+        Context,
+        TEXT("FlareGhosts"),
         View,
-        SceneColor.Texture,
-        Size
+        SceneColor
     );
 
     FlareTexture = RenderBlur(
         GraphBuilder,
+        Context,
         FlareTexture,
-        View,
-        Size,
-        PostProcessDataAsset->BlurSteps
+        View
     );
 
-    FlareTexture = RenderStarburst(
-        GraphBuilder,
-        "FlareStarburst",
-        FlareTexture,
-        View,
-        Size
-    );
-    
-    FScreenPassTexture OutputTexture(FlareTexture, Size);
-    return OutputTexture;
+    if (Context.Plan.bRenderStarburst)
+    {
+        FlareTexture = RenderStarburst(
+            GraphBuilder,
+            Context,
+            TEXT("FlareStarburst"),
+            FlareTexture,
+            View
+        );
+    }
+
+    return FlareTexture;
 }
 
 FScreenPassTexture UPostProcessSubsystem::RenderGlarePass(
     FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
     const FViewInfo& View,
     const FScreenPassTexture& SceneColor
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderGlarePass);
+
     check(SceneColor.IsValid());
 
-    if (!CVarRenderGlarePass.GetValueOnRenderThread())
+    if (!Context.Plan.bRenderGlare)
     {
         return FScreenPassTexture();
     }
 
     RDG_EVENT_SCOPE(GraphBuilder, "GlarePass");
 
-    int32 Width = SceneColor.ViewRect.Width();
-    int32 Height = SceneColor.ViewRect.Height();
-    
-    FIntRect Size{
-            0,
-            0,
-            Width,
-            Height
-    };
-
-    FRDGTextureRef GlareTexture = nullptr;
-    
-    GlareTexture = RenderGlare(
+    return RenderGlare(
         GraphBuilder,
-        "GlareRenderPass",
+        Context,
+        TEXT("GlareRenderPass"),
         View,
-        SceneColor.Texture,
-        Size
+        SceneColor
     );
+}
+
+//----------------------------------------------------------
+// Stats
+//----------------------------------------------------------
+
+void UPostProcessSubsystem::PublishCounters(const FPostProcessViewCounters& Counters)
+{
+    const float TextureMegabytes = float(double(Counters.TextureBytes) / (1024.0 * 1024.0));
+
+    // Stats and CSV stats are reset every frame, the views add up
+    INC_DWORD_STAT_BY(STAT_PrettyPostProcess_Passes, Counters.Passes);
+    INC_FLOAT_STAT_BY(STAT_PrettyPostProcess_TextureMemory, TextureMegabytes);
+    INC_DWORD_STAT_BY(STAT_PrettyPostProcess_Ghosts, Counters.Ghosts);
+    INC_DWORD_STAT_BY(STAT_PrettyPostProcess_GlareSprites, Counters.GlareSprites);
+
+    CSV_CUSTOM_STAT(PrettyPostProcess, Passes, Counters.Passes, ECsvCustomStatOp::Accumulate);
+    CSV_CUSTOM_STAT(PrettyPostProcess, TextureMemoryMB, TextureMegabytes, ECsvCustomStatOp::Accumulate);
+    CSV_CUSTOM_STAT(PrettyPostProcess, Ghosts, Counters.Ghosts, ECsvCustomStatOp::Accumulate);
+    CSV_CUSTOM_STAT(PrettyPostProcess, GlareSprites, Counters.GlareSprites, ECsvCustomStatOp::Accumulate);
 
-    FScreenPassTexture OutputTexture(GlareTexture, Size);
-    return OutputTexture;
+#if COUNTERSTRACE_ENABLED
+    // Insights counters keep their value, the frame total is kept here
+    FScopeLock Lock(&FrameCountersLock);
+
+    if (FrameCountersFrameNumber != GFrameCounterRenderThread)
+    {
+        FrameCountersFrameNumber = GFrameCounterRenderThread;
+        FrameCounters = FPostProcessViewCounters();
+    }
+
+    FrameCounters.Passes += Counters.Passes;
+    FrameCounters.TextureBytes += Counters.TextureBytes;
+    FrameCounters.Ghosts += Counters.Ghosts;
+    FrameCounters.GlareSprites += Counters.GlareSprites;
+
+    TRACE_COUNTER_SET(PrettyPostProcessPasses, FrameCounters.Passes);
+    TRACE_COUNTER_SET(PrettyPostProcessTextureMemory, int64(FrameCounters.TextureBytes));
+    TRACE_COUNTER_SET(PrettyPostProcessGhosts, FrameCounters.Ghosts);
+    TRACE_COUNTER_SET(PrettyPostProcessGlareSprites, FrameCounters.GlareSprites);
+#endif
 }
 
+//----------------------------------------------------------
+// Render functions - Tiled
+//----------------------------------------------------------
+
+void UPostProcessSubsystem::RenderTiledLowFrequency(
+    FRDGBuilder& GraphBuilder,
+    const FPostProcessRenderContext& Context,
+    const FViewInfo& View,
+    const FPostProcessPassPlanKey& PlanKey,
+    const FScreenPassTexture& SceneColor
+)
+{
+    PRETTYPOSTPROCESS_CPU_SCOPE(RenderTiledLowFrequency);
+    RDG_EVENT_SCOPE(GraphBuilder, "TiledLowFrequency");
+
+    const FIntPoint AtlasSize = TiledFrame.AtlasSize;
+
+    // The prepass is halved with the bloom downsample until the next
+    // step would go below the atlas, then resampled into it
+    FScreenPassTexture FrameTexture = SceneColor;
+
+    while (FrameTexture.ViewRect.Width() / 2 >= AtlasSize.X && FrameTexture.ViewRect.Height() / 2 >= AtlasSize.Y)
+    {
+        const FScreenPassTextureViewport Viewport = GetTargetViewport(
+            GetDownscaledViewport(FScreenPassTextureViewport(FrameTexture), FIntPoint(2, 2))
+        );
+
+        const FRDGTextureRef Texture = RenderDownsample(
+            GraphBuilder,
+            Context,
+            RDG_EVENT_NAME("TiledFrameDownsample_%dx%d", Viewport.Rect.Width(), Viewport.Rect.Height()),
+            View,
+            FrameTexture,
+            Viewport
+        );
+
+        FrameTexture = FScreenPassTexture(Texture, Viewport.Rect);
+    }
+
+    const FRDGTextureDesc Description = FRDGTextureDesc::Create2D(
+        AtlasSize,
+        GetIntermediateFormat(Context),
+        FClearValueBinding(FLinearColor::Black),
+        TexCreate_ShaderResource | TexCreate_RenderTargetable
+    );
+
+    const FScreenPassTexture AtlasTexture(
+        CreatePassTexture(GraphBuilder, Context, Description, TEXT("TiledAtlas")),
+        FIntRect(FIntPoint::ZeroValue, AtlasSize)
+    );
+
+    AddDrawTexturePass(
+        GraphBuilder,
+        View,
+        FrameTexture,
+        FScreenPassRenderTarget(AtlasTexture, ERenderTargetLoadAction::ENoAction)
+    );
+
+    // The atlas goes through the rest of the pipeline like a view of its
+    // size, starting at the level the tiles stop at.
+    FPostProcessPassPlanKey AtlasKey = PlanKey;
+    AtlasKey.Extent = AtlasSize;
+    AtlasKey.ViewRect = AtlasTexture.ViewRect;
+    AtlasKey.BloomPassAmount = Context.Plan.PassAmount - TiledFrame.Level;
+    AtlasKey.BloomResLimit = 0;
+    AtlasKey.Preset.FlareMip = FMath::Max(Context.Preset.FlareMip - TiledFrame.Level, 0);
+
+    FPostProcessRenderContext AtlasContext;
+    AtlasContext.Quality = Context.Quality;
+    AtlasContext.Preset = AtlasKey.Preset;
+    AtlasContext.Settings = Context.Settings;
+    AtlasContext.bMobile = Context.bMobile;
+    AtlasContext.bR11G11B10RenderTarget = Context.bR11G11B10RenderTarget;
+    AtlasContext.bR11G11B10TypedUAVStore = Context.bR11G11B10TypedUAVStore;
+    AtlasContext.Footprint = Context.Footprint;
+    AtlasContext.Counters = Context.Counters;
+
+    BuildPassPlan(*Context.Settings, AtlasKey, AtlasContext.Plan);
+
+    RenderBloomDownsample(GraphBuilder, AtlasContext, View, AtlasTexture);
+
+    FScreenPassTexture FlareTexture;
+    FScreenPassTexture GlareTexture;
+
+    if (AtlasContext.DownsampleTextureFlare.IsValid())
+    {
+        FlareTexture = RenderFlarePass(GraphBuilder, AtlasContext, View, AtlasContext.DownsampleTextureFlare);
+    }
+
+    if (AtlasContext.DownsampleTextureGlare.IsValid())
+    {
+        GlareTexture = RenderGlarePass(GraphBuilder, AtlasContext, View, AtlasContext.DownsampleTextureGlare);
+    }
+
+    const FScreenPassTexture BloomTexture = RenderBloomUpsample(GraphBuilder, AtlasContext, View);
+
+    // Kept for the tiles of the frame
+    if (BloomTexture.IsValid())
+    {
+        GraphBuilder.QueueTextureExtraction(BloomTexture.Texture, &TiledFrame.Bloom);
+        TiledFrame.BloomRect = BloomTexture.ViewRect;
+    }
+
+    if (FlareTexture.IsValid())
+    {
+        GraphBuilder.QueueTextureExtraction(FlareTexture.Texture, &TiledFrame.Flare);
+        TiledFrame.FlareRect = FlareTexture.ViewRect;
+    }
+
+    if (GlareTexture.IsValid())
+    {
+        GraphBuilder.QueueTextureExtraction(GlareTexture.Texture, &TiledFrame.Glare);
+        TiledFrame.GlareRect = GlareTexture.ViewRect;
+    }
+}
 
 //----------------------------------------------------------
 // Final delegate render function
@@ -1306,33 +3561,84 @@ void UPostProcessSubsystem::Render(
     FScreenPassTexture& Output
 )
 {
+    PRETTYPOSTPROCESS_CPU_SCOPE(Render);
+
     check(SceneColor.IsValid());
 
-    if (PostProcessDataAsset == nullptr)
+    // For the structure check
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+
+    // Keeps the settings alive while the view is recorded, even
+    // if the asset is edited (and the proxy replaced) meanwhile.
+    const TSharedPtr<FPostProcessSettingsProxy, ESPMode::ThreadSafe> Settings = SettingsProxy;
+
+    if (!Settings.IsValid())
     {
         return;
     }
 
-    InitStates();
+    // Captures, thumbnails and other secondary views get a cheaper
+    // version of the pipeline (or none at all).
+    const EPostProcessViewQuality ViewQuality = GetViewQuality(View);
+
+    if (ViewQuality == EPostProcessViewQuality::Skip)
+    {
+        return;
+    }
 
     RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcess)
     RDG_EVENT_SCOPE(GraphBuilder, "PrettyPostProcess");
 
-    int32 PassAmount = 1;
-	int32 ViewWidth = View.ViewRect.Width();
-	int32 ViewHeight = View.ViewRect.Height();
+    FPostProcessQualityPreset Preset = GetQualityPreset();
 
-	// Limit pass amount to not going smaller than specified resolution limit
-	while (PassAmount < CVarBloomPassAmount.GetValueOnRenderThread()
-		&& ViewWidth > CVarBloomResLimit.GetValueOnRenderThread() && ViewHeight > CVarBloomResLimit.GetValueOnRenderThread())
-	{
-		PassAmount++;
-		ViewWidth /= 2;
-		ViewHeight /= 2;
+    // The governor only applies to the main views, captures already
+    // run a reduced pipeline and would skew the measurements.
+    const float BudgetMs = CVarBudget.GetValueOnRenderThread();
+    FPostProcessBudgetGovernor* Governor = nullptr;
 
-		// failsafe
-		if (PassAmount > CVarBloomPassAmount.GetValueOnRenderThread()) break;
-	}
+    if (BudgetGovernor.IsValid())
+    {
+        if (BudgetMs > 0.0f && ViewQuality == EPostProcessViewQuality::Full)
+        {
+            Governor = BudgetGovernor.Get();
+            Governor->Update(BudgetMs);
+            Governor->Apply(Preset);
+        }
+        else if (BudgetMs <= 0.0f)
+        {
+            BudgetGovernor->Reset();
+        }
+    }
+
+    // Everything the plan depends on, read once. The plan itself is only
+    // rebuilt when this changes (resize, cvar or data asset edit).
+    FPostProcessPassPlanKey PlanKey;
+    PlanKey.Extent = SceneColor.Texture->Desc.Extent;
+    PlanKey.ViewRect = SceneColor.ViewRect;
+    PlanKey.ViewSize = View.ViewRect.Size();
+    PlanKey.Quality = ViewQuality;
+    PlanKey.Preset = Preset;
+    PlanKey.BloomPassAmount = CVarBloomPassAmount.GetValueOnRenderThread();
+    PlanKey.BloomResLimit = CVarBloomResLimit.GetValueOnRenderThread();
+    PlanKey.bRenderFlare = CVarRenderFlarePass.GetValueOnRenderThread() != 0;
+    PlanKey.bRenderHalo = CVarRenderHaloPass.GetValueOnRenderThread() != 0;
+    PlanKey.bRenderGlare = CVarRenderGlarePass.GetValueOnRenderThread() != 0
+        && (View.GetFeatureLevel() >= ERHIFeatureLevel::SM5 || CVarMobileGlare.GetValueOnRenderThread() != 0);
+    PlanKey.AssetRevision = Settings->GetRevision();
+
+    // Tiles of a tiled render are laid out like their whole frame, and so
+    // is the prepass of the frame
+    const bool bTiled = Tile.IsSet()
+        && ViewQuality == EPostProcessViewQuality::Full
+        && !Tile->Rect.IsEmpty()
+        && Tile->FrameSize.GetMin() > 0;
+    TOptional<FScopeLock> TiledLock;
+
+    if (bTiled)
+    {
+        PlanKey.ViewSize = Tile->FrameSize;
+        TiledLock.Emplace(&TiledFrameLock);
+    }
 
     // Buffers setup
     const FScreenPassTexture BlackDummy{
@@ -1342,98 +3648,274 @@ void UPostProcessSubsystem::Render(
         )
     };
 
+    // Per-view state, lives only for the duration of this call
+    FPostProcessRenderContext Context;
+    Context.Quality = ViewQuality;
+    Context.Preset = Preset;
+    Context.Plan = GetPassPlan(View, *Settings, PlanKey);
+    Context.Settings = Settings.Get();
+    Context.bMobile = View.GetFeatureLevel() < ERHIFeatureLevel::SM5;
+    Context.bR11G11B10RenderTarget = UE::PixelFormat::HasCapabilities(PF_FloatR11G11B10, EPixelFormatCapabilities::RenderTarget);
+    Context.bR11G11B10TypedUAVStore = UE::PixelFormat::HasCapabilities(PF_FloatR11G11B10, EPixelFormatCapabilities::TypedUAVStore);
+
+    // Flare and glare only depend on the first two downsamples, running
+    // them on the async compute queue lets them overlap the bloom upsample
+    // chain. The mix pass reading their output is the join point.
+    Context.bAsyncCompute = CVarAsyncCompute.GetValueOnRenderThread() != 0
+        && GSupportsEfficientAsyncCompute
+        && !Context.bMobile
+        && Governor == nullptr;
+
+    Context.bTileMax = CVarTileMax.GetValueOnRenderThread() != 0
+        && !Context.bMobile
+        && !bTiled
+        && (Context.Plan.bRenderFlare || Context.Plan.bRenderHalo || Context.Plan.bRenderGlare);
+
+    // Dark views stop rendering flare and glare altogether. The decision
+    // comes from the tile max maps of the previous frames, which keep
+    // being built (and read back) while the stages are skipped.
+    const uint32 ViewKey = GetViewKey(View, SceneColor.ViewRect);
+    const bool bAutoSkip = AutoSkip.IsValid()
+        && Context.bTileMax
+        && CVarAutoSkip.GetValueOnRenderThread() != 0;
+
+    FPostProcessSkipState SkipState;
+
+    if (bAutoSkip)
+    {
+        SkipState = AutoSkip->Update(
+            ViewKey,
+            CVarTileMaxThreshold.GetValueOnRenderThread(),
+            GlareSpriteThreshold
+        );
+    }
+
+    FPostProcessViewCounters Counters;
+    Context.Counters = &Counters;
+
+    TUniquePtr<FPostProcessFootprint> Footprint;
+    const bool bDumpFootprint = ShouldCaptureFootprint();
+    const bool bRecordStructure = ShouldRecordStructure();
+
+    if (bDumpFootprint || bRecordStructure)
+    {
+        Footprint = MakeUnique<FPostProcessFootprint>();
+        Footprint->AddExternal(SceneColor.Texture);
+        Footprint->AddExternal(BlackDummy.Texture);
+        Context.Footprint = Footprint.Get();
+    }
+
+    // Main views only, tiles don't see the whole frame
+    if (CaptureRecorder.IsValid())
+    {
+        CaptureRecorder->Update();
+
+        if (ViewQuality == EPostProcessViewQuality::Full && !bTiled)
+        {
+            CaptureRecorder->AddReadback(GraphBuilder, SceneColor, [&](FPostProcessCapture& ViewCapture)
+                {
+                    ViewCapture.ViewSize = PlanKey.ViewSize;
+                    ViewCapture.Quality = ViewQuality;
+                    ViewCapture.Preset = Preset;
+                    ViewCapture.bMobile = Context.bMobile;
+                });
+        }
+    }
+
+    // Views where nothing moves (menus, pause screens, photo mode) get the
+    // output of a previous frame back, while the signature of their scene
+    // color keeps being read back to notice when something changes. Not
+    // with the budget governor, its measurements would swing between
+    // cached and rendered frames.
+    const bool bStaticCache = StaticCache.IsValid()
+        && CVarStaticCache.GetValueOnRenderThread() != 0
+        && ViewQuality == EPostProcessViewQuality::Full
+        && !bTiled
+        && !Context.bMobile
+        && Governor == nullptr
+        && !Footprint.IsValid();
+
+    FPostProcessStaticCacheKey StaticCacheKey;
+
+    if (bStaticCache)
+    {
+        StaticCacheKey.PlanKey = PlanKey;
+        StaticCacheKey.BloomRadius = CVarBloomRadius.GetValueOnRenderThread();
+        StaticCacheKey.bTileMax = Context.bTileMax;
+        StaticCacheKey.TileMaxThreshold = CVarTileMaxThreshold.GetValueOnRenderThread();
+        StaticCacheKey.SkipState = SkipState;
+        StaticCacheKey.ViewMatrix = View.ViewMatrices.GetViewMatrix();
+        StaticCacheKey.ProjectionMatrix = View.ViewMatrices.GetProjectionNoAAMatrix();
+
+        TRefCountPtr<IPooledRenderTarget> CachedTexture;
+        FIntRect CachedRect;
+
+        const bool bCached = StaticCache->Update(
+            ViewKey,
+            StaticCacheKey,
+            CVarStaticCacheThreshold.GetValueOnRenderThread(),
+            CVarStaticCacheFrames.GetValueOnRenderThread(),
+            CachedTexture,
+            CachedRect
+        );
+
+        StaticCache->AddReadback(GraphBuilder, ViewKey, RenderSignature(GraphBuilder, Context, View, SceneColor));
+
+        if (bCached)
+        {
+            Output.Texture = GraphBuilder.RegisterExternalTexture(CachedTexture, TEXT("PrettyPostProcess.Cached"));
+            Output.ViewRect = CachedRect;
+
+            PublishCounters(Counters);
+            return;
+        }
+    }
+    else if (StaticCache.IsValid() && CVarStaticCache.GetValueOnRenderThread() == 0)
+    {
+        StaticCache->Reset();
+    }
+
     FScreenPassTexture BloomTexture;
     FScreenPassTexture FlareTexture;
     FScreenPassTexture GlareTexture;
-    FScreenPassTexture InputTexture(SceneColor.Texture);
 
-    // Scene color setup
-    // We need to pass a FScreenPassTexture into FScreenPassTextureViewport()
-    // and not a FRDGTextureRef (aka SceneColor.Texture) to ensure we can compute
-    // the right Rect vs Extent sub-region. Otherwise only the full buffer 
-    // resolution is gonna be reported leading to NaNs/garbage in the rendering.
-    const FScreenPassTextureViewport SceneColorViewport(SceneColor);
-    const FVector2f SceneColorViewportSize = GetInputViewportSize(SceneColorViewport.Rect, SceneColorViewport.Extent);
+    // Size the gradient of the mix is laid out on
+    FVector2f ScreenSize(SceneColor.ViewRect.Size());
 
     //----------------------------------------------------------
-    // Editor buffer rescale
+    // Tiled render
     //----------------------------------------------------------
-#if WITH_EDITOR
-    // Rescale the Scene Color to fit the whole texture and not use a sub-region.
-    // This is to simplify the render pass (shaders) that come after.
-    // This part is skipped when built without the editor because
-    // it is not needed (unless splitscreen needs it ?).
-    if (SceneColorViewport.Rect.Width() != SceneColorViewport.Extent.X
-        || SceneColorViewport.Rect.Height() != SceneColorViewport.Extent.Y)
+    // Tiles stop at the first bloom level where the whole frame fits the
+    // tiled resolution. The smaller levels, flare, halo and glare run once
+    // per output frame on the whole frame at that level, from the prepass
+    // of the frame (SetRenderFrame), and each tile reads its part of them.
+    if (bTiled)
     {
-        const FString PassName("SceneColorRescale");
+        int32 Level = 0;
+        FIntPoint AtlasSize;
+        const bool bLowFrequency = GetTiledLayout(Tile->FrameSize, Context.Plan.PassAmount, Level, AtlasSize);
 
-        // Build texture
-        FRDGTextureDesc Desc = SceneColor.Texture->Desc;
-        Desc.Reset();
-        Desc.Extent = SceneColorViewport.Rect.Size();
-        Desc.Format = PF_FloatRGB;
-        Desc.ClearValue = FClearValueBinding(FLinearColor::Transparent);
-        FRDGTextureRef RescaleTexture = GraphBuilder.CreateTexture(Desc, *PassName);
+        // The prepass only feeds the tiles, its own output is discarded
+        if (Tile->bFrame)
+        {
+            if (bLowFrequency && TiledFrame.FrameIndex != Tile->FrameIndex)
+            {
+                TiledFrame = FPostProcessTiledFrame();
+                TiledFrame.Level = Level;
+                TiledFrame.AtlasSize = AtlasSize;
+                TiledFrame.FrameIndex = Tile->FrameIndex;
 
-        // Render shader
-        TShaderMapRef<FCustomScreenPassVS> VertexShader(View.ShaderMap);
-        TShaderMapRef<FEditorRescalePS> PixelShader(View.ShaderMap);
+                RenderTiledLowFrequency(GraphBuilder, Context, View, PlanKey, SceneColor);
+            }
 
-        FEditorRescalePS::FParameters* PassParameters = GraphBuilder.AllocParameters<FEditorRescalePS::FParameters>();
-        PassParameters->Pass.InputTexture = SceneColor.Texture;
-        PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(RescaleTexture, ERenderTargetLoadAction::ENoAction);
-        PassParameters->InputSampler = BilinearClampSampler;
-        PassParameters->InputViewportSize = SceneColorViewportSize;
+            PublishCounters(Counters);
+            return;
+        }
 
-        DrawShaderPass(
-            GraphBuilder,
-            PassName,
-            PassParameters,
-            VertexShader,
-            PixelShader,
-            ClearBlendState,
-            SceneColorViewport.Rect
-        );
+        // Without a prepass for this frame, the tile renders on its own
+        // (seams included)
+        if (bLowFrequency
+            && TiledFrame.FrameIndex == Tile->FrameIndex
+            && TiledFrame.Level == Level
+            && TiledFrame.Bloom.IsValid())
+        {
+            const auto RegisterTiled = [&GraphBuilder](const TRefCountPtr<IPooledRenderTarget>& Target, const FIntRect& Rect)
+            {
+                return Target.IsValid()
+                    ? FScreenPassTexture(GraphBuilder.RegisterExternalTexture(Target), Rect)
+                    : FScreenPassTexture();
+            };
+
+            Context.TiledBloom = RegisterTiled(TiledFrame.Bloom, TiledFrame.BloomRect);
+            FlareTexture = RegisterTiled(TiledFrame.Flare, TiledFrame.FlareRect);
+            GlareTexture = RegisterTiled(TiledFrame.Glare, TiledFrame.GlareRect);
+
+            const FVector2f FrameSize(Tile->FrameSize);
+
+            Context.TiledLevel = Level;
+            Context.TileUVRect = FVector4f(
+                Tile->Rect.Min.X / FrameSize.X,
+                Tile->Rect.Min.Y / FrameSize.Y,
+                Tile->Rect.Max.X / FrameSize.X,
+                Tile->Rect.Max.Y / FrameSize.Y
+            );
+            Context.Plan.bRenderHalo = false;
 
-        InputTexture.Texture = RescaleTexture;
-        InputTexture.ViewRect = SceneColorViewport.Rect;
+            ScreenSize = FrameSize;
+        }
     }
-#endif
 
-	
+    // Scene color setup
+    // The scene color is read in place through its viewport parameters,
+    // whatever its view rect is (dynamic resolution, split-screen,
+    // letterboxing or the editor viewport being smaller than the buffer).
+    // Only internal targets are guaranteed to start at the origin.
+    const FScreenPassTexture InputTexture(SceneColor);
 
     //----------------------------------------------------------
     // Render passes
     //----------------------------------------------------------
+    // Recorded so that each chain is done with its intermediates before
+    // the next one allocates: bloom downsamples, flare and glare (which
+    // only keep their output), then the bloom upsamples.
 
-    // Bloom
+    // Bloom downsample
     {
-        BloomTexture = RenderBloom(
+        FPostProcessBudgetScope BudgetScope(Governor, GraphBuilder, EPostProcessStage::Bloom);
+
+        RenderBloomDownsample(
             GraphBuilder,
+            Context,
             View,
-            InputTexture,
-            PassAmount
+            InputTexture
+        );
+    }
+
+    if (bAutoSkip && Context.TileMaxTexture != nullptr)
+    {
+        const FIntPoint TileCount(
+            FMath::CeilToInt(Context.TileMaxScale.X),
+            FMath::CeilToInt(Context.TileMaxScale.Y)
         );
+
+        AutoSkip->AddReadback(GraphBuilder, ViewKey, Context.TileMaxTexture, TileCount);
     }
 
     // Flare
+    // (the source mip may not exist when the bloom pass count is low)
+    if (Context.DownsampleTextureFlare.IsValid() && !SkipState.bSkipFlare && Context.TiledLevel == 0)
     {
+        FPostProcessBudgetScope BudgetScope(Governor, GraphBuilder, EPostProcessStage::Flare);
+
         FlareTexture = RenderFlarePass(
             GraphBuilder,
+            Context,
             View,
-            DownsampleTextureFlare
+            Context.DownsampleTextureFlare
         );
-
-        
     }
 
     // Glare
+    if (Context.DownsampleTextureGlare.IsValid() && !SkipState.bSkipGlare && Context.TiledLevel == 0)
     {
+        FPostProcessBudgetScope BudgetScope(Governor, GraphBuilder, EPostProcessStage::Glare);
+
         GlareTexture = RenderGlarePass(
             GraphBuilder,
+            Context,
             View,
-            DownsampleTextureGlare
+            Context.DownsampleTextureGlare
+        );
+    }
+
+    // Bloom upsample
+    {
+        FPostProcessBudgetScope BudgetScope(Governor, GraphBuilder, EPostProcessStage::Bloom);
+
+        BloomTexture = RenderBloomUpsample(
+            GraphBuilder,
+            Context,
+            View
         );
     }
 
@@ -1441,17 +3923,18 @@ void UPostProcessSubsystem::Render(
     // Composite Bloom pass
     //----------------------------------------------------------
     FRDGTextureRef MixTexture = nullptr;
-    FIntRect MixViewport{
-        0,
-        0,
-        View.ViewRect.Width() / 2,
-        View.ViewRect.Height() / 2
-    };
+
+    // Same layout as the (half resolution) input, so the
+    // allocation doesn't change with the view rect either.
+    const FScreenPassTextureViewport MixTextureViewport(InputTexture);
+    const FIntRect MixViewport = MixTextureViewport.Rect;
 
     {
+        PRETTYPOSTPROCESS_CPU_SCOPE(Mix);
+        RDG_GPU_STAT_SCOPE(GraphBuilder, PrettyPostProcessMix);
         RDG_EVENT_SCOPE(GraphBuilder, "MixPass");
 
-        const FString PassName("Mix");
+        const TCHAR* PassName = TEXT("Mix");
 
         float BloomIntensity = 1.0f;
 
@@ -1459,93 +3942,107 @@ void UPostProcessSubsystem::Render(
         // (aka not using the lerp) then uncomment this line to
         // normalize the final bloom intensity.
 
-        BloomIntensity = 1.0f / float( FMath::Max( PassAmount, 1 ) );
+        BloomIntensity = 1.0f / float( FMath::Max( Context.Plan.PassAmount, 1 ) );
 
         FVector2f BufferSize{
             float(MixViewport.Width()),
             float(MixViewport.Height())
         };
 
-        FIntVector BuffersValidity{
-            (BloomTexture.IsValid()),
-            (FlareTexture.IsValid()),
-            (GlareTexture.IsValid())
-        };
+        // Missing inputs are compiled out of the shader
+        FMixPS::FPermutationDomain PermutationVector;
+        PermutationVector.Set<FMixBloomDim>(GetFeaturePermutation(BloomTexture.IsValid()));
+        PermutationVector.Set<FMixFlareDim>(GetFeaturePermutation(FlareTexture.IsValid()));
+        PermutationVector.Set<FMixGlareDim>(GetFeaturePermutation(GlareTexture.IsValid()));
 
         // Create texture
-        FRDGTextureDesc Description = SceneColor.Texture->Desc;
+        FRDGTextureDesc Description = InputTexture.Texture->Desc;
         Description.Reset();
-        Description.Extent = MixViewport.Size();
-        Description.Format = PF_FloatRGB;
+        Description.Extent = MixTextureViewport.Extent;
+        Description.Format = GetIntermediateFormat(Context);
         Description.ClearValue = FClearValueBinding(FLinearColor::Black);
-        MixTexture = GraphBuilder.CreateTexture(Description, *PassName);
+        MixTexture = CreatePassTexture(GraphBuilder, Context, Description, PassName);
 
         // Render shader
         TShaderMapRef<FCustomScreenPassVS> VertexShader(View.ShaderMap);
-        TShaderMapRef<FMixPS> PixelShader(View.ShaderMap);
+        TShaderMapRef<FMixPS> PixelShader(View.ShaderMap, PermutationVector);
 
         FMixPS::FParameters* PassParameters = GraphBuilder.AllocParameters<FMixPS::FParameters>();
         PassParameters->Pass.RenderTargets[0] = FRenderTargetBinding(MixTexture, ERenderTargetLoadAction::ENoAction);
         PassParameters->InputSampler = BilinearClampSampler;
-        PassParameters->MixPass = BuffersValidity;
 
 		// Get screen size for aspect ratio calculation
-		PassParameters->InputScreenSize = FVector2f(MixViewport.Size());
+		PassParameters->InputScreenSize = ScreenSize;
+        PassParameters->TileUVRect = Context.TileUVRect;
 
         // Bloom
         PassParameters->BloomTexture = BlackDummy.Texture;
+        PassParameters->Bloom = GetTextureViewportParameters(BlackDummy);
         PassParameters->BloomIntensity = BloomIntensity;
 
         // Glare
         PassParameters->GlareTexture = BlackDummy.Texture;
+        PassParameters->Glare = GetTextureViewportParameters(BlackDummy);
         PassParameters->PixelSize = FVector2f(1.0f, 1.0f) / BufferSize;
 
         // Flare
+        PassParameters->Pass.Settings = Context.Settings->GetUniformBuffer();
         PassParameters->Pass.InputTexture = BlackDummy.Texture;
-        PassParameters->FlareIntensity = PostProcessDataAsset->FlareIntensity;
-        PassParameters->FlareTint = FVector4f(PostProcessDataAsset->FlareTint);
-        PassParameters->GradientTexture = GWhiteTexture->TextureRHI;
+        PassParameters->Pass.Input = GetTextureViewportParameters(BlackDummy);
+        PassParameters->GradientTexture = Context.Settings->GetFlareGradient();
         PassParameters->GradientSampler = BilinearClampSampler;
 
-        if (BuffersValidity.X)
+        if (BloomTexture.IsValid())
         {
             PassParameters->BloomTexture = BloomTexture.Texture;
+            PassParameters->Bloom = GetTextureViewportParameters(BloomTexture);
         }
 
-        if (BuffersValidity.Y)
+        if (FlareTexture.IsValid())
         {
             PassParameters->Pass.InputTexture = FlareTexture.Texture;
+            PassParameters->Pass.Input = GetTextureViewportParameters(FlareTexture, Context.TileUVRect);
         }
 
-        if (BuffersValidity.Z)
+        if (GlareTexture.IsValid())
         {
             PassParameters->GlareTexture = GlareTexture.Texture;
+            PassParameters->Glare = GetTextureViewportParameters(GlareTexture, Context.TileUVRect);
         }
 
-		if (PostProcessDataAsset->FlareGradient != nullptr)
-		{
-			const FTextureRHIRef TextureRHI = PostProcessDataAsset->FlareGradient->GetResource()->TextureRHI;
-			PassParameters->GradientTexture = TextureRHI;
-		}
-
         // Render
         DrawShaderPass(
             GraphBuilder,
-            PassName,
+            Context,
+            RDG_EVENT_NAME("%s", PassName),
             PassParameters,
             VertexShader,
             PixelShader,
             ClearBlendState,
             MixViewport
         );
-
-        // Reset texture lists
-        MipMapsDownsample.Empty();
-        MipMapsUpsample.Empty();
     }
 
     // Output
     Output.Texture = MixTexture;
     Output.ViewRect = MixViewport;
 
+    // Kept past the graph, at the cost of the mix texture no longer being transient
+    if (bStaticCache)
+    {
+        StaticCache->Store(ViewKey, StaticCacheKey, GraphBuilder.ConvertToExternalTexture(MixTexture), MixViewport);
+    }
+
+    PublishCounters(Counters);
+
+    if (bDumpFootprint)
+    {
+        Footprint->Dump(View.ViewRect);
+    }
+
+    if (bRecordStructure)
+    {
+        RecordStructure(Context, *Footprint, StartCycles);
+    }
+
 }
@@ -0,0 +1,128 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHI.h"
+#include "RHIGPUReadback.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+
+// Per-view GPU readbacks, shared by the auto skip and the static cache.
+// Each view has a ring of copies in flight, read back in order a few
+// frames later without ever waiting on the GPU, next to the DataType its
+// owner keeps. Views that stop being rendered are dropped. Not thread
+// safe, the owner serializes the calls.
+template<typename DataType>
+class TPostProcessViewReadbacks
+{
+public:
+    // Readbacks in flight per view, results are read this many frames later at most
+    static constexpr int32 NumReadbacks = 3;
+
+    // Frames a view is kept around without being rendered
+    static constexpr uint64 ViewLifetime = 120;
+
+    struct FReadback
+    {
+        TUniquePtr<FRHIGPUTextureReadback> Readback;
+
+        // Valid part of the copied texture, and the frame it was copied on
+        FIntPoint Size = FIntPoint::ZeroValue;
+        uint64 FrameNumber = 0;
+    };
+
+    struct FView
+    {
+        DataType Data;
+
+        // Ring of readbacks, OldestReadback is the next one to complete
+        FReadback Readbacks[NumReadbacks];
+        int32 OldestReadback = 0;
+        int32 NumInFlight = 0;
+
+        uint64 LastUsedFrame = 0;
+    };
+
+    // View rendered this frame, added on its first frame (dropping the
+    // views that went away)
+    FView& FindOrAdd(uint32 ViewKey)
+    {
+        const uint64 FrameNumber = GFrameCounterRenderThread;
+
+        FView* View = Views.Find(ViewKey);
+
+        if (View == nullptr)
+        {
+            for (auto It = Views.CreateIterator(); It; ++It)
+            {
+                if (FrameNumber - It.Value().LastUsedFrame > ViewLifetime)
+                {
+                    It.RemoveCurrent();
+                }
+            }
+
+            View = &Views.Add(ViewKey);
+        }
+
+        View->LastUsedFrame = FrameNumber;
+        return *View;
+    }
+
+    FView* Find(uint32 ViewKey)
+    {
+        return Views.Find(ViewKey);
+    }
+
+    // Call Read(FReadback&) on the readbacks of a view that are done, oldest first
+    template<typename ReadType>
+    static void ReadCompleted(FView& View, ReadType&& Read)
+    {
+        // Copies complete in order, stop at the first one still running
+        while (View.NumInFlight > 0)
+        {
+            FReadback& Readback = View.Readbacks[View.OldestReadback];
+
+            if (!Readback.Readback->IsReady())
+            {
+                break;
+            }
+
+            Read(Readback);
+
+            View.OldestReadback = (View.OldestReadback + 1) % NumReadbacks;
+            View.NumInFlight--;
+        }
+    }
+
+    // Copy back Size texels of Texture, unless all the readbacks of the
+    // view are still in flight
+    static void AddReadback(FRDGBuilder& GraphBuilder, FView& View, FRDGTextureRef Texture, const FIntPoint& Size, const TCHAR* Name)
+    {
+        if (View.NumInFlight == NumReadbacks)
+        {
+            return;
+        }
+
+        FReadback& Readback = View.Readbacks[(View.OldestReadback + View.NumInFlight) % NumReadbacks];
+
+        if (!Readback.Readback.IsValid())
+        {
+            Readback.Readback = MakeUnique<FRHIGPUTextureReadback>(Name);
+        }
+
+        Readback.Size = Size;
+        Readback.FrameNumber = GFrameCounterRenderThread;
+        View.NumInFlight++;
+
+        AddEnqueueCopyPass(GraphBuilder, Readback.Readback.Get(), Texture);
+    }
+
+    void Reset()
+    {
+        Views.Reset();
+    }
+
+private:
+    TMap<uint32, FView> Views;
+};
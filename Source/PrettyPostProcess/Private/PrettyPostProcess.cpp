@@ -5,6 +5,8 @@
 
 #define LOCTEXT_NAMESPACE "FPrettyPostProcessModule"
 
+DEFINE_LOG_CATEGORY(LogPrettyPostProcess);
+
 void FPrettyPostProcessModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
@@ -0,0 +1,1260 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PrettyPostProcessCPU.h"
+#include "PostProcessDataAsset.h"
+#include "Async/ParallelFor.h"
+
+namespace PrettyPostProcessCPU
+{
+namespace
+{
+    using FVec = VectorRegister4Float;
+
+    // Same thresholds as the shaders
+    constexpr float GlareLuminanceThreshold = 0.1f;
+    constexpr float GlareMinQuadScale = 0.0001f;
+
+    // 4 pixels of an RGB image, one register per channel
+    struct FColor4
+    {
+        FVec R;
+        FVec G;
+        FVec B;
+    };
+
+    enum class EAddress : uint8
+    {
+        Clamp,
+        Wrap
+    };
+
+    FORCEINLINE FVec Splat(float Value)
+    {
+        return VectorSetFloat1(Value);
+    }
+
+    FORCEINLINE FColor4 Black4()
+    {
+        return { VectorZeroFloat(), VectorZeroFloat(), VectorZeroFloat() };
+    }
+
+    // Accumulator += Color * Weight
+    FORCEINLINE void MultiplyAdd(FColor4& Accumulator, const FColor4& Color, const FVec& Weight)
+    {
+        Accumulator.R = VectorMultiplyAdd(Color.R, Weight, Accumulator.R);
+        Accumulator.G = VectorMultiplyAdd(Color.G, Weight, Accumulator.G);
+        Accumulator.B = VectorMultiplyAdd(Color.B, Weight, Accumulator.B);
+    }
+
+    FORCEINLINE FColor4 Multiply(const FColor4& Color, const FVec& Scale)
+    {
+        return { VectorMultiply(Color.R, Scale), VectorMultiply(Color.G, Scale), VectorMultiply(Color.B, Scale) };
+    }
+
+    FORCEINLINE FVec Saturate(const FVec& Value)
+    {
+        return VectorMin(VectorMax(Value, VectorZeroFloat()), VectorOneFloat());
+    }
+
+    FORCEINLINE FVec SmoothStep(float Min, float Max, const FVec& Value)
+    {
+        const FVec T = Saturate(VectorMultiply(VectorSubtract(Value, Splat(Min)), Splat(1.0f / (Max - Min))));
+        return VectorMultiply(VectorMultiply(T, T), VectorSubtract(Splat(3.0f), VectorAdd(T, T)));
+    }
+
+    // Smoothstep with a variable lower edge
+    FORCEINLINE FVec SmoothStep(const FVec& Min, float Max, const FVec& Value)
+    {
+        const FVec T = Saturate(VectorDivide(VectorSubtract(Value, Min), VectorSubtract(Splat(Max), Min)));
+        return VectorMultiply(VectorMultiply(T, T), VectorSubtract(Splat(3.0f), VectorAdd(T, T)));
+    }
+
+    FORCEINLINE FVec Length(const FVec& X, const FVec& Y)
+    {
+        return VectorSqrt(VectorMultiplyAdd(X, X, VectorMultiply(Y, Y)));
+    }
+
+    // saturate(1 - dot(P, P))^2 (DiscMask() of PostProcessCommon.ush)
+    FORCEINLINE FVec DiscMask(const FVec& X, const FVec& Y)
+    {
+        const FVec Mask = Saturate(VectorSubtract(VectorOneFloat(), VectorMultiplyAdd(X, X, VectorMultiply(Y, Y))));
+        return VectorMultiply(Mask, Mask);
+    }
+
+    // 1 where the UV is within [0, 1], 0 elsewhere
+    FORCEINLINE FVec InsideMask(const FVec& U, const FVec& V)
+    {
+        const FVec Inside = VectorBitwiseAnd(
+            VectorBitwiseAnd(VectorCompareGE(U, VectorZeroFloat()), VectorCompareLE(U, VectorOneFloat())),
+            VectorBitwiseAnd(VectorCompareGE(V, VectorZeroFloat()), VectorCompareLE(V, VectorOneFloat()))
+        );
+
+        return VectorSelect(Inside, VectorOneFloat(), VectorZeroFloat());
+    }
+
+    // UV stretched to a 1:1 aspect ratio around the center
+    FORCEINLINE void GetSquareUV(float AspectRatio, const FVec& U, const FVec& V, FVec& OutU, FVec& OutV)
+    {
+        OutU = U;
+        OutV = V;
+
+        if (AspectRatio > 1.0f)
+        {
+            OutV = VectorMultiplyAdd(VectorSubtract(V, Splat(0.5f)), Splat(1.0f / AspectRatio), Splat(0.5f));
+        }
+        else if (AspectRatio < 1.0f)
+        {
+            OutU = VectorMultiplyAdd(VectorSubtract(U, Splat(0.5f)), Splat(AspectRatio), Splat(0.5f));
+        }
+    }
+
+    // Texel offsets and weights of 4 bilinear fetches. Clamp addressing
+    // matches the viewport clamp of InputUV() (the bilinear footprint never
+    // leaves the image).
+    struct FBilinear4
+    {
+        int32 Offsets[4][4];
+        FVec FracX;
+        FVec FracY;
+    };
+
+    FORCEINLINE int32 AddressTexel(int32 Index, int32 Size, EAddress Address)
+    {
+        if (Address == EAddress::Wrap)
+        {
+            Index %= Size;
+            return Index < 0 ? Index + Size : Index;
+        }
+
+        return FMath::Clamp(Index, 0, Size - 1);
+    }
+
+    FBilinear4 GetBilinear(const FImage& Image, const FVec& U, const FVec& V, EAddress Address)
+    {
+        // Texel space, the center of the first texel is at 0.5. Positions
+        // are kept in a sane range before going to integers.
+        const FVec Limit = Splat(1 << 20);
+        const FVec X = VectorMin(VectorMax(VectorSubtract(VectorMultiply(U, Splat(float(Image.Width))), Splat(0.5f)), VectorNegate(Limit)), Limit);
+        const FVec Y = VectorMin(VectorMax(VectorSubtract(VectorMultiply(V, Splat(float(Image.Height))), Splat(0.5f)), VectorNegate(Limit)), Limit);
+        const FVec X0 = VectorFloor(X);
+        const FVec Y0 = VectorFloor(Y);
+
+        FBilinear4 Bilinear;
+        Bilinear.FracX = VectorSubtract(X, X0);
+        Bilinear.FracY = VectorSubtract(Y, Y0);
+
+        alignas(16) float TexelX[4];
+        alignas(16) float TexelY[4];
+        VectorStoreAligned(X0, TexelX);
+        VectorStoreAligned(Y0, TexelY);
+
+        const int32 Stride = Image.GetStride();
+
+        for (int32 Lane = 0; Lane < 4; Lane++)
+        {
+            const int32 X0Index = AddressTexel(int32(TexelX[Lane]), Image.Width, Address);
+            const int32 X1Index = AddressTexel(int32(TexelX[Lane]) + 1, Image.Width, Address);
+            const int32 Y0Offset = AddressTexel(int32(TexelY[Lane]), Image.Height, Address) * Stride;
+            const int32 Y1Offset = AddressTexel(int32(TexelY[Lane]) + 1, Image.Height, Address) * Stride;
+
+            Bilinear.Offsets[Lane][0] = Y0Offset + X0Index;
+            Bilinear.Offsets[Lane][1] = Y0Offset + X1Index;
+            Bilinear.Offsets[Lane][2] = Y1Offset + X0Index;
+            Bilinear.Offsets[Lane][3] = Y1Offset + X1Index;
+        }
+
+        return Bilinear;
+    }
+
+    // Gathers are scalar, the filtering is not
+    FVec Fetch(const FBilinear4& Bilinear, const float* Plane)
+    {
+        alignas(16) float Texels[4][4];
+
+        for (int32 Lane = 0; Lane < 4; Lane++)
+        {
+            for (int32 Corner = 0; Corner < 4; Corner++)
+            {
+                Texels[Corner][Lane] = Plane[Bilinear.Offsets[Lane][Corner]];
+            }
+        }
+
+        const FVec T00 = VectorLoadAligned(Texels[0]);
+        const FVec T10 = VectorLoadAligned(Texels[1]);
+        const FVec T01 = VectorLoadAligned(Texels[2]);
+        const FVec T11 = VectorLoadAligned(Texels[3]);
+
+        const FVec Top = VectorMultiplyAdd(VectorSubtract(T10, T00), Bilinear.FracX, T00);
+        const FVec Bottom = VectorMultiplyAdd(VectorSubtract(T11, T01), Bilinear.FracX, T01);
+        return VectorMultiplyAdd(VectorSubtract(Bottom, Top), Bilinear.FracY, Top);
+    }
+
+    FORCEINLINE const float* GetPlane(const FImage& Image, int32 Channel)
+    {
+        return Image.GetRow(Channel, 0);
+    }
+
+    FColor4 Sample(const FImage& Image, const FVec& U, const FVec& V, EAddress Address = EAddress::Clamp)
+    {
+        const FBilinear4 Bilinear = GetBilinear(Image, U, V, Address);
+        return { Fetch(Bilinear, GetPlane(Image, 0)), Fetch(Bilinear, GetPlane(Image, 1)), Fetch(Bilinear, GetPlane(Image, 2)) };
+    }
+
+    // Single channel of SampleInputBorder()
+    FVec SampleBorder(const FImage& Image, int32 Channel, const FVec& U, const FVec& V)
+    {
+        const FBilinear4 Bilinear = GetBilinear(Image, U, V, EAddress::Clamp);
+        return VectorMultiply(Fetch(Bilinear, GetPlane(Image, Channel)), InsideMask(U, V));
+    }
+
+    // Optional texture, white when missing like the GWhiteTexture fallback
+    FColor4 SampleOrWhite(const FImage& Image, const FVec& U, const FVec& V, EAddress Address)
+    {
+        if (!Image.IsValid())
+        {
+            return { VectorOneFloat(), VectorOneFloat(), VectorOneFloat() };
+        }
+
+        return Sample(Image, U, V, Address);
+    }
+
+    // Run a full screen pass: Function(U, V) returns the color of 4
+    // pixels at the given viewport UVs. One task per row.
+    template<typename FunctionType>
+    void ForEachPixel(FImage& Output, FunctionType&& Function)
+    {
+        const FVec PixelOffsets = MakeVectorRegisterFloat(0.5f, 1.5f, 2.5f, 3.5f);
+        const FVec InvWidth = Splat(1.0f / float(Output.Width));
+        const float InvHeight = 1.0f / float(Output.Height);
+
+        ParallelFor(Output.Height, [&](int32 Y)
+        {
+            const FVec V = Splat((float(Y) + 0.5f) * InvHeight);
+
+            float* RowR = Output.GetRow(0, Y);
+            float* RowG = Output.GetRow(1, Y);
+            float* RowB = Output.GetRow(2, Y);
+
+            // The stride is padded, the last group writes into the padding
+            for (int32 X = 0; X < Output.Width; X += 4)
+            {
+                const FVec U = VectorMultiply(VectorAdd(Splat(float(X)), PixelOffsets), InvWidth);
+                const FColor4 Color = Function(U, V);
+
+                VectorStoreAligned(Color.R, RowR + X);
+                VectorStoreAligned(Color.G, RowG + X);
+                VectorStoreAligned(Color.B, RowB + X);
+            }
+        });
+    }
+
+    // Angle used to look up the starburst noise (the GPU result is
+    // undefined at the exact center, it is kept finite here)
+    FORCEINLINE FVec GetStarburstU(const FVec& U, const FVec& V)
+    {
+        const FVec DeltaU = VectorSubtract(U, Splat(0.5f));
+        const FVec Distance = VectorMax(Length(DeltaU, VectorSubtract(V, Splat(0.5f))), Splat(1e-6f));
+        const FVec Cosine = VectorMin(VectorMax(VectorDivide(DeltaU, Distance), Splat(-1.0f)), VectorOneFloat());
+        return VectorMultiply(VectorACos(Cosine), Splat(2.0f));
+    }
+
+    // FisheyeUV() of PrettyPostProcess.ush
+    void FisheyeUV(const FVec& U, const FVec& V, float Compression, FVec& OutU, FVec& OutV)
+    {
+        const FVec NegPosU = VectorSubtract(VectorAdd(U, U), VectorOneFloat());
+        const FVec NegPosV = VectorSubtract(VectorAdd(V, V), VectorOneFloat());
+
+        const float Scale = Compression * FMath::Atan(1.0f / Compression);
+        const FVec RadiusDistance = VectorMultiply(Length(NegPosU, NegPosV), Splat(Scale));
+        const FVec RadiusDirection = VectorMultiply(VectorTan(VectorMultiply(RadiusDistance, Splat(1.0f / Compression))), Splat(Compression));
+        const FVec Phi = VectorATan2(NegPosV, NegPosU);
+
+        FVec Sine;
+        FVec Cosine;
+        VectorSinCos(&Sine, &Cosine, &Phi);
+
+        OutU = VectorMultiply(VectorMultiplyAdd(RadiusDirection, Cosine, VectorOneFloat()), Splat(0.5f));
+        OutV = VectorMultiply(VectorMultiplyAdd(RadiusDirection, Sine, VectorOneFloat()), Splat(0.5f));
+    }
+
+    // One quad of a glare sprite, in pixels of the output.
+    // Pixel = Center + AxisU * (UV.x - 0.5) + AxisV * (UV.y - 0.5)
+    struct FGlareQuad
+    {
+        FVector2f Center;
+        FVector2f InverseU; // Pixel offset to quad UV (rows of the inverse matrix)
+        FVector2f InverseV;
+        FVector3f Color;
+        int32 MinX;
+        int32 MinY;
+        int32 MaxX;
+        int32 MaxY;
+    };
+
+    // Average of the pixel block of a tile (SampleGlareTile())
+    FLinearColor SampleGlareTile(const FImage& Input, int32 TileX, int32 TileY, int32 TileSize)
+    {
+        static const FVector2f Coords[5] =
+        {
+            FVector2f(-1.0f, 1.0f),
+            FVector2f(1.0f, 1.0f),
+            FVector2f(0.0f, 0.0f),
+            FVector2f(-1.0f, -1.0f),
+            FVector2f(1.0f, -1.0f)
+        };
+
+        static const float Weights[5] = { 0.175f, 0.175f, 0.3f, 0.175f, 0.175f };
+
+        const FVector2f BufferSize(float(Input.Width), float(Input.Height));
+        const FVector2f PixelSize(1.0f / BufferSize.X, 1.0f / BufferSize.Y);
+        const float TileScale = float(TileSize) * 0.5f;
+
+        const FVector2f UV = FVector2f(float(TileX), float(TileY)) / BufferSize * float(TileSize);
+        const FVector2f CenterUV = UV + PixelSize * (TileScale - 1.5f);
+
+        // The 5 taps in the lanes of a single fetch (the last lane is unused)
+        alignas(16) float TapU[4];
+        alignas(16) float TapV[4];
+        FLinearColor Color = FLinearColor::Black;
+
+        for (int32 First = 0; First < 5; First += 4)
+        {
+            const int32 Count = FMath::Min(5 - First, 4);
+
+            for (int32 Lane = 0; Lane < 4; Lane++)
+            {
+                const FVector2f TapUV = CenterUV + Coords[First + FMath::Min(Lane, Count - 1)] * PixelSize * 1.5f * TileScale;
+                TapU[Lane] = TapUV.X;
+                TapV[Lane] = TapUV.Y;
+            }
+
+            const FColor4 Taps = Sample(Input, VectorLoadAligned(TapU), VectorLoadAligned(TapV));
+
+            for (int32 Lane = 0; Lane < Count; Lane++)
+            {
+                const float Weight = Weights[First + Lane];
+                Color.R += Weight * VectorGetComponentDynamic(Taps.R, Lane);
+                Color.G += Weight * VectorGetComponentDynamic(Taps.G, Lane);
+                Color.B += Weight * VectorGetComponentDynamic(Taps.B, Lane);
+            }
+        }
+
+        return Color;
+    }
+
+    // Quads of the sprites of a row of tiles, in the order the GPU
+    // draws them (GetGlareColor(), GetGlareScale() and GetGlareAngle())
+    void BuildGlareQuads(const FImage& Input, const FSettings& Settings, int32 TileSize, int32 TileY, int32 TileCountX, TArray<FGlareQuad>& OutQuads)
+    {
+        const FVector2f BufferSize(float(Input.Width), float(Input.Height));
+        const FVector2f BufferRatio(BufferSize.Y / BufferSize.X, 1.0f);
+        const float QuadScales[3] = { Settings.GlareScales.X, Settings.GlareScales.Y, Settings.GlareScales.Z };
+        const float AngleBase[3] = { UE_HALF_PI, UE_PI / 6.0f, UE_PI * 5.0f / 6.0f };
+
+        const FVector3f Tint = FVector3f(Settings.GlareTint.R, Settings.GlareTint.G, Settings.GlareTint.B)
+            * Settings.GlareTint.A * (Settings.GlareIntensity / 100.0f);
+
+        for (int32 TileX = 0; TileX < TileCountX; TileX++)
+        {
+            const FLinearColor TileColor = SampleGlareTile(Input, TileX, TileY, TileSize);
+            const float Luminance = TileColor.R + TileColor.G + TileColor.B;
+
+            if (Luminance <= GlareLuminanceThreshold)
+            {
+                continue;
+            }
+
+            const FVector2f PointUV = FVector2f(float(TileX), float(TileY)) / BufferSize * float(TileSize);
+
+            float Mask = 1.0f - FMath::Clamp(FVector2f::Distance(PointUV, FVector2f(0.5f, 0.5f)) * 2.0f, 0.0f, 1.0f);
+            Mask = Mask * 0.6f + 0.4f;
+
+            const FVector2f Scale(
+                FMath::Clamp(Luminance / Settings.GlareDivider, 0.0f, 1.0f) * Mask,
+                4.0f / FMath::Min(BufferSize.X, BufferSize.Y)
+            );
+
+            const float AngleOffset = (PointUV.X * 2.0f - 1.0f) * (UE_PI / 6.0f);
+
+            // Clip space center (ComputePosition()) back to pixels
+            const FVector2f Center = FVector2f(float(TileX), float(TileY)) * float(TileSize) - 0.5f;
+
+            for (int32 QuadIndex = 0; QuadIndex < 3; QuadIndex++)
+            {
+                if (QuadScales[QuadIndex] <= GlareMinQuadScale)
+                {
+                    continue;
+                }
+
+                const FVector2f QuadScale = Scale * QuadScales[QuadIndex];
+
+                float Sine;
+                float Cosine;
+                FMath::SinCos(&Sine, &Cosine, AngleOffset + AngleBase[QuadIndex]);
+
+                // Derivatives of the pixel position along the quad UVs
+                // (clip space Y is up, pixels go down)
+                const FVector2f AxisU(
+                    BufferRatio.X * QuadScale.X * Cosine * BufferSize.X,
+                    -BufferRatio.Y * QuadScale.X * Sine * BufferSize.Y
+                );
+
+                const FVector2f AxisV(
+                    -BufferRatio.X * QuadScale.Y * Sine * BufferSize.X,
+                    -BufferRatio.Y * QuadScale.Y * Cosine * BufferSize.Y
+                );
+
+                const float Determinant = AxisU.X * AxisV.Y - AxisV.X * AxisU.Y;
+
+                if (FMath::Abs(Determinant) < SMALL_NUMBER)
+                {
+                    continue;
+                }
+
+                // Pixels whose center can fall inside the quad
+                const FVector2f Extent = (AxisU.GetAbs() + AxisV.GetAbs()) * 0.5f;
+
+                FGlareQuad Quad;
+                Quad.MinX = FMath::Max(FMath::FloorToInt(Center.X - Extent.X), 0);
+                Quad.MinY = FMath::Max(FMath::FloorToInt(Center.Y - Extent.Y), 0);
+                Quad.MaxX = FMath::Min(FMath::CeilToInt(Center.X + Extent.X), Input.Width - 1);
+                Quad.MaxY = FMath::Min(FMath::CeilToInt(Center.Y + Extent.Y), Input.Height - 1);
+
+                if (Quad.MinX > Quad.MaxX || Quad.MinY > Quad.MaxY)
+                {
+                    continue;
+                }
+
+                Quad.Center = Center;
+                Quad.InverseU = FVector2f(AxisV.Y, -AxisV.X) / Determinant;
+                Quad.InverseV = FVector2f(-AxisU.Y, AxisU.X) / Determinant;
+                Quad.Color = FVector3f(TileColor.R, TileColor.G, TileColor.B) * Tint;
+                OutQuads.Add(Quad);
+            }
+        }
+    }
+
+    // Run a stage of Render(), timed and accounted for when stats are
+    // requested. Fetches are per pixel of the output.
+    template<typename FunctionType>
+    FStageStats* RunStage(FPipelineStats* Stats, FString Name, const FImage& Output, int64 FetchesPerPixel, FunctionType&& Function)
+    {
+        const double StartTime = FPlatformTime::Seconds();
+
+        Function();
+
+        if (Stats == nullptr)
+        {
+            return nullptr;
+        }
+
+        FStageStats& Stage = Stats->Stages.AddDefaulted_GetRef();
+        Stage.Name = MoveTemp(Name);
+        Stage.Milliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        Stage.OutputSize = Output.GetSize();
+        Stage.Pixels = int64(Output.Width) * Output.Height;
+        Stage.Fetches = Stage.Pixels * FetchesPerPixel;
+
+        return &Stage;
+    }
+
+    // Add the quads overlapping a band of rows, pixel centers inside a
+    // quad get the line mask at their quad UV (GlarePS). Returns the
+    // number of pixels covered.
+    int64 RasterizeGlareBand(const TArray<FGlareQuad>& Quads, const TArray<int32>& QuadIndices, const FImage& LineMask, int32 BandMinY, int32 BandMaxY, FImage& Output)
+    {
+        const FVec PixelOffsets = MakeVectorRegisterFloat(0.5f, 1.5f, 2.5f, 3.5f);
+        int64 CoveredPixels = 0;
+
+        for (int32 QuadIndex : QuadIndices)
+        {
+            const FGlareQuad& Quad = Quads[QuadIndex];
+
+            const FVec ColorR = Splat(Quad.Color.X);
+            const FVec ColorG = Splat(Quad.Color.Y);
+            const FVec ColorB = Splat(Quad.Color.Z);
+            const FVec InverseUX = Splat(Quad.InverseU.X);
+            const FVec InverseUY = Splat(Quad.InverseU.Y);
+            const FVec InverseVX = Splat(Quad.InverseV.X);
+            const FVec InverseVY = Splat(Quad.InverseV.Y);
+
+            // Vectors stay aligned to the padded stride
+            const int32 MinX = Quad.MinX & ~3;
+            const int32 MinY = FMath::Max(Quad.MinY, BandMinY);
+            const int32 MaxY = FMath::Min(Quad.MaxY, BandMaxY);
+
+            for (int32 Y = MinY; Y <= MaxY; Y++)
+            {
+                const FVec DeltaY = Splat(float(Y) + 0.5f - Quad.Center.Y);
+
+                float* RowR = Output.GetRow(0, Y);
+                float* RowG = Output.GetRow(1, Y);
+                float* RowB = Output.GetRow(2, Y);
+
+                for (int32 X = MinX; X <= Quad.MaxX; X += 4)
+                {
+                    const FVec DeltaX = VectorSubtract(VectorAdd(Splat(float(X)), PixelOffsets), Splat(Quad.Center.X));
+
+                    const FVec U = VectorAdd(VectorMultiplyAdd(DeltaX, InverseUX, VectorMultiply(DeltaY, InverseUY)), Splat(0.5f));
+                    const FVec V = VectorAdd(VectorMultiplyAdd(DeltaX, InverseVX, VectorMultiply(DeltaY, InverseVY)), Splat(0.5f));
+                    const FVec Inside = InsideMask(U, V);
+
+                    const int32 InsideLanes = VectorMaskBits(VectorCompareGT(Inside, VectorZeroFloat()));
+
+                    if (InsideLanes == 0)
+                    {
+                        continue;
+                    }
+
+                    // Lanes past the width only write into the padding
+                    const int32 ValidLanes = (1 << FMath::Min(Output.Width - X, 4)) - 1;
+                    CoveredPixels += FMath::CountBits(uint64(InsideLanes & ValidLanes));
+
+                    const FColor4 Mask = Multiply(SampleOrWhite(LineMask, U, V, EAddress::Clamp), Inside);
+
+                    VectorStoreAligned(VectorMultiplyAdd(Mask.R, ColorR, VectorLoadAligned(RowR + X)), RowR + X);
+                    VectorStoreAligned(VectorMultiplyAdd(Mask.G, ColorG, VectorLoadAligned(RowG + X)), RowG + X);
+                    VectorStoreAligned(VectorMultiplyAdd(Mask.B, ColorB, VectorLoadAligned(RowB + X)), RowB + X);
+                }
+            }
+        }
+
+        return CoveredPixels;
+    }
+}
+
+//----------------------------------------------------------
+// Image
+//----------------------------------------------------------
+
+FImage::FImage(int32 InWidth, int32 InHeight)
+{
+    Init(InWidth, InHeight);
+}
+
+void FImage::Init(int32 InWidth, int32 InHeight)
+{
+    Width = FMath::Max(InWidth, 0);
+    Height = FMath::Max(InHeight, 0);
+    Stride = Align(Width, 4);
+
+    for (TArray<float, TAlignedHeapAllocator<16>>& Plane : Planes)
+    {
+        Plane.Reset();
+        Plane.SetNumZeroed(Stride * Height);
+    }
+}
+
+FLinearColor FImage::GetPixel(int32 X, int32 Y) const
+{
+    const int32 Index = Y * Stride + X;
+    return FLinearColor(Planes[0][Index], Planes[1][Index], Planes[2][Index], 1.0f);
+}
+
+void FImage::SetPixel(int32 X, int32 Y, const FLinearColor& Color)
+{
+    const int32 Index = Y * Stride + X;
+    Planes[0][Index] = Color.R;
+    Planes[1][Index] = Color.G;
+    Planes[2][Index] = Color.B;
+}
+
+//----------------------------------------------------------
+// Settings
+//----------------------------------------------------------
+
+FSettings FSettings::FromDataAsset(const UPostProcessDataAsset& Asset)
+{
+    FSettings Settings;
+
+    Settings.FlareIntensity = Asset.FlareIntensity;
+    Settings.FlareTint = Asset.FlareTint;
+    Settings.BlurSteps = Asset.BlurSteps;
+
+    Settings.GhostIntensity = Asset.GhostIntensity;
+    Settings.GhostChromaShift = Asset.GhostChromaShift;
+
+    const FLensFlareGhostSettings* Ghosts[] = {
+        &Asset.Ghost1,
+        &Asset.Ghost2,
+        &Asset.Ghost3,
+        &Asset.Ghost4,
+        &Asset.Ghost5,
+        &Asset.Ghost6,
+        &Asset.Ghost7,
+        &Asset.Ghost8
+    };
+
+    // Same packing as FPostProcessSettingsProxy
+    for (const FLensFlareGhostSettings* Ghost : Ghosts)
+    {
+        if (FMath::Abs(Ghost->Color.A * Ghost->Scale) > 0.0001f)
+        {
+            Settings.GhostColors.Add(Ghost->Color);
+            Settings.GhostScales.Add(Ghost->Scale);
+        }
+    }
+
+    Settings.HaloIntensity = Asset.HaloIntensity;
+    Settings.HaloWidth = Asset.HaloWidth;
+    Settings.HaloMask = Asset.HaloMask;
+    Settings.HaloCompression = Asset.HaloCompression;
+    Settings.HaloChromaShift = Asset.HaloChromaShift;
+
+    Settings.StarburstIntensity = Asset.StarburstIntensity;
+
+    Settings.GlareIntensity = Asset.GlareIntensity;
+    Settings.GlareDivider = FMath::Max(Asset.GlareDivider, 0.01f);
+    Settings.GlareScales = FVector3f(Asset.GlareScale);
+    Settings.GlareTint = Asset.GlareTint;
+
+    return Settings;
+}
+
+//----------------------------------------------------------
+// Stages - Bloom
+//----------------------------------------------------------
+
+void Resample(const FImage& Input, FImage& Output)
+{
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        return Sample(Input, U, V);
+    });
+}
+
+void Downsample(const FImage& Input, FImage& Output)
+{
+    static const FVector2f Coords[13] =
+    {
+        FVector2f(-1.0f, 1.0f), FVector2f(1.0f, 1.0f),
+        FVector2f(-1.0f, -1.0f), FVector2f(1.0f, -1.0f),
+
+        FVector2f(-2.0f, 2.0f), FVector2f(0.0f, 2.0f), FVector2f(2.0f, 2.0f),
+        FVector2f(-2.0f, 0.0f), FVector2f(0.0f, 0.0f), FVector2f(2.0f, 0.0f),
+        FVector2f(-2.0f, -2.0f), FVector2f(0.0f, -2.0f), FVector2f(2.0f, -2.0f)
+    };
+
+    static const float Weights[13] =
+    {
+        0.125f, 0.125f,
+        0.125f, 0.125f,
+
+        0.0555555f, 0.0555555f, 0.0555555f,
+        0.0555555f, 0.0555555f, 0.0555555f,
+        0.0555555f, 0.0555555f, 0.0555555f
+    };
+
+    // Half a pixel of the output
+    const FVector2f PixelSize(0.5f / float(Output.Width), 0.5f / float(Output.Height));
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        FColor4 Color = Black4();
+
+        for (int32 i = 0; i < 13; i++)
+        {
+            const FVec TapU = VectorAdd(U, Splat(Coords[i].X * PixelSize.X));
+            const FVec TapV = VectorAdd(V, Splat(Coords[i].Y * PixelSize.Y));
+            MultiplyAdd(Color, Sample(Input, TapU, TapV), Splat(Weights[i]));
+        }
+
+        return Color;
+    });
+}
+
+void UpsampleCombine(const FImage& Current, const FImage& Previous, float Radius, FImage& Output)
+{
+    static const FVector2f Coords[9] =
+    {
+        FVector2f(-1.0f, 1.0f), FVector2f(0.0f, 1.0f), FVector2f(1.0f, 1.0f),
+        FVector2f(-1.0f, 0.0f), FVector2f(0.0f, 0.0f), FVector2f(1.0f, 0.0f),
+        FVector2f(-1.0f, -1.0f), FVector2f(0.0f, -1.0f), FVector2f(1.0f, -1.0f)
+    };
+
+    static const float Weights[9] =
+    {
+        0.0625f, 0.125f, 0.0625f,
+        0.125f, 0.25f, 0.125f,
+        0.0625f, 0.125f, 0.0625f
+    };
+
+    // A pixel of the previous (smaller) level
+    const FVector2f PixelSize(1.0f / float(Previous.Width), 1.0f / float(Previous.Height));
+    const FVec RadiusVector = Splat(Radius);
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        const FColor4 CurrentColor = Sample(Current, U, V);
+        FColor4 PreviousColor = Black4();
+
+        for (int32 i = 0; i < 9; i++)
+        {
+            const FVec TapU = VectorAdd(U, Splat(Coords[i].X * PixelSize.X));
+            const FVec TapV = VectorAdd(V, Splat(Coords[i].Y * PixelSize.Y));
+            MultiplyAdd(PreviousColor, Sample(Previous, TapU, TapV), Splat(Weights[i]));
+        }
+
+        // lerp(Current, Previous, Radius)
+        return FColor4{
+            VectorMultiplyAdd(VectorSubtract(PreviousColor.R, CurrentColor.R), RadiusVector, CurrentColor.R),
+            VectorMultiplyAdd(VectorSubtract(PreviousColor.G, CurrentColor.G), RadiusVector, CurrentColor.G),
+            VectorMultiplyAdd(VectorSubtract(PreviousColor.B, CurrentColor.B), RadiusVector, CurrentColor.B)
+        };
+    });
+}
+
+//----------------------------------------------------------
+// Stages - Flare
+//----------------------------------------------------------
+
+void KawaseBlurDownsample(const FImage& Input, FImage& Output)
+{
+    const FVector2f HalfPixel(0.5f / float(Output.Width), 0.5f / float(Output.Height));
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        FColor4 Color = Multiply(Sample(Input, U, V), Splat(4.0f));
+
+        for (int32 Corner = 0; Corner < 4; Corner++)
+        {
+            const float SignX = (Corner & 1) ? 1.0f : -1.0f;
+            const float SignY = (Corner & 2) ? 1.0f : -1.0f;
+            MultiplyAdd(Color, Sample(Input, VectorAdd(U, Splat(SignX * HalfPixel.X)), VectorAdd(V, Splat(SignY * HalfPixel.Y))), VectorOneFloat());
+        }
+
+        return Multiply(Color, Splat(1.0f / 8.0f));
+    });
+}
+
+void KawaseBlurUpsample(const FImage& Input, FImage& Output)
+{
+    const FVector2f HalfPixel(0.5f / float(Output.Width), 0.5f / float(Output.Height));
+
+    static const FVector2f Axes[4] =
+    {
+        FVector2f(-1.0f, 0.0f),
+        FVector2f(1.0f, 0.0f),
+        FVector2f(0.0f, 1.0f),
+        FVector2f(0.0f, -1.0f)
+    };
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        FColor4 Color = Black4();
+
+        for (int32 Corner = 0; Corner < 4; Corner++)
+        {
+            const float SignX = (Corner & 1) ? 1.0f : -1.0f;
+            const float SignY = (Corner & 2) ? 1.0f : -1.0f;
+            MultiplyAdd(Color, Sample(Input, VectorAdd(U, Splat(SignX * HalfPixel.X)), VectorAdd(V, Splat(SignY * HalfPixel.Y))), VectorOneFloat());
+        }
+
+        for (const FVector2f& Axis : Axes)
+        {
+            MultiplyAdd(Color, Sample(Input, VectorAdd(U, Splat(Axis.X * HalfPixel.X)), VectorAdd(V, Splat(Axis.Y * HalfPixel.Y))), Splat(2.0f));
+        }
+
+        return Multiply(Color, Splat(1.0f / 12.0f));
+    });
+}
+
+void Ghosts(const FImage& Input, const FSettings& Settings, int32 GhostCount, FImage& Output)
+{
+    GhostCount = FMath::Min3(GhostCount, Settings.GhostColors.Num(), Settings.GhostScales.Num());
+
+    const float ChromaShift = Settings.GhostChromaShift;
+    const FVec Intensity = Splat(Settings.GhostIntensity / 100.0f / 10.0f);
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        FColor4 Color = Black4();
+
+        for (int32 i = 0; i < GhostCount; i++)
+        {
+            const FLinearColor& GhostColor = Settings.GhostColors[i];
+            const FVec GhostScale = Splat(Settings.GhostScales[i]);
+
+            const FVec NewU = VectorMultiply(VectorSubtract(U, Splat(0.5f)), GhostScale);
+            const FVec NewV = VectorMultiply(VectorSubtract(V, Splat(0.5f)), GhostScale);
+
+            // Local mask
+            const FVec DistanceMask = VectorSubtract(VectorOneFloat(), Length(NewU, NewV));
+            const FVec Mask = SmoothStep(0.5f, 0.9f, DistanceMask);
+            const FVec Mask2 = VectorMultiplyAdd(SmoothStep(0.75f, 1.0f, DistanceMask), Splat(0.95f), Splat(0.05f));
+            const FVec Masks = VectorMultiply(Mask, Mask2);
+
+            // Chroma offset (no offset without chroma shift)
+            const FVec ScaleR = Splat(1.0f + ChromaShift);
+            const FVec ScaleB = Splat(1.0f - ChromaShift);
+            const FVec Center = Splat(0.5f);
+
+            const FVec R = SampleBorder(Input, 0, VectorMultiplyAdd(NewU, ScaleR, Center), VectorMultiplyAdd(NewV, ScaleR, Center));
+            const FVec G = SampleBorder(Input, 1, VectorAdd(NewU, Center), VectorAdd(NewV, Center));
+            const FVec B = SampleBorder(Input, 2, VectorMultiplyAdd(NewU, ScaleB, Center), VectorMultiplyAdd(NewV, ScaleB, Center));
+
+            Color.R = VectorMultiplyAdd(VectorMultiply(R, Splat(GhostColor.R)), Masks, Color.R);
+            Color.G = VectorMultiplyAdd(VectorMultiply(G, Splat(GhostColor.G)), Masks, Color.G);
+            Color.B = VectorMultiplyAdd(VectorMultiply(B, Splat(GhostColor.B)), Masks, Color.B);
+        }
+
+        // ScreenPos * 0.9
+        const FVec ScreenX = VectorMultiply(VectorSubtract(VectorAdd(U, U), VectorOneFloat()), Splat(0.9f));
+        const FVec ScreenY = VectorMultiply(VectorSubtract(VectorOneFloat(), VectorAdd(V, V)), Splat(0.9f));
+
+        return Multiply(Color, VectorMultiply(DiscMask(ScreenX, ScreenY), Intensity));
+    });
+}
+
+void Starburst(const FImage& Input, const FSettings& Settings, FImage& Output)
+{
+    const FVec Intensity = Splat(Settings.StarburstIntensity);
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        const FVec Inside = InsideMask(U, V);
+        const FColor4 Color = Multiply(Sample(Input, U, V), Inside);
+
+        const FVec Distance = Length(VectorSubtract(U, Splat(0.5f)), VectorSubtract(V, Splat(0.5f)));
+        const FColor4 Noise = SampleOrWhite(Settings.StarburstNoise, GetStarburstU(U, V), VectorZeroFloat(), EAddress::Wrap);
+        const FVec Fade = VectorSubtract(VectorOneFloat(), SmoothStep(0.025f, 0.2f, Distance));
+
+        // Color * (1 - saturate(Noise - Fade) * Intensity)
+        return FColor4{
+            VectorMultiply(Color.R, VectorSubtract(VectorOneFloat(), VectorMultiply(Saturate(VectorSubtract(Noise.R, Fade)), Intensity))),
+            VectorMultiply(Color.G, VectorSubtract(VectorOneFloat(), VectorMultiply(Saturate(VectorSubtract(Noise.G, Fade)), Intensity))),
+            VectorMultiply(Color.B, VectorSubtract(VectorOneFloat(), VectorMultiply(Saturate(VectorSubtract(Noise.B, Fade)), Intensity)))
+        };
+    });
+}
+
+void Halo(const FImage& Input, const FSettings& Settings, FImage& Output)
+{
+    // Without a starburst texture the white fallback cancels the halo
+    if (!Settings.StarburstNoise.IsValid())
+    {
+        Output.Init(Output.Width, Output.Height);
+        return;
+    }
+
+    const float AspectRatio = float(Input.Width) / float(Input.Height);
+    const float ChromaShift = Settings.HaloChromaShift;
+    const FVec HaloMask = Splat(Settings.HaloMask);
+
+    ForEachPixel(Output, [&](const FVec& ScreenU, const FVec& ScreenV)
+    {
+        FVec U;
+        FVec V;
+        GetSquareUV(AspectRatio, ScreenU, ScreenV, U, V);
+
+        FVec FishU;
+        FVec FishV;
+        FisheyeUV(U, V, Settings.HaloCompression, FishU, FishV);
+
+        // Distortion vector (kept finite at the center, like the starburst)
+        const FVec ToCenterU = VectorSubtract(Splat(0.5f), U);
+        const FVec ToCenterV = VectorSubtract(Splat(0.5f), V);
+        const FVec Distance = Length(ToCenterU, ToCenterV);
+        const FVec HaloScale = VectorDivide(Splat(Settings.HaloWidth), VectorMax(Distance, Splat(1e-6f)));
+        const FVec HaloU = VectorMultiply(ToCenterU, HaloScale);
+        const FVec HaloV = VectorMultiply(ToCenterV, HaloScale);
+
+        // Halo and screen border masks
+        const FVec Mask = SmoothStep(HaloMask, 1.0f, Saturate(VectorMultiply(Distance, Splat(2.0f))));
+
+        const FVec ScreenX = VectorSubtract(VectorAdd(ScreenU, ScreenU), VectorOneFloat());
+        const FVec ScreenY = VectorSubtract(VectorOneFloat(), VectorAdd(ScreenV, ScreenV));
+        FVec BorderMask = VectorMultiply(DiscMask(ScreenX, ScreenY), DiscMask(VectorMultiply(ScreenX, Splat(0.8f)), VectorMultiply(ScreenY, Splat(0.8f))));
+        BorderMask = VectorMultiplyAdd(BorderMask, Splat(0.95f), Splat(0.05f));
+
+        const FColor4 Starburst = Sample(Settings.StarburstNoise, GetStarburstU(U, V), VectorZeroFloat(), EAddress::Wrap);
+
+        // Chroma offset around the center
+        const FVec Center = Splat(0.5f);
+        const FVec FishOffsetU = VectorSubtract(FishU, Center);
+        const FVec FishOffsetV = VectorSubtract(FishV, Center);
+        const FVec ScaleR = Splat(1.0f + ChromaShift);
+        const FVec ScaleB = Splat(1.0f - ChromaShift);
+
+        const FColor4 Color{
+            SampleBorder(Input, 0, VectorAdd(VectorMultiplyAdd(FishOffsetU, ScaleR, Center), HaloU), VectorAdd(VectorMultiplyAdd(FishOffsetV, ScaleR, Center), HaloV)),
+            SampleBorder(Input, 1, VectorAdd(FishU, HaloU), VectorAdd(FishV, HaloV)),
+            SampleBorder(Input, 2, VectorAdd(VectorMultiplyAdd(FishOffsetU, ScaleB, Center), HaloU), VectorAdd(VectorMultiplyAdd(FishOffsetV, ScaleB, Center), HaloV))
+        };
+
+        const FVec Scale = VectorMultiply(VectorMultiply(BorderMask, Mask), Splat(Settings.HaloIntensity));
+
+        return FColor4{
+            VectorMultiply(VectorMultiply(Color.R, Scale), VectorSubtract(VectorOneFloat(), Saturate(Starburst.R))),
+            VectorMultiply(VectorMultiply(Color.G, Scale), VectorSubtract(VectorOneFloat(), Saturate(Starburst.G))),
+            VectorMultiply(VectorMultiply(Color.B, Scale), VectorSubtract(VectorOneFloat(), Saturate(Starburst.B)))
+        };
+    });
+}
+
+//----------------------------------------------------------
+// Stages - Glare
+//----------------------------------------------------------
+
+void Glare(const FImage& Input, const FSettings& Settings, int32 TileSize, FImage& Output, FGlareStats* OutStats, int32 BandHeight)
+{
+    Output.Init(Input.Width, Input.Height);
+
+    if (OutStats != nullptr)
+    {
+        *OutStats = FGlareStats();
+    }
+
+    if (Settings.GlareIntensity <= SMALL_NUMBER)
+    {
+        return;
+    }
+
+    TileSize = FMath::Max(TileSize, 1);
+    const FIntPoint TileCount(Input.Width / TileSize, Input.Height / TileSize);
+
+    // Sprites, one task per row of tiles
+    TArray<TArray<FGlareQuad>> RowQuads;
+    RowQuads.SetNum(TileCount.Y);
+
+    ParallelFor(TileCount.Y, [&](int32 TileY)
+    {
+        BuildGlareQuads(Input, Settings, TileSize, TileY, TileCount.X, RowQuads[TileY]);
+    });
+
+    TArray<FGlareQuad> Quads;
+
+    for (TArray<FGlareQuad>& Row : RowQuads)
+    {
+        Quads.Append(MoveTemp(Row));
+    }
+
+    // Bin the quads into bands of rows, quads are added in draw order so
+    // the sums stay deterministic
+    BandHeight = FMath::Max(BandHeight, 1);
+    const int32 BandCount = FMath::DivideAndRoundUp(Output.Height, BandHeight);
+    TArray<TArray<int32>> BandQuads;
+    BandQuads.SetNum(BandCount);
+
+    for (int32 QuadIndex = 0; QuadIndex < Quads.Num(); QuadIndex++)
+    {
+        const FGlareQuad& Quad = Quads[QuadIndex];
+
+        for (int32 Band = Quad.MinY / BandHeight; Band <= Quad.MaxY / BandHeight; Band++)
+        {
+            BandQuads[Band].Add(QuadIndex);
+        }
+    }
+
+    TArray<int64> BandCoveredPixels;
+    BandCoveredPixels.SetNumZeroed(BandCount);
+
+    ParallelFor(BandCount, [&](int32 Band)
+    {
+        const int32 BandMinY = Band * BandHeight;
+        const int32 BandMaxY = FMath::Min(BandMinY + BandHeight, Output.Height) - 1;
+
+        BandCoveredPixels[Band] = RasterizeGlareBand(Quads, BandQuads[Band], Settings.GlareLineMask, BandMinY, BandMaxY, Output);
+    });
+
+    if (OutStats != nullptr)
+    {
+        OutStats->Tiles = TileCount.X * TileCount.Y;
+        OutStats->Quads = Quads.Num();
+
+        for (int64 CoveredPixels : BandCoveredPixels)
+        {
+            OutStats->CoveredPixels += CoveredPixels;
+        }
+    }
+}
+
+//----------------------------------------------------------
+// Stages - Mix
+//----------------------------------------------------------
+
+void Mix(
+    const FImage& Bloom,
+    float BloomIntensity,
+    const FImage& Flare,
+    const FImage& Glare,
+    const FSettings& Settings,
+    FImage& Output
+)
+{
+    const bool bFlares = Flare.IsValid() || Glare.IsValid();
+    const float AspectRatio = float(Output.Width) / float(Output.Height);
+    const FVector2f PixelSize(1.0f / float(Output.Width), 1.0f / float(Output.Height));
+    const FVec FlareScaleR = Splat(Settings.FlareTint.R * Settings.FlareIntensity);
+    const FVec FlareScaleG = Splat(Settings.FlareTint.G * Settings.FlareIntensity);
+    const FVec FlareScaleB = Splat(Settings.FlareTint.B * Settings.FlareIntensity);
+
+    ForEachPixel(Output, [&](const FVec& U, const FVec& V)
+    {
+        FColor4 Color = Black4();
+
+        if (Bloom.IsValid())
+        {
+            Color = Multiply(Sample(Bloom, U, V), Splat(BloomIntensity));
+        }
+
+        if (!bFlares)
+        {
+            return Color;
+        }
+
+        FColor4 Flares = Black4();
+
+        if (Flare.IsValid())
+        {
+            Flares = Sample(Flare, U, V);
+        }
+
+        if (Glare.IsValid())
+        {
+            for (int32 Corner = 0; Corner < 4; Corner++)
+            {
+                const float SignX = (Corner & 1) ? 1.0f : -1.0f;
+                const float SignY = (Corner & 2) ? 1.0f : -1.0f;
+                MultiplyAdd(Flares, Sample(Glare, VectorAdd(U, Splat(SignX * PixelSize.X)), VectorAdd(V, Splat(SignY * PixelSize.Y))), Splat(0.25f));
+            }
+        }
+
+        // Colored gradient
+        FVec SquareU;
+        FVec SquareV;
+        GetSquareUV(AspectRatio, U, V, SquareU, SquareV);
+
+        const FVec GradientU = Saturate(VectorMultiply(Length(VectorSubtract(SquareU, Splat(0.5f)), VectorSubtract(SquareV, Splat(0.5f))), Splat(2.0f)));
+        const FColor4 Gradient = SampleOrWhite(Settings.FlareGradient, GradientU, VectorZeroFloat(), EAddress::Clamp);
+
+        Color.R = VectorMultiplyAdd(VectorMultiply(Flares.R, Gradient.R), FlareScaleR, Color.R);
+        Color.G = VectorMultiplyAdd(VectorMultiply(Flares.G, Gradient.G), FlareScaleG, Color.G);
+        Color.B = VectorMultiplyAdd(VectorMultiply(Flares.B, Gradient.B), FlareScaleB, Color.B);
+
+        return Color;
+    });
+}
+
+//----------------------------------------------------------
+// Pipeline
+//----------------------------------------------------------
+
+int32 GetPassAmount(const FIntPoint& InputSize, const FPipelineOptions& Options)
+{
+    FIntPoint ViewSize = Options.ViewSize.X > 0 && Options.ViewSize.Y > 0 ? Options.ViewSize : InputSize * 2;
+    int32 PassAmount = 1;
+
+    while (PassAmount < Options.BloomPassAmount
+        && ViewSize.X > Options.BloomResLimit && ViewSize.Y > Options.BloomResLimit)
+    {
+        PassAmount++;
+        ViewSize /= 2;
+    }
+
+    return PassAmount;
+}
+
+void Render(
+    const FImage& SceneColor,
+    const FSettings& Settings,
+    const FPipelineOptions& Options,
+    FPipelineOutput& Output,
+    FPipelineStats* OutStats
+)
+{
+    Output = FPipelineOutput();
+    Output.Mix.Init(SceneColor.Width, SceneColor.Height);
+
+    if (OutStats != nullptr)
+    {
+        OutStats->Stages.Reset();
+    }
+
+    if (!SceneColor.IsValid())
+    {
+        return;
+    }
+
+    const int32 PassAmount = GetPassAmount(SceneColor.GetSize(), Options);
+    Output.PassAmount = PassAmount;
+
+    // Same conditions as BuildPassPlan()
+    const bool bFlareVisible = Settings.FlareIntensity > SMALL_NUMBER
+        && !FVector3f(Settings.FlareTint.R, Settings.FlareTint.G, Settings.FlareTint.B).IsNearlyZero();
+
+    const bool bGlareVisible = Settings.GlareIntensity > SMALL_NUMBER
+        && Settings.GlareTint.A > SMALL_NUMBER
+        && Settings.GlareScales.GetMax() > GlareMinQuadScale;
+
+    const int32 GhostCount = Settings.GhostIntensity > SMALL_NUMBER
+        ? FMath::Min(Settings.GhostColors.Num(), Options.MaxGhostCount)
+        : 0;
+
+    // The flare and glare read the downsamples, there are none with a
+    // single pass
+    const bool bRenderFlare = Options.bRenderFlare && bFlareVisible && GhostCount > 0
+        && Options.FlareMip < PassAmount && PassAmount > 1;
+
+    const bool bRenderHalo = Options.bRenderHalo && Settings.HaloIntensity > SMALL_NUMBER && PassAmount > 2;
+
+    const bool bRenderGlare = Options.bRenderGlare && bFlareVisible && bGlareVisible
+        && Options.FlareMip + 1 < PassAmount;
+
+    //--------------------------------
+    // Bloom downsample
+    //--------------------------------
+    // Level 0 is the scene color itself
+    TArray<FImage> Downsamples;
+    Downsamples.SetNum(PassAmount);
+
+    TArray<const FImage*> Levels;
+    Levels.Add(&SceneColor);
+
+    for (int32 i = 1; i < PassAmount; i++)
+    {
+        const FIntPoint Size = FIntPoint::DivideAndRoundUp(Levels[i - 1]->GetSize(), 2);
+        Downsamples[i].Init(Size.X, Size.Y);
+
+        RunStage(OutStats, FString::Printf(TEXT("Downsample_%d"), i), Downsamples[i], 13, [&]()
+        {
+            Downsample(*Levels[i - 1], Downsamples[i]);
+        });
+
+        Levels.Add(&Downsamples[i]);
+    }
+
+    //--------------------------------
+    // Flare
+    //--------------------------------
+    if (bRenderFlare)
+    {
+        const FImage& FlareInput = *Levels[Options.FlareMip];
+
+        FImage Flare(FlareInput.Width, FlareInput.Height);
+
+        // One fetch per channel and ghost
+        RunStage(OutStats, TEXT("Ghosts"), Flare, 3 * GhostCount, [&]()
+        {
+            Ghosts(FlareInput, Settings, GhostCount, Flare);
+        });
+
+        // Dual Kawase, down then back up to the flare level
+        const int32 BlurSteps = FMath::Min(Settings.BlurSteps, Options.MaxBlurSteps);
+        int32 Divider = 2;
+
+        for (int32 i = 0; i < BlurSteps * 2; i++)
+        {
+            const FIntPoint Size = FIntPoint::DivideAndRoundUp(FlareInput.GetSize(), Divider);
+            FImage Blurred(Size.X, Size.Y);
+
+            if (i < BlurSteps)
+            {
+                RunStage(OutStats, FString::Printf(TEXT("KawaseBlurDownsample_%d"), i), Blurred, 5, [&]()
+                {
+                    KawaseBlurDownsample(Flare, Blurred);
+                });
+            }
+            else
+            {
+                RunStage(OutStats, FString::Printf(TEXT("KawaseBlurUpsample_%d"), i), Blurred, 8, [&]()
+                {
+                    KawaseBlurUpsample(Flare, Blurred);
+                });
+            }
+
+            Flare = MoveTemp(Blurred);
+            Divider = i < BlurSteps - 1 ? Divider * 2 : Divider / 2;
+        }
+
+        if (Settings.StarburstIntensity > SMALL_NUMBER)
+        {
+            FImage Filtered(Flare.Width, Flare.Height);
+
+            RunStage(OutStats, TEXT("Starburst"), Filtered, Settings.StarburstNoise.IsValid() ? 2 : 1, [&]()
+            {
+                Starburst(Flare, Settings, Filtered);
+            });
+
+            Flare = MoveTemp(Filtered);
+        }
+
+        Output.Flare = MoveTemp(Flare);
+    }
+
+    //--------------------------------
+    // Glare
+    //--------------------------------
+    if (bRenderGlare)
+    {
+        FGlareStats GlareStats;
+
+        FStageStats* Stage = RunStage(OutStats, TEXT("Glare"), Output.Glare, 0, [&]()
+        {
+            Glare(*Levels[Options.FlareMip + 1], Settings, Options.GlareTileSize, Output.Glare, &GlareStats);
+        });
+
+        // 5 taps per tile, then the line mask under the quads
+        if (Stage != nullptr)
+        {
+            Stage->Pixels = GlareStats.CoveredPixels;
+            Stage->Fetches = int64(GlareStats.Tiles) * 5 + GlareStats.CoveredPixels;
+            Stage->Primitives = GlareStats.Quads;
+        }
+    }
+
+    //--------------------------------
+    // Bloom upsample
+    //--------------------------------
+    if (PassAmount > 1)
+    {
+        // Smallest level first, the halo replaces the second level
+        FImage Previous = *Levels[PassAmount - 1];
+
+        for (int32 i = PassAmount - 2; i >= 0; i--)
+        {
+            const FImage* Current = Levels[i];
+            FImage HaloImage;
+
+            if (i == 1 && bRenderHalo)
+            {
+                HaloImage.Init(Current->Width, Current->Height);
+
+                RunStage(OutStats, TEXT("Halo"), HaloImage, Settings.StarburstNoise.IsValid() ? 4 : 0, [&]()
+                {
+                    Halo(*Current, Settings, HaloImage);
+                });
+
+                Current = &HaloImage;
+            }
+
+            FImage Combined(Current->Width, Current->Height);
+
+            // Current, then the 9 taps tent
+            RunStage(OutStats, FString::Printf(TEXT("Upsample_%d"), i), Combined, 10, [&]()
+            {
+                UpsampleCombine(*Current, Previous, Options.BloomRadius, Combined);
+            });
+
+            Previous = MoveTemp(Combined);
+        }
+
+        Output.Bloom = MoveTemp(Previous);
+    }
+
+    //--------------------------------
+    // Mix
+    //--------------------------------
+    const bool bMixFlares = Output.Flare.IsValid() || Output.Glare.IsValid();
+
+    const int32 MixFetches = (Output.Bloom.IsValid() ? 1 : 0)
+        + (Output.Flare.IsValid() ? 1 : 0)
+        + (Output.Glare.IsValid() ? 4 : 0)
+        + (bMixFlares && Settings.FlareGradient.IsValid() ? 1 : 0);
+
+    RunStage(OutStats, TEXT("Mix"), Output.Mix, MixFetches, [&]()
+    {
+        Mix(Output.Bloom, 1.0f / float(PassAmount), Output.Flare, Output.Glare, Settings, Output.Mix);
+    });
+}
+}
@@ -0,0 +1,161 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "PrettyPostProcessCPU.h"
+#include "PostProcessDataAsset.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    using namespace PrettyPostProcessCPU;
+
+    // Small enough to run in no time, large enough for a few bloom levels
+    // and several glare bands
+    const FIntPoint InputSize(64, 48);
+
+    // Largest channel value of an image, and whether all of them are finite
+    float GetMaxValue(const FImage& Image, bool& bOutFinite)
+    {
+        float MaxValue = 0.0f;
+        bOutFinite = true;
+
+        for (int32 Channel = 0; Channel < 3; Channel++)
+        {
+            for (int32 y = 0; y < Image.Height; y++)
+            {
+                const float* Row = Image.GetRow(Channel, y);
+
+                for (int32 x = 0; x < Image.Width; x++)
+                {
+                    bOutFinite &= FMath::IsFinite(Row[x]);
+                    MaxValue = FMath::Max(MaxValue, FMath::Abs(Row[x]));
+                }
+            }
+        }
+
+        return MaxValue;
+    }
+
+    int32 CountDifferentPixels(const FImage& A, const FImage& B)
+    {
+        int32 Count = 0;
+
+        for (int32 y = 0; y < A.Height; y++)
+        {
+            for (int32 x = 0; x < A.Width; x++)
+            {
+                Count += A.GetPixel(x, y) != B.GetPixel(x, y);
+            }
+        }
+
+        return Count;
+    }
+}
+
+// Render() of the CPU implementation on a black input and on a single
+// bright pixel, with the default settings (see PrettyPostProcessCPU.h)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FPrettyPostProcessCPURenderTest,
+    "PrettyPostProcess.CPU.Render",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FPrettyPostProcessCPURenderTest::RunTest(const FString& Parameters)
+{
+    const FSettings Settings = FSettings::FromDataAsset(*GetDefault<UPostProcessDataAsset>());
+    const FPipelineOptions Options;
+
+    // Nothing comes out of a black input
+    {
+        const FImage Black(InputSize.X, InputSize.Y);
+
+        FPipelineOutput Output;
+        Render(Black, Settings, Options, Output);
+
+        bool bFinite = false;
+        TestEqual(TEXT("Black: mix size"), Output.Mix.GetSize(), InputSize);
+        TestEqual(TEXT("Black: largest mix value"), GetMaxValue(Output.Mix, bFinite), 0.0f);
+        TestTrue(TEXT("Black: finite"), bFinite);
+    }
+
+    // A single bright pixel spreads into a bloom around it, and into a
+    // flare elsewhere
+    {
+        const FIntPoint Bright(44, 12);
+
+        FImage Input(InputSize.X, InputSize.Y);
+        Input.SetPixel(Bright.X, Bright.Y, FLinearColor(100.0f, 100.0f, 100.0f));
+
+        FPipelineOutput Output;
+        Render(Input, Settings, Options, Output);
+
+        bool bFinite = false;
+        TestTrue(TEXT("Bright: largest mix value"), GetMaxValue(Output.Mix, bFinite) > 0.0f);
+        TestTrue(TEXT("Bright: finite"), bFinite);
+        TestTrue(TEXT("Bright: several bloom levels"), Output.PassAmount > 2);
+
+        if (TestTrue(TEXT("Bright: bloom"), Output.Bloom.IsValid()))
+        {
+            // The bloom comes out at the size of the input
+            const FIntPoint BloomPixel = Bright * Output.Bloom.GetSize() / InputSize;
+            const FLinearColor Center = Output.Bloom.GetPixel(BloomPixel.X, BloomPixel.Y);
+            const FLinearColor Near = Output.Bloom.GetPixel(BloomPixel.X - 3, BloomPixel.Y + 3);
+
+            TestTrue(TEXT("Bright: bloom around the pixel"), Near.R > 0.0f);
+            TestTrue(TEXT("Bright: bloom fades with the distance"), Center.R > Near.R);
+        }
+
+        if (TestTrue(TEXT("Bright: flare"), Output.Flare.IsValid()))
+        {
+            bool bFlareFinite = false;
+            TestTrue(TEXT("Bright: flare ghosts"), GetMaxValue(Output.Flare, bFlareFinite) > 0.0f);
+            TestTrue(TEXT("Bright: flare finite"), bFlareFinite);
+        }
+    }
+
+    return true;
+}
+
+// The glare rasterized in bands of rows (one task each) matches a single
+// band run, bit for bit
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+    FPrettyPostProcessCPUGlareBandsTest,
+    "PrettyPostProcess.CPU.GlareBands",
+    EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter
+)
+
+bool FPrettyPostProcessCPUGlareBandsTest::RunTest(const FString& Parameters)
+{
+    FSettings Settings = FSettings::FromDataAsset(*GetDefault<UPostProcessDataAsset>());
+    Settings.GlareIntensity = FMath::Max(Settings.GlareIntensity, 0.02f);
+
+    // Bright pixels scattered over the whole input, with quads crossing
+    // band boundaries
+    FImage Input(InputSize.X, InputSize.Y);
+    FRandomStream Random(1234);
+
+    for (int32 i = 0; i < 64; i++)
+    {
+        const float Value = Random.FRandRange(1.0f, 50.0f);
+        Input.SetPixel(Random.RandHelper(InputSize.X), Random.RandHelper(InputSize.Y), FLinearColor(Value, Value * 0.5f, Value * 0.25f));
+    }
+
+    FImage Banded;
+    FGlareStats BandedStats;
+    Glare(Input, Settings, 2, Banded, &BandedStats);
+
+    FImage SingleBand;
+    FGlareStats SingleBandStats;
+    Glare(Input, Settings, 2, SingleBand, &SingleBandStats, InputSize.Y);
+
+    TestTrue(TEXT("Several bands"), InputSize.Y > GlareBandHeight);
+    TestTrue(TEXT("Quads drawn"), BandedStats.Quads > 0);
+    TestEqual(TEXT("Quads"), BandedStats.Quads, SingleBandStats.Quads);
+    TestEqual(TEXT("Covered pixels"), BandedStats.CoveredPixels, SingleBandStats.CoveredPixels);
+    TestEqual(TEXT("Pixels that differ"), CountDifferentPixels(Banded, SingleBand), 0);
+
+    return true;
+}
+
+#endif
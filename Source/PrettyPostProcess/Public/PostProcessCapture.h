@@ -0,0 +1,146 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16.h"
+#include "PostProcessSubsystem.h"
+#include "PrettyPostProcessCPU.h"
+
+class FJsonObject;
+class IMappedFileHandle;
+class IMappedFileRegion;
+class UPostProcessDataAsset;
+
+// Inputs of a single UPostProcessSubsystem::Render() call, saved by
+// r.PrettyPostProcess.Capture so that a view from the field can be run
+// again (CPU implementation, benchmark commandlet) with any version of
+// the plugin, without the game.
+//
+// File layout, little endian:
+//  - FHeader
+//  - Metadata: UTF-8 JSON (view layout, quality, console variables and
+//    the data asset properties)
+//  - Pixels: the view rect of the half resolution scene color as three
+//    FP16 planes (R, G, B), rows top to bottom, each plane starting on a
+//    PixelAlignment boundary so the file can be memory mapped as is.
+class PRETTYPOSTPROCESS_API FPostProcessCapture
+{
+public:
+    // "PPPC"
+    static constexpr uint32 Magic = 0x43505050;
+
+    // Bumped when the layout of the file or of its metadata changes.
+    // Older versions are still read, newer ones are rejected.
+    static constexpr uint32 Version = 1;
+
+    static constexpr uint64 PixelAlignment = 64;
+
+    static constexpr const TCHAR* Extension = TEXT("pppcapture");
+
+    struct FHeader
+    {
+        uint32 Magic = 0;
+        uint32 Version = 0;
+
+        // Size of the captured region (the scene color view rect)
+        int32 Width = 0;
+        int32 Height = 0;
+
+        // In bytes, from the start of the file
+        uint64 MetadataOffset = 0;
+        uint64 MetadataSize = 0;
+        uint64 PixelOffset = 0;
+
+        // Bytes from a plane to the next one
+        uint64 PlaneStride = 0;
+    };
+
+    FPostProcessCapture();
+    ~FPostProcessCapture();
+
+    //------------------------------------
+    // View
+    //------------------------------------
+    // Scene color layout handed over by the engine (half resolution)
+    FIntPoint Extent = FIntPoint::ZeroValue;
+    FIntRect ViewRect;
+
+    // Size of the full resolution view
+    FIntPoint ViewSize = FIntPoint::ZeroValue;
+
+    // Pipeline policy of the view, and quality preset after the budget governor
+    EPostProcessViewQuality Quality = EPostProcessViewQuality::Full;
+    FPostProcessQualityPreset Preset;
+
+    // Mobile feature level (ES3.1)
+    bool bMobile = false;
+
+    //------------------------------------
+    // Settings
+    //------------------------------------
+    // Every r.PrettyPostProcess.* console variable, by name
+    TMap<FString, FString> ConsoleVariables;
+
+    // Path and properties of the data asset (FJsonObjectConverter)
+    FString DataAssetPath;
+    TSharedPtr<FJsonObject> DataAsset;
+
+    // Versions the capture was made with
+    FString PluginVersion;
+    FString EngineVersion;
+
+    // Snapshot the console variables, data asset and versions (game thread)
+    void CaptureSettings(const UPostProcessDataAsset& Asset);
+
+    //------------------------------------
+    // Pixels
+    //------------------------------------
+    FIntPoint GetSize() const { return Size; }
+
+    // Allocate black planes, to be written when capturing
+    void InitPixels(const FIntPoint& InSize);
+
+    // Row Y of a plane (0 = R, 1 = G, 2 = B), Width pixels
+    const FFloat16* GetRow(int32 Channel, int32 Y) const;
+    FFloat16* GetRowForWrite(int32 Channel, int32 Y);
+
+    //------------------------------------
+    // File
+    //------------------------------------
+    bool Save(const FString& Filename) const;
+
+    // The pixels are memory mapped when the platform allows it, read otherwise
+    static TUniquePtr<FPostProcessCapture> Load(const FString& Filename);
+
+    //------------------------------------
+    // Replay
+    //------------------------------------
+    // The captured region as a CPU image
+    void GetSceneColor(PrettyPostProcessCPU::FImage& OutImage) const;
+
+    // A transient data asset with the captured properties (game thread).
+    // Textures are only found when they still exist in the project.
+    UPostProcessDataAsset* CreateDataAsset() const;
+
+    // Console variables and quality preset as Render() saw them, with the
+    // stages the view quality drops turned off
+    PrettyPostProcessCPU::FPipelineOptions GetPipelineOptions() const;
+
+    // Value of a captured console variable, the fallback when missing
+    int32 GetConsoleVariable(const TCHAR* Name, int32 Fallback) const;
+    float GetConsoleVariable(const TCHAR* Name, float Fallback) const;
+
+private:
+    FIntPoint Size = FIntPoint::ZeroValue;
+
+    // Owned planes, or the mapped region of the file they are read from
+    TArray64<FFloat16> Pixels;
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+    const FFloat16* MappedPixels = nullptr;
+    uint64 MappedPlaneStride = 0;
+
+    FString WriteMetadata() const;
+    bool ReadMetadata(const FString& Json);
+};
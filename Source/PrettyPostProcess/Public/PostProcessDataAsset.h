@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
+#include "UObject/SoftObjectPtr.h"
 #include "PostProcessDataAsset.generated.h"
 
 // This custom struct is used to more easily
@@ -40,11 +41,11 @@ public:
 
     /** 1D circular gradient of the overall flare effect */
     UPROPERTY(EditAnywhere, Category = "Flare")
-	TObjectPtr<class UTexture2D> FlareGradient = nullptr;
+	TSoftObjectPtr<class UTexture2D> FlareGradient;
 
 	/** Circular starburst noise for the overall flare effect */
 	UPROPERTY(EditAnywhere, Category = "Flare")
-	TObjectPtr<class UTexture2D> StarburstNoise = nullptr;
+	TSoftObjectPtr<class UTexture2D> StarburstNoise;
 
     /** Blur steps for the ghosts */
     UPROPERTY(EditAnywhere, Category = "Ghosts", meta = (ClampMin = "0", ClampMax = "8", UIMin = "0", UIMax = "8"))
@@ -138,5 +139,17 @@ public:
     FLinearColor GlareTint = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
     UPROPERTY(EditAnywhere, Category = "Glare")
-    TObjectPtr<class UTexture2D> GlareLineMask = nullptr;
+    TSoftObjectPtr<class UTexture2D> GlareLineMask;
+
+    // Textures are soft references, loaded by the subsystem through the
+    // streamable manager. Gathers the ones that are set.
+    void GetTexturePaths(TArray<FSoftObjectPath>& OutPaths) const;
+
+    // Bumped every time a setting is edited, so the render
+    // thread knows when its cached pass plans are stale.
+    uint32 Revision = 0;
+
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
 };
@@ -6,12 +6,264 @@
 #include "Subsystems/EngineSubsystem.h"
 #include "PostProcess/PostProcessing.h" // For PostProcess delegate
 #include "PostProcess/PostProcessBloomSetup.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/TaskGraphFwd.h"
+#include "Engine/StreamableManager.h"
 #include "PostProcessSubsystem.generated.h"
 
 DECLARE_MULTICAST_DELEGATE_FourParams(FPP_CustomBloomFlare, FRDGBuilder&, const FViewInfo&, const FScreenPassTexture&, FScreenPassTexture&);
 extern RENDERER_API FPP_CustomBloomFlare PP_CustomBloomFlare;
 
 class UPostProcessDataAsset;
+class FPostProcessAutoSkip;
+class FPostProcessBudgetGovernor;
+class FPostProcessCaptureRecorder;
+class FPostProcessFootprint;
+class FPostProcessSettingsProxy;
+class FPostProcessStaticCache;
+class FPostProcessStructure;
+
+// How much of the pipeline a given view is allowed to render
+enum class EPostProcessViewQuality : uint8
+{
+    // Nothing is rendered, the view gets no bloom from the plugin
+    Skip,
+    // Bloom only, no flare, halo or glare
+    BloomOnly,
+    // Fewer bloom passes, flare with a single blur step, no halo or glare
+    Reduced,
+    // Everything
+    Full
+};
+
+// Pipeline budget of a scalability tier, picked from
+// r.PrettyPostProcess.Quality (or sg.PostProcessQuality).
+struct FPostProcessQualityPreset
+{
+    // Maximum number of bloom passes
+    int32 BloomPassAmount = 7;
+
+    // Maximum number of flare blur steps (caps the data asset value)
+    int32 BlurSteps = 8;
+
+    // Maximum number of ghosts rendered (the first active ones are kept)
+    int32 GhostCount = 8;
+
+    // Size in pixels of the block covered by a single glare sprite
+    int32 GlareTileSize = 2;
+
+    // Bloom mip feeding the flare, the glare reads the next one
+    int32 FlareMip = 0;
+
+    // Use FP16 instead of R11G11B10 for the intermediate buffers
+    bool bHighPrecision = false;
+
+    bool operator==(const FPostProcessQualityPreset& Other) const
+    {
+        return BloomPassAmount == Other.BloomPassAmount
+            && BlurSteps == Other.BlurSteps
+            && GhostCount == Other.GhostCount
+            && GlareTileSize == Other.GlareTileSize
+            && FlareMip == Other.FlareMip
+            && bHighPrecision == Other.bHighPrecision;
+    }
+
+    // Preset of a quality level (clamped), indexed like sg.PostProcessQuality
+    static const FPostProcessQualityPreset& Get(int32 Quality);
+};
+
+// Everything a pass plan is derived from. A cached plan
+// is reused as long as its key matches the current one.
+struct FPostProcessPassPlanKey
+{
+    // Scene color layout
+    FIntPoint Extent = FIntPoint::ZeroValue;
+    FIntRect ViewRect;
+
+    // Size of the (full resolution) view
+    FIntPoint ViewSize = FIntPoint::ZeroValue;
+
+    EPostProcessViewQuality Quality = EPostProcessViewQuality::Full;
+    FPostProcessQualityPreset Preset;
+
+    // Console variables
+    int32 BloomPassAmount = 0;
+    int32 BloomResLimit = 0;
+    bool bRenderFlare = false;
+    bool bRenderHalo = false;
+    bool bRenderGlare = false;
+
+    // UPostProcessDataAsset::Revision
+    uint32 AssetRevision = 0;
+
+    bool operator==(const FPostProcessPassPlanKey& Other) const
+    {
+        return Extent == Other.Extent
+            && ViewRect == Other.ViewRect
+            && ViewSize == Other.ViewSize
+            && Quality == Other.Quality
+            && Preset == Other.Preset
+            && BloomPassAmount == Other.BloomPassAmount
+            && BloomResLimit == Other.BloomResLimit
+            && bRenderFlare == Other.bRenderFlare
+            && bRenderHalo == Other.bRenderHalo
+            && bRenderGlare == Other.bRenderGlare
+            && AssetRevision == Other.AssetRevision;
+    }
+};
+
+// What Render() has to record for a view: level sizes, active stages and
+// blur layout. It only changes when the view is resized or a
+// setting is edited, so it is built once and cached per view instead of
+// being recomputed (and reallocated) every frame.
+struct FPostProcessPassPlan
+{
+    FPostProcessPassPlanKey Key;
+
+    // Number of bloom levels, the first one being the scene color itself
+    int32 PassAmount = 1;
+
+    // Layout of each bloom level
+    TArray<FScreenPassTextureViewport, TInlineAllocator<8>> BloomViewports;
+
+    // Layout of each flare blur pass (down passes first, then up passes)
+    int32 BlurSteps = 0;
+    TArray<FScreenPassTextureViewport, TInlineAllocator<16>> BlurViewports;
+
+    // Stages that end up contributing to the image. A stage whose settings
+    // make it invisible (zero intensity, no visible ghost...) is not
+    // recorded at all.
+    bool bRenderFlare = false;
+    bool bRenderStarburst = false;
+    bool bRenderHalo = false;
+    bool bRenderGlare = false;
+
+    // Number of ghosts rendered (the visible ones are packed at the
+    // front of the settings uniform buffer)
+    int32 GhostCount = 0;
+
+    // Shader permutations picked from the settings
+    int32 GhostPermutation = 1;
+    bool bGhostChromaShift = true;
+    bool bHaloChromaShift = true;
+    bool bStarburstTexture = true;
+
+    // Last frame the plan was used, stale plans get evicted
+    uint64 LastUsedFrame = 0;
+};
+
+// Tile of a larger frame being rendered (see BeginTiledRender)
+struct FPostProcessTile
+{
+    // Whole frame, and rect of the tile in it (overlap included), in output pixels
+    FIntPoint FrameSize = FIntPoint::ZeroValue;
+    FIntRect Rect;
+
+    // The next views are the prepass of the whole frame (SetRenderFrame)
+    bool bFrame = false;
+
+    // Incremented by every SetRenderFrame
+    uint32 FrameIndex = 0;
+};
+
+// Whole frame state of a tiled render, kept across its tiles and frames
+struct FPostProcessTiledFrame
+{
+    // Bloom level the tiles stop at, and size of the whole frame at that level
+    int32 Level = 0;
+    FIntPoint AtlasSize = FIntPoint::ZeroValue;
+
+    // Low frequency stages of the current output frame, computed from its
+    // prepass before its first tile and sampled by its tiles
+    TRefCountPtr<IPooledRenderTarget> Bloom;
+    TRefCountPtr<IPooledRenderTarget> Flare;
+    TRefCountPtr<IPooledRenderTarget> Glare;
+    FIntRect BloomRect;
+    FIntRect FlareRect;
+    FIntRect GlareRect;
+
+    // Output frame the low frequency stages were computed for
+    uint32 FrameIndex = MAX_uint32;
+};
+
+// What a view recorded, published to the stats, the CSV profiler and
+// the Insights counters (see "stat PrettyPostProcess")
+struct FPostProcessViewCounters
+{
+    int32 Passes = 0;
+
+    // Transient textures created by the plugin
+    uint64 TextureBytes = 0;
+
+    int32 Ghosts = 0;
+
+    // Glare sprites submitted, one per tile (the dark ones are
+    // dropped on the GPU)
+    int32 GlareSprites = 0;
+};
+
+// Per-call render state. Everything that is produced while recording the
+// graph of a single view lives here instead of in the subsystem, so that
+// several views can go through Render() at the same time.
+struct FPostProcessRenderContext
+{
+    TArray<FScreenPassTexture, TInlineAllocator<8>> MipMapsDownsample;
+    TArray<FScreenPassTexture, TInlineAllocator<8>> MipMapsUpsample;
+
+    // Downsampled texture to be fed by flare
+    FScreenPassTexture DownsampleTextureFlare;
+
+    // Downsampled texture to be fed by glare
+    FScreenPassTexture DownsampleTextureGlare;
+
+    // Build the tile max map of the flare input for this view
+    bool bTileMax = false;
+
+    // Max luminance per tile of the flare input (null until built)
+    // and the scale from a viewport UV to its tile coordinates
+    FRDGTextureRef TileMaxTexture = nullptr;
+    FVector2f TileMaxScale = FVector2f::ZeroVector;
+
+    // Tiled render: bloom level the tile stops at (0 when not tiled), from
+    // where the low frequency bloom of the whole frame takes over. The
+    // whole frame textures are read over TileUVRect (min, max).
+    int32 TiledLevel = 0;
+    FScreenPassTexture TiledBloom;
+    FVector4f TileUVRect = FVector4f(0.0f, 0.0f, 1.0f, 1.0f);
+
+    // Run the flare and glare compute variants on the async compute queue
+    bool bAsyncCompute = false;
+
+    // Mobile feature level (ES3.1): R11G11B10 targets everywhere and the
+    // glare drawn without geometry shader
+    bool bMobile = false;
+
+    // What the RHI supports of R11G11B10 (see GetIntermediateFormat and
+    // GetComputeFormat), read once per view so a plan can also be
+    // described for another RHI
+    bool bR11G11B10RenderTarget = true;
+    bool bR11G11B10TypedUAVStore = true;
+
+    // Pipeline policy picked for this view
+    EPostProcessViewQuality Quality = EPostProcessViewQuality::Full;
+
+    // Scalability budget for this frame
+    FPostProcessQualityPreset Preset;
+
+    // Cached layout and stages of this view
+    FPostProcessPassPlan Plan;
+
+    // Data asset settings, kept alive by Render() for the call
+    const FPostProcessSettingsProxy* Settings = nullptr;
+
+    // Texture lifetimes being captured (r.PrettyPostProcess.DumpFootprint)
+    FPostProcessFootprint* Footprint = nullptr;
+
+    // Counters of the view, filled while recording
+    FPostProcessViewCounters* Counters = nullptr;
+};
+
 /**
  * 
  */
@@ -25,11 +277,84 @@ public:
 
     virtual void Deinitialize() override;
 
-private:
-	TObjectPtr<UTexture2D> StarburstNoise;
-	TObjectPtr<UTexture2D> FlareGradient;
-	TObjectPtr<UTexture2D> GlareLineMask;
+    // Compile every pipeline the plugin can use ahead of its first use, to
+    // avoid hitches the first time a flare or glare shows up. Meant to be
+    // called during a loading screen. Asynchronous when PSO precaching is
+    // enabled, blocking the render thread otherwise.
+    UFUNCTION(BlueprintCallable, Category = "Pretty Post Process")
+    void WarmUpPipelines();
+
+    // Whether a warm-up of the plugin (WarmUpPipelines, or the startup one
+    // of r.PrettyPostProcess.PrecachePipelines) is queued or still compiling
+    UFUNCTION(BlueprintPure, Category = "Pretty Post Process")
+    bool IsWarmingUp() const;
+
+    // Log the transient textures of every view rendered next frame, with
+    // their lifetime and the peak memory they add up to.
+    void DumpFootprint();
+
+    // Save the inputs of the next main view (half resolution scene color,
+    // view layout, console variables and data asset) to a capture file,
+    // to be replayed without the game (see FPostProcessCapture). Saved
+    // under Saved/PrettyPostProcess/Captures when Filename is empty.
+    void Capture(const FString& Filename = FString());
 
+    // Tiled high resolution rendering (Movie Render Queue tiling, see
+    // UMoviePipelinePrettyPostProcessPass). Until EndTiledRender, the main
+    // views are tiles of a FrameSize frame: bloom, flare, halo and glare
+    // come out as if the frame was rendered in one piece, without seams,
+    // while the memory used only depends on the tile size.
+    void BeginTiledRender(FIntPoint FrameSize);
+    void EndTiledRender();
+
+    // Start an output frame: the next main view is a prepass of the whole
+    // frame, at any resolution, whose output is discarded. The low
+    // frequency stages of the frame are computed from it, before its
+    // first tile.
+    void SetRenderFrame();
+
+    // Rect of the tile the next views render, in frame pixels with the
+    // overlap included
+    void SetRenderTile(const FIntRect& TileRect);
+
+    // Level sizes, active stages and blur layout of a view (what
+    // GetPassPlan caches). Only reads the settings, any thread.
+    static void BuildPassPlan(
+        const FPostProcessSettingsProxy& Settings,
+        const FPostProcessPassPlanKey& Key,
+        FPostProcessPassPlan& Plan
+    );
+
+    // Passes and textures Render() records for a view that isn't a tile,
+    // from its context (plan, preset, flags) alone: no GPU involved, so
+    // the structure check runs with -nullrhi. Uses the same formats and
+    // layouts as the render functions.
+    static void DescribePassPlan(
+        const FPostProcessRenderContext& Context,
+        FPostProcessStructure& Structure
+    );
+
+    // Hand the passes and textures every view records (as reported to
+    // the footprint) to Callback, along with its plan, its context and
+    // the time Render() took on the render thread (footprint tracking
+    // included), until it is reset. Called on the render thread, one view
+    // at a time. Used to check the structure of the graph against its
+    // description and a baseline (FPostProcessStructureCheck).
+    using FStructureCallback = TFunction<void(
+        const FPostProcessRenderContext& Context,
+        const FPostProcessStructure& Structure,
+        double RenderMicroseconds
+    )>;
+    void SetStructureCallback(FStructureCallback Callback);
+
+    // Render with the settings of Asset instead of the data asset, until
+    // called again with null. Its textures have to be loaded already.
+    void SetDataAssetOverride(UPostProcessDataAsset* Asset);
+
+    // The data asset the subsystem loads at startup
+    static FSoftObjectPath GetDefaultDataAssetPath();
+
+private:
     //------------------------------------
     // Helpers
     //------------------------------------
@@ -42,8 +367,106 @@ private:
     FRHISamplerState* BilinearRepeatSampler = nullptr;
     FRHISamplerState* NearestRepeatSampler = nullptr;
 
+    // Called once on the render thread before the delegate is bound,
+    // so Render() only ever reads these.
     void InitStates();
 
+    // Precache (or create) all the graphics and compute pipelines. The
+    // precache requests still compiling are added to OutCompileEvents.
+    static void PrecachePipelines(FRHICommandListImmediate& RHICmdList, ERHIFeatureLevel::Type FeatureLevel, FGraphEventArray& OutCompileEvents);
+
+    // Warm-ups queued or compiling, counted from the game thread call
+    // until their pipelines are compiled (see IsWarmingUp). Shared with the
+    // tasks waiting on the compilation, which may outlive the subsystem.
+    TSharedRef<FThreadSafeCounter, ESPMode::ThreadSafe> PendingWarmUps = MakeShared<FThreadSafeCounter, ESPMode::ThreadSafe>();
+
+    // Keeps the effect under r.PrettyPostProcess.Budget (render thread)
+    TSharedPtr<FPostProcessBudgetGovernor> BudgetGovernor;
+
+    // Skips flare and glare on the views too dark for them (render thread)
+    TSharedPtr<FPostProcessAutoSkip> AutoSkip;
+
+    // Reuses the output of the views where nothing moves (render thread)
+    TSharedPtr<FPostProcessStaticCache> StaticCache;
+
+    // Frame whose views capture their footprint (render thread)
+    bool bFootprintRequested = false;
+    uint64 FootprintFrameNumber = MAX_uint64;
+    FCriticalSection FootprintLock;
+
+    bool ShouldCaptureFootprint();
+
+    // Set by SetStructureCallback (render thread, under FootprintLock)
+    FStructureCallback StructureCallback;
+
+    bool ShouldRecordStructure();
+    void RecordStructure(const FPostProcessRenderContext& Context, const FPostProcessFootprint& Footprint, uint64 StartCycles);
+
+    // Captures waiting for a view or for their readback (render thread)
+    TSharedPtr<FPostProcessCaptureRecorder> CaptureRecorder;
+
+    // Counters of the frame being recorded, summed over its views (render thread)
+    FPostProcessViewCounters FrameCounters;
+    uint64 FrameCountersFrameNumber = MAX_uint64;
+    FCriticalSection FrameCountersLock;
+
+    // Add the counters of a view to the stats, CSV profiler and Insights
+    void PublishCounters(const FPostProcessViewCounters& Counters);
+
+    // Tile being rendered, unset outside of a tiled render (render thread)
+    TOptional<FPostProcessTile> Tile;
+    FPostProcessTiledFrame TiledFrame;
+    FCriticalSection TiledFrameLock;
+
+    //------------------------------------
+    // Pass plans
+    //------------------------------------
+    // Plans of the views rendered recently, keyed by view state
+    // (or view rect for views without one). Views can be recorded
+    // in parallel, hence the lock.
+    TMap<uint32, FPostProcessPassPlan> PassPlans;
+    FRWLock PassPlansLock;
+
+    // Return the cached plan of a view, rebuilding it if its key changed
+    FPostProcessPassPlan GetPassPlan(
+        const FViewInfo& View,
+        const FPostProcessSettingsProxy& Settings,
+        const FPostProcessPassPlanKey& Key
+    );
+
+    //------------------------------------
+    // Settings
+    //------------------------------------
+    // Render thread copy of the data asset, replaced when the asset changes
+    TSharedPtr<FPostProcessSettingsProxy, ESPMode::ThreadSafe> SettingsProxy;
+
+    // Snapshot the data asset and hand it over to the render thread
+    void UpdateSettingsProxy();
+
+    //------------------------------------
+    // Asset loading
+    //------------------------------------
+    // The data asset and then its textures are loaded asynchronously.
+    // Until both are resident there is no settings proxy and Render()
+    // leaves the engine bloom untouched.
+    FStreamableManager StreamableManager;
+
+    TSharedPtr<FStreamableHandle> DataAssetHandle;
+
+    // Keeps the textures loaded, replaced once a new set is resident
+    TSharedPtr<FStreamableHandle> TexturesHandle;
+    TSharedPtr<FStreamableHandle> PendingTexturesHandle;
+
+    void OnDataAssetLoaded();
+    void RequestTextures();
+    void OnTexturesLoaded();
+
+#if WITH_EDITOR
+    void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
+
+    FDelegateHandle ObjectPropertyChangedHandle;
+#endif
+
     //------------------------------------
     // Main function
     //------------------------------------
@@ -54,35 +477,80 @@ private:
         FScreenPassTexture& Output
     );
 
-    TArray<FScreenPassTexture> MipMapsDownsample;
-    TArray<FScreenPassTexture> MipMapsUpsample;
+    // Render() as bound to PP_CustomBloomFlare (render thread)
+    FDelegateHandle RenderDelegateHandle;
 
 
     //------------------------------------
     // Bloom
     //------------------------------------
-    FScreenPassTexture RenderBloom(
+    // The bloom is recorded in two halves so that the flare and the glare
+    // can be recorded in between, right after the mips they read. Their
+    // intermediates are then released before the upsample chain allocates.
+    void RenderBloomDownsample(
         FRDGBuilder& GraphBuilder,
+        FPostProcessRenderContext& Context,
         const FViewInfo& View,
-        const FScreenPassTexture& SceneColor,
-        int32 PassAmount
+        const FScreenPassTexture& SceneColor
+    );
+
+    FScreenPassTexture RenderBloomUpsample(
+        FRDGBuilder& GraphBuilder,
+        FPostProcessRenderContext& Context,
+        const FViewInfo& View
     );
 
     FRDGTextureRef RenderDownsample(
         FRDGBuilder& GraphBuilder,
-        const FString& PassName,
+        const FPostProcessRenderContext& Context,
+        FRDGEventName&& PassName,
         const FViewInfo& View,
-        FRDGTextureRef InputTexture,
-        const FIntRect& Viewport
+        const FScreenPassTexture& InputTexture,
+        const FScreenPassTextureViewport& OutputViewport
     );
 
+    // Max luminance per tile of the flare input, so that the flare
+    // and glare passes can skip the dark areas of the screen
+    void RenderTileMax(
+        FRDGBuilder& GraphBuilder,
+        FPostProcessRenderContext& Context,
+        const FViewInfo& View,
+        const FScreenPassTexture& InputTexture
+    );
+
+    // PreviousUVRect is the part of the previous texture under the input
+    // one, all of it except when a tile reads the whole frame bloom.
     FRDGTextureRef RenderUpsampleCombine(
         FRDGBuilder& GraphBuilder,
-        const FString& PassName,
+        const FPostProcessRenderContext& Context,
+        FRDGEventName&& PassName,
         const FViewInfo& View,
         const FScreenPassTexture& InputTexture,
         const FScreenPassTexture& PreviousTexture,
-        float Radius
+        float Radius,
+        const FVector4f& PreviousUVRect = FVector4f(0.0f, 0.0f, 1.0f, 1.0f)
+    );
+
+    // Average luminance of the scene color over a small grid, read back
+    // to notice when a cached view changes
+    FRDGTextureRef RenderSignature(
+        FRDGBuilder& GraphBuilder,
+        const FPostProcessRenderContext& Context,
+        const FViewInfo& View,
+        const FScreenPassTexture& SceneColor
+    );
+
+    //------------------------------------
+    // Tiled render
+    //------------------------------------
+    // Bloom (from TiledFrame.Level down), flare and glare of the whole
+    // frame at reduced resolution, from the prepass of the output frame
+    void RenderTiledLowFrequency(
+        FRDGBuilder& GraphBuilder,
+        const FPostProcessRenderContext& Context,
+        const FViewInfo& View,
+        const FPostProcessPassPlanKey& PlanKey,
+        const FScreenPassTexture& SceneColor
     );
 
     //------------------------------------
@@ -93,65 +561,65 @@ private:
     UPROPERTY(Transient)
     TObjectPtr<UPostProcessDataAsset> PostProcessDataAsset;
 
-    FRDGTextureRef RenderGhosts(
+    // Rendered instead of the data asset when set (SetDataAssetOverride)
+    UPROPERTY(Transient)
+    TObjectPtr<UPostProcessDataAsset> DataAssetOverride;
+
+    FScreenPassTexture RenderGhosts(
         FRDGBuilder& GraphBuilder,
-        const FString& PassName,
+        const FPostProcessRenderContext& Context,
+        const TCHAR* PassName,
         const FViewInfo& View,
-        FRDGTextureRef InputTexture,
-        const FIntRect& Viewport
+        const FScreenPassTexture& InputTexture
     );
 
-    FRDGTextureRef RenderStarburst(
+    FScreenPassTexture RenderStarburst(
         FRDGBuilder& GraphBuilder,
-        const FString& PassName,
-        FRDGTextureRef InputTexture,
-        const FViewInfo& View,
-        const FIntRect& Viewport
+        const FPostProcessRenderContext& Context,
+        const TCHAR* PassName,
+        const FScreenPassTexture& InputTexture,
+        const FViewInfo& View
     );
 
     FRDGTextureRef RenderHalo(
         FRDGBuilder& GraphBuilder,
-        const FString& PassName,
+        const FPostProcessRenderContext& Context,
+        const TCHAR* PassName,
         const FViewInfo& View,
         const FScreenPassTexture& InputTexture
     );
 
     FScreenPassTexture RenderFlarePass(
         FRDGBuilder& GraphBuilder,
+        const FPostProcessRenderContext& Context,
         const FViewInfo& View,
         const FScreenPassTexture& SceneColor
     );
 
     // Sub-pass for flare blurring
-    FRDGTextureRef RenderBlur(
+    FScreenPassTexture RenderBlur(
         FRDGBuilder& GraphBuilder,
-        FRDGTextureRef InputTexture,
-        const FViewInfo& View,
-        const FIntRect& Viewport,
-        int BlurSteps
+        const FPostProcessRenderContext& Context,
+        const FScreenPassTexture& InputTexture,
+        const FViewInfo& View
     );
 
-    // Downsampled texture to be fed by flare
-    FScreenPassTexture DownsampleTextureFlare;
-
     //------------------------------------
     // Glare
     //------------------------------------
 
-    FRDGTextureRef RenderGlare(
+    FScreenPassTexture RenderGlare(
         FRDGBuilder& GraphBuilder,
-        const FString& PassName,
+        const FPostProcessRenderContext& Context,
+        const TCHAR* PassName,
         const FViewInfo& View,
-        FRDGTextureRef InputTexture,
-        const FIntRect& Viewport
+        const FScreenPassTexture& InputTexture
     );
 
     FScreenPassTexture RenderGlarePass(
         FRDGBuilder& GraphBuilder,
+        const FPostProcessRenderContext& Context,
         const FViewInfo& View,
         const FScreenPassTexture& SceneColor
     );
-
-    // Downsampled texture to be fed by flare
-    FScreenPassTexture DownsampleTextureGlare;
 };
@@ -0,0 +1,224 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPostProcessDataAsset;
+
+// CPU implementation of the whole pipeline, without any RHI dependency.
+// Every stage follows its shader (full pipeline, not the reduced mobile
+// one) on planar float images, 4 pixels at a time with VectorRegister and
+// rows (or tiles of rows) spread over the task graph with ParallelFor.
+// Meant for headless reference images, offline tooling and machines
+// without a GPU. Intermediates are 32 bits floats where the GPU uses
+// FP16 or R11G11B10, and the dark areas the tile max map lets the GPU skip
+// are computed anyway, so results match within the precision of those
+// formats rather than bit for bit.
+namespace PrettyPostProcessCPU
+{
+    // Planar RGB image, rows top to bottom. Rows are padded to a multiple
+    // of 4 pixels so that every stage can write whole vectors.
+    struct PRETTYPOSTPROCESS_API FImage
+    {
+        FImage() = default;
+        FImage(int32 InWidth, int32 InHeight);
+
+        // Resize to black
+        void Init(int32 InWidth, int32 InHeight);
+
+        bool IsValid() const { return Width > 0 && Height > 0; }
+        FIntPoint GetSize() const { return FIntPoint(Width, Height); }
+        int32 GetStride() const { return Stride; }
+
+        float* GetRow(int32 Channel, int32 Y) { return Planes[Channel].GetData() + Y * Stride; }
+        const float* GetRow(int32 Channel, int32 Y) const { return Planes[Channel].GetData() + Y * Stride; }
+
+        FLinearColor GetPixel(int32 X, int32 Y) const;
+        void SetPixel(int32 X, int32 Y, const FLinearColor& Color);
+
+        int32 Width = 0;
+        int32 Height = 0;
+
+    private:
+        int32 Stride = 0;
+        TArray<float, TAlignedHeapAllocator<16>> Planes[3];
+    };
+
+    // Data asset settings, as the shaders see them
+    struct PRETTYPOSTPROCESS_API FSettings
+    {
+        float FlareIntensity = 0.0f;
+        FLinearColor FlareTint = FLinearColor::Black;
+        int32 BlurSteps = 0;
+
+        float GhostIntensity = 0.0f;
+        float GhostChromaShift = 0.0f;
+
+        // Visible ghosts only, packed like the settings buffer (at most 8)
+        TArray<FLinearColor> GhostColors;
+        TArray<float> GhostScales;
+
+        float HaloIntensity = 0.0f;
+        float HaloWidth = 0.0f;
+        float HaloMask = 0.0f;
+        float HaloCompression = 1.0f;
+        float HaloChromaShift = 0.0f;
+
+        float StarburstIntensity = 0.0f;
+
+        float GlareIntensity = 0.0f;
+        float GlareDivider = 1.0f;
+        FVector3f GlareScales = FVector3f::ZeroVector;
+        FLinearColor GlareTint = FLinearColor::Black;
+
+        // Textures of the asset, white when not set. Left to the caller
+        // (cooked textures can't be read back on the CPU).
+        FImage FlareGradient;
+        FImage StarburstNoise;
+        FImage GlareLineMask;
+
+        // Same values the settings proxy uploads, without the textures
+        static FSettings FromDataAsset(const UPostProcessDataAsset& Asset);
+    };
+
+    // What Render() reads from the console variables and quality preset
+    struct PRETTYPOSTPROCESS_API FPipelineOptions
+    {
+        // Size of the full resolution view the pass amount is limited by,
+        // twice the input when zero (the engine hands over half resolution)
+        FIntPoint ViewSize = FIntPoint::ZeroValue;
+
+        // r.PrettyPostProcess.BloomPassAmount, BloomResLimit and BloomRadius
+        int32 BloomPassAmount = 7;
+        int32 BloomResLimit = 16;
+        float BloomRadius = 0.85f;
+
+        // r.PrettyPostProcess.RenderFlare, RenderHalo and RenderGlare
+        bool bRenderFlare = true;
+        bool bRenderHalo = true;
+        bool bRenderGlare = true;
+
+        // Quality preset (Epic by default)
+        int32 MaxBlurSteps = 8;
+        int32 MaxGhostCount = 8;
+        int32 GlareTileSize = 2;
+        int32 FlareMip = 0;
+    };
+
+    // Result of Render(), with the stages that went into the mix
+    // (invalid when a stage didn't run)
+    struct PRETTYPOSTPROCESS_API FPipelineOutput
+    {
+        FImage Mix;
+        FImage Bloom;
+        FImage Flare;
+        FImage Glare;
+        int32 PassAmount = 0;
+    };
+
+    // What a call to Glare() drew
+    struct PRETTYPOSTPROCESS_API FGlareStats
+    {
+        int32 Tiles = 0;
+        int32 Quads = 0;
+
+        // Pixels inside a quad, each reads the line mask once
+        int64 CoveredPixels = 0;
+    };
+
+    // Cost of one stage of Render()
+    struct PRETTYPOSTPROCESS_API FStageStats
+    {
+        FString Name;
+        double Milliseconds = 0.0;
+
+        // Pixels written
+        int64 Pixels = 0;
+
+        // Bilinear fetches the shader issues (4 texels each)
+        int64 Fetches = 0;
+
+        // Primitives drawn (glare quads)
+        int64 Primitives = 0;
+
+        // Size of the output image
+        FIntPoint OutputSize = FIntPoint::ZeroValue;
+    };
+
+    struct PRETTYPOSTPROCESS_API FPipelineStats
+    {
+        // In execution order
+        TArray<FStageStats> Stages;
+    };
+
+    //------------------------------------
+    // Stages
+    //------------------------------------
+    // Output images have to be sized beforehand (Init), they are overwritten.
+
+    // Bilinear resize, to bring captures to a given resolution
+    PRETTYPOSTPROCESS_API void Resample(const FImage& Input, FImage& Output);
+
+    // 13 taps downsample (DownsamplePS)
+    PRETTYPOSTPROCESS_API void Downsample(const FImage& Input, FImage& Output);
+
+    // Tent upsample of Previous blended over Current (UpsampleCombinePS),
+    // Output is the size of Current
+    PRETTYPOSTPROCESS_API void UpsampleCombine(const FImage& Current, const FImage& Previous, float Radius, FImage& Output);
+
+    // Dual Kawase blur steps (KawaseBlurDownsamplePS, KawaseBlurUpsamplePS)
+    PRETTYPOSTPROCESS_API void KawaseBlurDownsample(const FImage& Input, FImage& Output);
+    PRETTYPOSTPROCESS_API void KawaseBlurUpsample(const FImage& Input, FImage& Output);
+
+    // Flare ghosts with chroma shift (GhostsPS), GhostCount first ghosts
+    PRETTYPOSTPROCESS_API void Ghosts(const FImage& Input, const FSettings& Settings, int32 GhostCount, FImage& Output);
+
+    // Starburst filter over the blurred ghosts (StarburstPS)
+    PRETTYPOSTPROCESS_API void Starburst(const FImage& Input, const FSettings& Settings, FImage& Output);
+
+    // Fisheye halo (HaloPS)
+    PRETTYPOSTPROCESS_API void Halo(const FImage& Input, const FSettings& Settings, FImage& Output);
+
+    // Rows the glare rasterizes together, each band is a task
+    constexpr int32 GlareBandHeight = 16;
+
+    // Sprite glare: three rotated quads per bright tile of TileSize pixels,
+    // added together (GlareVS, GlareGS and GlarePS). Output is resized to
+    // the input. The result doesn't depend on BandHeight.
+    PRETTYPOSTPROCESS_API void Glare(
+        const FImage& Input,
+        const FSettings& Settings,
+        int32 TileSize,
+        FImage& Output,
+        FGlareStats* OutStats = nullptr,
+        int32 BandHeight = GlareBandHeight
+    );
+
+    // Final composite (MixPS), Bloom, Flare and Glare can be invalid
+    PRETTYPOSTPROCESS_API void Mix(
+        const FImage& Bloom,
+        float BloomIntensity,
+        const FImage& Flare,
+        const FImage& Glare,
+        const FSettings& Settings,
+        FImage& Output
+    );
+
+    //------------------------------------
+    // Pipeline
+    //------------------------------------
+    // Number of bloom levels Render() goes through, like the pass plan
+    PRETTYPOSTPROCESS_API int32 GetPassAmount(const FIntPoint& InputSize, const FPipelineOptions& Options);
+
+    // Every stage in the order of UPostProcessSubsystem::Render(), from the
+    // (half resolution) scene color the engine hands over. Each stage is
+    // timed and measured into OutStats when given.
+    PRETTYPOSTPROCESS_API void Render(
+        const FImage& SceneColor,
+        const FSettings& Settings,
+        const FPipelineOptions& Options,
+        FPipelineOutput& Output,
+        FPipelineStats* OutStats = nullptr
+    );
+}
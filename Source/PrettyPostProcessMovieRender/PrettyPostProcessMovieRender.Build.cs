@@ -0,0 +1,31 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class PrettyPostProcessMovieRender : ModuleRules
+{
+	public PrettyPostProcessMovieRender(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine",
+				// Deferred render pass the tiles go through
+				"MovieRenderPipelineCore",
+				"MovieRenderPipelineRenderPasses"
+			}
+			);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"RenderCore",
+				"PrettyPostProcess"
+			}
+			);
+	}
+}
@@ -0,0 +1,84 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "MoviePipelinePrettyPostProcessPass.h"
+#include "PostProcessSubsystem.h"
+#include "Engine/Engine.h"
+
+#define LOCTEXT_NAMESPACE "MoviePipelinePrettyPostProcessPass"
+
+#if WITH_EDITOR
+FText UMoviePipelinePrettyPostProcessPass::GetDisplayText() const
+{
+    return LOCTEXT("DisplayText", "Deferred Rendering (Pretty Post Process Tiling)");
+}
+#endif
+
+void UMoviePipelinePrettyPostProcessPass::RenderSample_GameThreadImpl(const FMoviePipelineRenderPassMetrics& InSampleState)
+{
+    UPostProcessSubsystem* Subsystem = GEngine != nullptr ? GEngine->GetEngineSubsystem<UPostProcessSubsystem>() : nullptr;
+
+    // Untiled renders go through the plugin as usual
+    if (Subsystem == nullptr || InSampleState.TileCounts == FIntPoint(1, 1))
+    {
+        Super::RenderSample_GameThreadImpl(InSampleState);
+        return;
+    }
+
+    const FIntPoint FrameSize = InSampleState.TileSize * InSampleState.TileCounts;
+
+    if (FrameSize != TiledFrameSize)
+    {
+        Subsystem->BeginTiledRender(FrameSize);
+        TiledFrameSize = FrameSize;
+    }
+
+    // Tiles are looped over inside each temporal sample, so the first
+    // tile comes first for every sub-frame the tiles blend
+    if (InSampleState.TileIndexes == FIntPoint::ZeroValue && InSampleState.SpatialSampleIndex == 0)
+    {
+        // The whole frame, fitted in the backbuffer of a tile, only seen
+        // by the plugin
+        const float Scale = FMath::Min(
+            float(InSampleState.BackbufferSize.X) / FrameSize.X,
+            float(InSampleState.BackbufferSize.Y) / FrameSize.Y
+        );
+
+        FMoviePipelineRenderPassMetrics FrameState = InSampleState;
+        FrameState.TileCounts = FIntPoint(1, 1);
+        FrameState.TileIndexes = FIntPoint::ZeroValue;
+        FrameState.OverlappedPad = FIntPoint::ZeroValue;
+        FrameState.BackbufferSize = FIntPoint(
+            FMath::Max(FMath::FloorToInt(FrameSize.X * Scale), 1),
+            FMath::Max(FMath::FloorToInt(FrameSize.Y * Scale), 1)
+        );
+        FrameState.TileSize = FrameState.BackbufferSize;
+        FrameState.bDiscardResult = true;
+        FrameState.bWriteSampleToDisk = false;
+
+        Subsystem->SetRenderFrame();
+        Super::RenderSample_GameThreadImpl(FrameState);
+    }
+
+    // Rect of the tile in the frame, overlap included
+    const FIntPoint TileMin = InSampleState.TileIndexes * InSampleState.TileSize - InSampleState.OverlappedPad;
+    Subsystem->SetRenderTile(FIntRect(TileMin, TileMin + InSampleState.BackbufferSize));
+
+    Super::RenderSample_GameThreadImpl(InSampleState);
+}
+
+void UMoviePipelinePrettyPostProcessPass::TeardownImpl()
+{
+    if (TiledFrameSize != FIntPoint::ZeroValue)
+    {
+        if (UPostProcessSubsystem* Subsystem = GEngine != nullptr ? GEngine->GetEngineSubsystem<UPostProcessSubsystem>() : nullptr)
+        {
+            Subsystem->EndTiledRender();
+        }
+
+        TiledFrameSize = FIntPoint::ZeroValue;
+    }
+
+    Super::TeardownImpl();
+}
+
+#undef LOCTEXT_NAMESPACE
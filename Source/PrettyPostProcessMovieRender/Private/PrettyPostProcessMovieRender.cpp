@@ -0,0 +1,5 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, PrettyPostProcessMovieRender)
@@ -0,0 +1,34 @@
+// Copyright 2022 Escape Entertainment & Froyok
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoviePipelineDeferredPasses.h"
+#include "MoviePipelinePrettyPostProcessPass.generated.h"
+
+// Deferred rendering pass of Movie Render Queue that renders tiled frames
+// without seams in the plugin's bloom, flare, halo and glare. Use it in
+// place of "Deferred Rendering" when High Resolution tiling is on.
+//
+// Before the first tile of every output frame (and temporal sample), the
+// whole frame is rendered once at the resolution of a tile and discarded:
+// the plugin computes its low frequency stages from it, then each tile
+// reads its part of them (see UPostProcessSubsystem::BeginTiledRender).
+UCLASS(BlueprintType)
+class PRETTYPOSTPROCESSMOVIERENDER_API UMoviePipelinePrettyPostProcessPass : public UMoviePipelineDeferredPassBase
+{
+    GENERATED_BODY()
+
+public:
+#if WITH_EDITOR
+    virtual FText GetDisplayText() const override;
+#endif
+
+protected:
+    virtual void RenderSample_GameThreadImpl(const FMoviePipelineRenderPassMetrics& InSampleState) override;
+    virtual void TeardownImpl() override;
+
+private:
+    // Frame size the subsystem was set up for, zero outside of a tiled render
+    FIntPoint TiledFrameSize = FIntPoint::ZeroValue;
+};